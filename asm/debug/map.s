@@ -10,8 +10,15 @@ glabel gMapStrings
 .incbin "bin/name.bin"
 glabel gMapStringsEnd
 
+.balign 16
+glabel gMapIndex
+.incbin "bin/index.bin"
+glabel gMapIndexEnd
+
 .balign 16
 glabel gMapEntrySize
-.word (gMapEntryEnd - gMapEntries) / 4
+.word (gMapEntryEnd - gMapEntries) / 16
 glabel gMapStringSize
 .word (gMapStringsEnd - gMapStrings)
+glabel gMapIndexSize
+.word (gMapIndexEnd - gMapIndex) / 4
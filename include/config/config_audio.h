@@ -45,8 +45,47 @@
 #define MAX_SIMULTANEOUS_NOTES_EMULATOR 40
 #define MAX_SIMULTANEOUS_NOTES_CONSOLE 24
 
+/**
+ * Lets the number of notes that can play at once follow how long the audio thread takes each frame (US/JP only).
+ * While its average time is over ADAPTIVE_POLYPHONY_TARGET_US microseconds, fewer notes are allowed, down to
+ * ADAPTIVE_POLYPHONY_MIN_NOTES, and new notes take over decaying or lower priority ones as they do when every note is in use.
+ * Once it is back under three quarters of that, more notes are allowed again, up to the maximum above.
+ */
+// #define ADAPTIVE_POLYPHONY
+#define ADAPTIVE_POLYPHONY_MIN_NOTES 12
+#define ADAPTIVE_POLYPHONY_TARGET_US 3000
+
+/**
+ * Streamed samples are loaded from ROM into buffers in the notes and buffers pool, as needed while they play (not supported for SH).
+ * The start of each note goes into a start buffer, which is kept for a second so that notes playing the same sample can share it,
+ * and the rest into stream buffers, which are reused after two frames. These set how many of each are allocated per note and their
+ * size in bytes (a multiple of 16, at most 0x800). More or larger buffers mean fewer DMAs, at the cost of audio heap.
+ * Every note's buffers together must number at most 255.
+ */
+#define SAMPLE_DMA_STREAM_BUFS_PER_NOTE 3
+#define SAMPLE_DMA_STREAM_BUF_SIZE (144 * 9)
+#define SAMPLE_DMA_START_BUFS_PER_NOTE 1
+#define SAMPLE_DMA_START_BUF_SIZE (160 * 9)
+
+/**
+ * Keeps the samples of the current level's music and sound effects in RAM, in a pool of this many bytes, so that they
+ * don't have to be streamed from ROM while they play (US/JP only). The samples are listed per level by assemble_sound.py
+ * from the music set in each level's script, and loaded in order, music first, until the pool is full; the rest are
+ * streamed as usual. The pool is set aside once at boot, and refilled when sound is reset for a different level than
+ * the one it holds, which briefly stalls the game. Music changes and area changes within a level don't reload it.
+ * SAMPLE_RESIDENCY_POOL_SIZE is set with the Makefile option of the same name (e.g. make SAMPLE_RESIDENCY_POOL_SIZE=0x40000),
+ * since the build has to make the list of samples along with it.
+ */
+
 /** 
  * Uses a much better implementation of reverb over vanilla's fake echo reverb. Great for caves or eerie levels, as well as just a better audio experience in general.
  * Reverb presets can be configured in audio/data.c to meet desired aesthetic/performance needs. More detailed usage info can also be found on the HackerSM64 Wiki page.
  */
 // #define BETTER_REVERB
+
+/**
+ * Has BETTER_REVERB scale by its gain and reverb indices with two shifts each instead of a multiply, which is cheaper on console.
+ * Each index is rounded down to its two highest set bits, so presets sound nearly the same but the output is no longer exact.
+ * Lightweight presets are not affected.
+ */
+// #define BETTER_REVERB_REDUCED_PRECISION
@@ -34,3 +34,34 @@
  */
 #define COLLISION_DATA_TYPE s16
 #define ROOM_DATA_TYPE s8
+
+/**
+ * Static collision cells with more than this many floors, ceilings and walls are split into
+ * STATIC_SURFACE_SUBCELLS x STATIC_SURFACE_SUBCELLS smaller cells when the area's terrain is loaded.
+ * This shortens the surface lists that need to be walked in dense parts of large levels, at the cost of some extra static surface pool memory.
+ * Comment out STATIC_SURFACE_SUBDIVISION_THRESHOLD to always use the uniform grid.
+ */
+#define STATIC_SURFACE_SUBDIVISION_THRESHOLD 48
+#define STATIC_SURFACE_SUBCELLS 4
+
+/**
+ * Rearranges the static surface pool once an area's terrain has been loaded, so that each cell's surface list
+ * is stored as one contiguous run of nodes, and the surfaces they point to are stored in the order the cells reference them.
+ * Walking a static cell then reads memory linearly instead of jumping around the pool, which is much kinder to the data cache.
+ * Requires enough free main pool space to hold a second copy of the static surface pool while loading, otherwise it's skipped.
+ */
+#define COMPACT_STATIC_SURFACES
+
+/**
+ * Reuses the transformed collision of objects that haven't moved, rotated or scaled since the previous frame,
+ * instead of transforming their vertices and rebuilding their surfaces every frame. Their surfaces are still relinked into the cells.
+ * DYNAMIC_SURFACE_CACHE_SIZE is the number of collision objects per frame that can be tracked. Objects past that limit are always rebuilt.
+ */
+#define CACHE_DYNAMIC_SURFACES
+#define DYNAMIC_SURFACE_CACHE_SIZE 64
+
+/**
+ * Sorts collidable objects into a coarse grid each frame, so object-object collision checks only compare objects that are near each other,
+ * instead of comparing every object against entire object lists. Objects are still checked in the same order, so interactions are unchanged.
+ */
+#define OBJECT_COLLISION_BROADPHASE
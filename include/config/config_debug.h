@@ -24,6 +24,34 @@
  */
 #define USE_PROFILER
 
+/**
+ * Enables a sampling profiler for the game thread. It records the game thread's PC and call stack SAMPLING_PROFILER_HZ times a second
+ * into a ring buffer of the last SAMPLING_PROFILER_NUM_SAMPLES samples. Press L + D-Pad Down to print a flat profile and collapsed stacks over USB,
+ * then run tools/sampling_profile.py on the log to get flamegraph-compatible text.
+ * Requires building with UNF=1. Function names come from the debug map, otherwise every frame shows as "?".
+ */
+// #define SAMPLING_PROFILER
+#define SAMPLING_PROFILER_HZ 500
+#define SAMPLING_PROFILER_NUM_SAMPLES 1024
+#define SAMPLING_PROFILER_STACK_DEPTH 6
+
+/**
+ * Records the start and end of every profiler event (game thread timers, audio, RSP tasks and the RDP) for the last
+ * PROFILER_TIMELINE_FRAMES frames. When a frame takes longer than PROFILER_TIMELINE_THRESHOLD_US microseconds, the timeline
+ * leading up to it is printed over USB. Run tools/profiler_timeline.py on the log to get a Chrome trace that can be opened
+ * in chrome://tracing or ui.perfetto.dev. Requires USE_PROFILER and building with UNF=1.
+ */
+// #define PROFILER_TIMELINE
+#define PROFILER_TIMELINE_FRAMES 8
+#define PROFILER_TIMELINE_THRESHOLD_US 40000
+
+/**
+ * Tracks how much of the gfx pool every frame uses (commands, alloc_display_list allocations and matrices), and how many display lists
+ * each layer draws, as the minimum, average and maximum since boot. Shown on the "Gfx Pool" puppyprint page, and printed over USB when
+ * building with UNF=1 by pressing L + D-Pad Right. Use this to size GFX_POOL_SIZE.
+ */
+// #define GFX_POOL_STATS
+
 /**
  * -- TEST LEVEL --
  * Uncomment this define and set a test level in order to boot straight into said level.
@@ -52,6 +80,12 @@
  */
 // #define PUPPYPRINT_DEBUG_CYCLES
 
+/**
+ * Times every object update, and adds a Puppyprint page listing the behaviors that take the most time per frame,
+ * including how much of it was spent in native functions rather than interpreting behavior commands. Requires PUPPYPRINT_DEBUG.
+ */
+// #define BEHAVIOR_PROFILER
+
 /**
  * A vanilla style debug mode. It doesn't rely on a text engine, but it's much less powerful that PUPPYPRINT_DEBUG.
  * Press D-pad left to show the debug UI.
@@ -9,6 +9,12 @@
  */
 #define GFX_POOL_SIZE 10000
 
+/**
+ * How much of the GFX pool (in commands) the scene always leaves free for the HUD, text and menus drawn after it.
+ * Layers that would run into it are skipped for that frame instead of overflowing the pool.
+ */
+#define GFX_POOL_RESERVE 512
+
 /**
  * Causes the global light direction to be in world space,
  * this allows you to have a singular light source that doesn't change with the camera's rotation.
@@ -140,6 +146,21 @@
  */
 #define DEFAULT_CULLING_RADIUS 300
 
+/**
+ * Shares the decoded pose of an animation frame, including the rotation of each part, between every object
+ * playing that animation on the same frame, so crowds of the same enemy only do the parent matrix multiply.
+ * The value is the size of the cache in bytes. When it fills up for a frame, poses are decoded per object as usual.
+ */
+#define ANIMATION_POSE_CACHE 0x4000
+
+/**
+ * Keeps recently used Mario animations in RAM, so changing animation only loads from ROM when the animation isn't cached.
+ * Animations that usually come next in Mario's current action group are loaded ahead of time in the background.
+ * The value is the size of the cache in bytes. It replaces the 16KB buffer Mario's animations are normally loaded into,
+ * and must fit the largest animation (about 13KB for the vanilla ones).
+ */
+// #define MARIO_ANIM_CACHE 0x10000
+
 /**
  * Eases the textured screen transitions to make them look smoother. 
  * Extends the full radius for mario, bowser and the star transitions.
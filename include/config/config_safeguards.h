@@ -45,10 +45,41 @@
     #define MAX_SIMULTANEOUS_NOTES 0
 #endif
 
+#if defined(ADAPTIVE_POLYPHONY) && !(defined(VERSION_US) || defined(VERSION_JP))
+    #undef ADAPTIVE_POLYPHONY
+#endif
+#ifndef ADAPTIVE_POLYPHONY_MIN_NOTES
+    #define ADAPTIVE_POLYPHONY_MIN_NOTES 12
+#endif
+#ifndef ADAPTIVE_POLYPHONY_TARGET_US
+    #define ADAPTIVE_POLYPHONY_TARGET_US 3000
+#endif
+
+#ifndef SAMPLE_DMA_STREAM_BUFS_PER_NOTE
+    #define SAMPLE_DMA_STREAM_BUFS_PER_NOTE 3
+#endif
+#ifndef SAMPLE_DMA_STREAM_BUF_SIZE
+    #define SAMPLE_DMA_STREAM_BUF_SIZE (144 * 9)
+#endif
+#ifndef SAMPLE_DMA_START_BUFS_PER_NOTE
+    #define SAMPLE_DMA_START_BUFS_PER_NOTE 1
+#endif
+#ifndef SAMPLE_DMA_START_BUF_SIZE
+    #define SAMPLE_DMA_START_BUF_SIZE (160 * 9)
+#endif
+
+#if defined(SAMPLE_RESIDENCY_POOL_SIZE) && !(defined(VERSION_US) || defined(VERSION_JP))
+    #undef SAMPLE_RESIDENCY_POOL_SIZE
+#endif
+
 #if defined(BETTER_REVERB) && !(defined(VERSION_US) || defined(VERSION_JP))
     #undef BETTER_REVERB
 #endif
 
+#ifndef BETTER_REVERB
+    #undef BETTER_REVERB_REDUCED_PRECISION
+#endif
+
 /*****************
  * config_debug.h
  */
@@ -56,6 +87,9 @@
 #ifdef DISABLE_ALL
     #undef DEBUG_ALL
     #undef USE_PROFILER
+    #undef SAMPLING_PROFILER
+    #undef PROFILER_TIMELINE
+    #undef GFX_POOL_STATS
     #undef TEST_LEVEL
     #undef DEBUG_LEVEL_SELECT
     #undef ENABLE_DEBUG_FREE_MOVE
@@ -105,8 +139,20 @@
     #define PUPPYPRINT
     #undef USE_PROFILER
     #define USE_PROFILER
+#else
+    #undef BEHAVIOR_PROFILER
 #endif // PUPPYPRINT_DEBUG
 
+// The sampling profiler can only print its results over USB.
+#ifndef UNF
+    #undef SAMPLING_PROFILER
+#endif // !UNF
+
+// The profiler timeline is recorded by the profiler and can only be printed over USB.
+#if !defined(USE_PROFILER) || !defined(UNF)
+    #undef PROFILER_TIMELINE
+#endif // !USE_PROFILER || !UNF
+
 #ifdef COMPLETE_SAVE_FILE
     #undef UNLOCK_ALL
     #define UNLOCK_ALL
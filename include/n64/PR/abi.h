@@ -231,11 +231,13 @@ typedef struct {
 
 /*
  * Generic Acmd Packet
+ * Commands are 64 bits on every target, so the audio code only runs on a 64-bit
+ * host if everything the commands point at is in the low 4 GB.
  */
 
 typedef struct {
-    uintptr_t w0;
-    uintptr_t w1;
+    unsigned int w0;
+    unsigned int w1;
 } Awords;
 
 typedef union {
@@ -209,7 +209,7 @@ struct Animation {
     /*0x04*/ s16 startFrame;
     /*0x06*/ s16 loopStart;
     /*0x08*/ s16 loopEnd;
-    /*0x0A*/ s16 unusedBoneCount;
+    /*0x0A*/ s16 numParts;
     /*0x0C*/ const s16 *values;
     /*0x10*/ const u16 *index;
     /*0x14*/ u32 length; // only used with Mario animations to determine how much to load. 0 otherwise.
@@ -349,12 +349,16 @@ struct Surface {
     /*0x05*/ RoomData room;
     /*0x06*/ s16 lowerY;
     /*0x08*/ s16 upperY;
-    /*0x0A*/ Vec3t vertex1;
-    /*0x10*/ Vec3t vertex2;
-    /*0x16*/ Vec3t vertex3;
-    /*0x1C*/ struct Normal normal;
-    /*0x28*/ f32 originOffset;
-    /*0x2C*/ struct Object *object;
+    /*0x0A*/ s16 minX;
+    /*0x0C*/ s16 maxX;
+    /*0x0E*/ s16 minZ;
+    /*0x10*/ s16 maxZ;
+    /*0x12*/ Vec3t vertex1;
+    /*0x18*/ Vec3t vertex2;
+    /*0x1E*/ Vec3t vertex3;
+    /*0x24*/ struct Normal normal;
+    /*0x30*/ f32 originOffset;
+    /*0x34*/ struct Object *object;
 };
 
 #define PUNCH_STATE_TIMER_MASK          0b00111111
@@ -0,0 +1,180 @@
+// BETTER_REVERB's filters and the state they run on. Included by synthesis.c, and by
+// tools/reverbbench.c to time them on the host and check them against the per-sample version.
+
+static s32         reverbMults[SYNTH_CHANNEL_STEREO_COUNT][NUM_ALLPASS / 3] = {0};
+static s32          allpassIdx[SYNTH_CHANNEL_STEREO_COUNT][NUM_ALLPASS] = {0};
+static s32  betterReverbDelays[SYNTH_CHANNEL_STEREO_COUNT][NUM_ALLPASS] = {0};
+static s32 historySamplesLight[SYNTH_CHANNEL_STEREO_COUNT];
+static s16         **delayBufs[SYNTH_CHANNEL_STEREO_COUNT];
+
+// betterReverbGainIndex and betterReverbRevIndex as two right shifts each, for BETTER_REVERB_REDUCED_PRECISION.
+static s32 reverbGainShifts[2];
+static s32 reverbRevShifts[2];
+
+// Splits an index (in 256ths) into the two largest powers of two it contains. An index that is a single power of
+// two is split into two halves of it, so that both shifts can always be applied.
+static void split_reverb_index(s32 index, s32 *shifts) {
+    s32 high = 7;
+    s32 low;
+
+    index = CLAMP(index, 0, 0xFF);
+    if (index == 0) {
+        shifts[0] = shifts[1] = 31;
+        return;
+    }
+
+    while (!(index & (1 << high))) {
+        high--;
+    }
+    low = index & ((1 << high) - 1);
+
+    if (low == 0) {
+        shifts[0] = shifts[1] = 9 - high;
+    } else {
+        shifts[0] = 8 - high;
+        for (high--; !(low & (1 << high)); high--);
+        shifts[1] = 8 - high;
+    }
+}
+
+static void set_reverb_index_shifts(void) {
+    split_reverb_index(betterReverbGainIndex, reverbGainShifts);
+    split_reverb_index(betterReverbRevIndex, reverbRevShifts);
+}
+
+// Scales x by an index in 256ths, or by its approximation as two shifts.
+#define REVERB_SCALE(x, index, shifts) \
+    (reducedPrecision ? (((x) >> (shifts)[0]) + ((x) >> (shifts)[1])) : (((x) * (index)) >> 8))
+
+// Runs each filter over a block of samples before moving on to the next one, so that every delay line is walked
+// through in order with its position kept in a register, rather than all of them being visited for each sample.
+// The first filter is fed what the last filter wrote a full delay ago, so as long as a block is no longer than that
+// delay, the output is exactly the same as processing one sample at a time.
+static ALWAYS_INLINE void reverb_samples_blocks(s16 *start, s16 *end, s16 *downsampleBuffer, s32 channel, s32 reducedPrecision) {
+    s32 carryovers[BETTER_REVERB_BLOCK_SIZE];
+    s32 outSampleTotals[BETTER_REVERB_BLOCK_SIZE];
+    s16 *delayBuf;
+    s32 delay;
+    s32 idx;
+    s32 blockLen;
+    s32 runLen;
+    s32 i;
+    s32 j;
+    s32 n;
+
+    s32 downsampleIncrement = gReverbDownsampleRate;
+    s32 *delaysLocal = betterReverbDelays[channel];
+    s32 *reverbMultsLocal = reverbMults[channel];
+    s32 *allpassIdxLocal = allpassIdx[channel];
+    s16 **delayBufsLocal = delayBufs[channel];
+
+    s32 lastFilterIndex = reverbLastFilterIndex;
+    s32 revIndex = betterReverbRevIndex;
+    s32 gainIndex = betterReverbGainIndex;
+    s32 maxBlockLen = MIN(BETTER_REVERB_BLOCK_SIZE, delaysLocal[lastFilterIndex]);
+
+    for (; start < end; start += blockLen) {
+        blockLen = MIN(maxBlockLen, end - start);
+
+        // Mix the very last filter output with new incoming samples
+        delayBuf = delayBufsLocal[lastFilterIndex];
+        delay = delaysLocal[lastFilterIndex];
+        idx = allpassIdxLocal[lastFilterIndex];
+        for (n = 0; n < blockLen; n++, downsampleBuffer += downsampleIncrement) {
+            carryovers[n] = REVERB_SCALE(delayBuf[idx], revIndex, reverbRevShifts) + *downsampleBuffer;
+            outSampleTotals[n] = 0;
+            if (++idx == delay) idx = 0;
+        }
+
+        for (i = 0; i <= lastFilterIndex; i++) {
+            delayBuf = delayBufsLocal[i];
+            delay = delaysLocal[i];
+            idx = allpassIdxLocal[i];
+
+            // Each run stops where the delay line wraps, so the loops themselves never have to check for it
+            for (n = 0; n < blockLen; n += runLen) {
+                s16 *curDelaySample = &delayBuf[idx];
+                s32 *carryover = &carryovers[n];
+
+                runLen = MIN(blockLen - n, delay - idx);
+                idx += runLen;
+                if (idx == delay) idx = 0;
+
+                if (i % 3 == 2) {
+                    // The last filter of each group adds to the output and feeds its history into the next group
+                    s32 reverbMult = reverbMultsLocal[i / 3];
+                    s32 *outSampleTotal = &outSampleTotals[n];
+
+                    for (j = 0; j < runLen; j++) {
+                        s32 historySample = curDelaySample[j];
+
+                        outSampleTotal[j] += (historySample * reverbMult) >> 8;
+                        curDelaySample[j] = CLAMP_S16(carryover[j]);
+                        carryover[j] = REVERB_SCALE(historySample, revIndex, reverbRevShifts);
+                    }
+                } else {
+                    for (j = 0; j < runLen; j++) {
+                        s32 historySample = curDelaySample[j];
+                        s32 tmpCarryover = carryover[j] + REVERB_SCALE(-historySample, gainIndex, reverbGainShifts);
+
+                        curDelaySample[j] = CLAMP_S16(tmpCarryover);
+                        carryover[j] = REVERB_SCALE(tmpCarryover, gainIndex, reverbGainShifts) + historySample;
+                    }
+                }
+            }
+
+            allpassIdxLocal[i] = idx;
+        }
+
+        for (n = 0; n < blockLen; n++) {
+            start[n] = CLAMP_S16(outSampleTotals[n]);
+        }
+    }
+}
+
+#undef REVERB_SCALE
+
+static void reverb_samples(s16 *start, s16 *end, s16 *downsampleBuffer, s32 channel) {
+#ifdef BETTER_REVERB_REDUCED_PRECISION
+    reverb_samples_blocks(start, end, downsampleBuffer, channel, TRUE);
+#else
+    reverb_samples_blocks(start, end, downsampleBuffer, channel, FALSE);
+#endif
+}
+
+static void reverb_samples_light(s16 *start, s16 *end, s16 *downsampleBuffer, s32 channel) {
+    s16 *curDelaySample;
+    s32 historySample;
+    s32 tmpCarryover;
+    s32 i;
+
+    s32 downsampleIncrement = gReverbDownsampleRate;
+    s32 *delaysLocal = betterReverbDelays[channel];
+    s32 *allpassIdxLocal = allpassIdx[channel];
+    s16 **delayBufsLocal = delayBufs[channel];
+
+    // Get history sample from last processing tick
+    tmpCarryover = historySamplesLight[channel];
+
+    for (; start < end; start++, downsampleBuffer += downsampleIncrement) {
+        // Mix previous sample with new incoming sample
+        tmpCarryover = ((tmpCarryover * BETTER_REVERB_REVERB_INDEX_LIGHT) >> 8) + *downsampleBuffer;
+
+        for (i = 0; i < BETTER_REVERB_FILTER_COUNT_LIGHT; ++i) {
+            curDelaySample = &delayBufsLocal[i][allpassIdxLocal[i]];
+            historySample = *curDelaySample;
+
+            tmpCarryover += ((historySample * (-BETTER_REVERB_GAIN_INDEX_LIGHT)) >> 8);
+            *curDelaySample = CLAMP_S16(tmpCarryover);
+            tmpCarryover = ((tmpCarryover * BETTER_REVERB_GAIN_INDEX_LIGHT) >> 8) + historySample;
+
+            if (++allpassIdxLocal[i] == delaysLocal[i]) allpassIdxLocal[i] = 0;
+        }
+
+        // Lightweight does not use the final filter type at all, unlike standard reverb processing
+        *start = CLAMP_S16(tmpCarryover);
+    }
+
+    // Copy history sample to temporary buffer for processing next tick
+    historySamplesLight[channel] = tmpCarryover;
+}
@@ -17,9 +17,11 @@
 #define DMA_BUF_SIZE_0 0x400
 #define DMA_BUF_SIZE_1 0x200
 #else
-#define DMA_BUF_SIZE_0 (144 * 9)
-#define DMA_BUF_SIZE_1 (160 * 9)
+#define DMA_BUF_SIZE_0 SAMPLE_DMA_STREAM_BUF_SIZE
+#define DMA_BUF_SIZE_1 SAMPLE_DMA_START_BUF_SIZE
 #endif
+#define DMA_BUFS_PER_NOTE_0 SAMPLE_DMA_STREAM_BUFS_PER_NOTE
+#define DMA_BUFS_PER_NOTE_1 SAMPLE_DMA_START_BUFS_PER_NOTE
 
 #ifdef EXPAND_AUDIO_HEAP
 // Vanilla US/JP uses 7; Vanilla EU opts for 10 here effectively, though that one gets generated at runtime and doesn't use this value.
@@ -150,13 +152,19 @@ extern s16 gAiBufferLengths[NUMAIBUFFERS];
 
 extern u32 gAudioRandom;
 
+#ifdef SAMPLE_RESIDENCY_POOL_SIZE
+#define SAMPLE_RESIDENCY_SIZE ALIGN16(SAMPLE_RESIDENCY_POOL_SIZE)
+#else
+#define SAMPLE_RESIDENCY_SIZE 0
+#endif
+
 #if defined(VERSION_US) || defined(VERSION_JP)
 #define NOTES_BUFFER_SIZE \
 ( \
     MAX_SIMULTANEOUS_NOTES * ((4 /* updatesPerFrame */ * 20 * 2 * sizeof(u64)) \
     + ALIGN16(sizeof(struct Note)) \
-    + (DMA_BUF_SIZE_0 * 3) \
-    + DMA_BUF_SIZE_1 \
+    + (DMA_BUF_SIZE_0 * DMA_BUFS_PER_NOTE_0) \
+    + (DMA_BUF_SIZE_1 * DMA_BUFS_PER_NOTE_1) \
     + ALIGN16(sizeof(struct NoteSynthesisBuffers))) \
     + (320 * 2 * sizeof(u64)) /* gMaxAudioCmds */ \
 )
@@ -165,8 +173,8 @@ extern u32 gAudioRandom;
 ( \
     MAX_SIMULTANEOUS_NOTES * ((4 /* updatesPerFrame */ * 0x10 * 2 * sizeof(u64)) \
     + ALIGN16(sizeof(struct Note)) \
-    + (DMA_BUF_SIZE_0 * 3 * 1 /* presetUnk4 */) \
-    + (DMA_BUF_SIZE_1) \
+    + (DMA_BUF_SIZE_0 * DMA_BUFS_PER_NOTE_0 * 1 /* presetUnk4 */) \
+    + (DMA_BUF_SIZE_1 * DMA_BUFS_PER_NOTE_1) \
     + ALIGN16(sizeof(struct NoteSynthesisBuffers)) \
     + ALIGN16(4 /* updatesPerFrame */ * sizeof(struct NoteSubEu))) \
     + ((0x300 + (4 /* numReverbs */ * 0x20)) * 2 * sizeof(u64)) /* gMaxAudioCmds */ \
@@ -201,7 +209,7 @@ extern OSMesgQueue *D_SH_80350FA8;
 #if defined(VERSION_EU) || defined(VERSION_SH)
 #define AUDIO_INIT_POOL_SIZE (0x2B00 + (MAX_NUM_SOUNDBANKS * sizeof(s32)) + EXT_AUDIO_INIT_POOL_SIZE)
 #else
-#define AUDIO_INIT_POOL_SIZE (0x2400 + (MAX_NUM_SOUNDBANKS * sizeof(s32)) + EXT_AUDIO_INIT_POOL_SIZE)
+#define AUDIO_INIT_POOL_SIZE (0x2400 + (MAX_NUM_SOUNDBANKS * sizeof(s32)) + EXT_AUDIO_INIT_POOL_SIZE + SAMPLE_RESIDENCY_SIZE)
 #endif
 
 // TODO: needs validation once EU can compile. EU is very likely incorrect!
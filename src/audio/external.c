@@ -2525,6 +2525,9 @@ void sound_reset(u8 reverbPresetId) {
 #endif
 #if defined(VERSION_JP) || defined(VERSION_US)
     audio_reset_session(reverbPresetId);
+#ifdef SAMPLE_RESIDENCY_POOL_SIZE
+    preload_level_samples(gCurrLevelNum);
+#endif
 #else
     audio_reset_session_eu(reverbPresetId);
 #endif
@@ -8,6 +8,9 @@
 #include "load.h"
 #include "seqplayer.h"
 #include "game/puppyprint.h"
+#ifdef SAMPLE_RESIDENCY_POOL_SIZE
+#include "level_table.h"
+#endif
 
 struct SharedDma {
     /*0x0*/ u8 *buffer;       // target, points to pre-allocated buffer
@@ -40,11 +43,72 @@ OSMesgQueue gAudioDmaMesgQueue;
 OSMesg gAudioDmaMesg;
 OSIoMesg gAudioDmaIoMesg;
 
-struct SharedDma sSampleDmas[MAX_SIMULTANEOUS_NOTES * 4];
-u8 sSampleTTLs[MAX_SIMULTANEOUS_NOTES * 4];
+#define MAX_SAMPLE_DMAS (MAX_SIMULTANEOUS_NOTES * (DMA_BUFS_PER_NOTE_0 + DMA_BUFS_PER_NOTE_1))
+
+// Indices are stored in a u8, with 0xFF meaning none
+STATIC_ASSERT(MAX_SAMPLE_DMAS < 0xFF, "There can be at most 255 sample DMA buffers!");
+
+struct SharedDma sSampleDmas[MAX_SAMPLE_DMAS];
+u8 sSampleTTLs[MAX_SAMPLE_DMAS];
 u32 gSampleDmaNumListItems; // sh: 0x803503D4
 u32 sSampleDmaListSize1; // sh: 0x803503D8
 
+// DMAs with ttl != 0, so that decrease_sample_dma_ttls only has to visit those.
+u8 sSampleDmaLive[MAX_SAMPLE_DMAS];
+u32 sSampleDmaLiveCount;
+
+// The DMAs of list 2 are looked up by their source address, rounded down to a span of SAMPLE_DMA_INDEX_SPAN bytes.
+// No buffer is larger than a span, so a buffer holding an address starts either in that address's span or the one
+// before it, and only the DMAs in those two buckets have to be checked.
+#define SAMPLE_DMA_INDEX_SPAN 0x800
+#define SAMPLE_DMA_INDEX_BUCKETS 64
+#define SAMPLE_DMA_NONE 0xFF
+#define SAMPLE_DMA_BUCKET(addr) (((addr) / SAMPLE_DMA_INDEX_SPAN) % SAMPLE_DMA_INDEX_BUCKETS)
+
+STATIC_ASSERT(DMA_BUF_SIZE_0 <= SAMPLE_DMA_INDEX_SPAN && DMA_BUF_SIZE_1 <= SAMPLE_DMA_INDEX_SPAN,
+              "Sample DMA buffers can be at most 0x800 bytes!");
+
+u8 sSampleDmaBuckets[SAMPLE_DMA_INDEX_BUCKETS];
+u8 sSampleDmaBucketNext[MAX_SAMPLE_DMAS];
+
+#ifdef SAMPLE_RESIDENCY_POOL_SIZE
+#include "sound/sample_residency.inc.c"
+
+#define STUB_LEVEL(_0, _1, _2, _3, _4, _5, _6, _7, _8) NULL,
+#define DEFINE_LEVEL(_0, _1, _2, folder, _4, _5, _6, _7, _8, _9, _10) sSampleResidency_##folder,
+
+static const struct SampleResidencyEntry *sLevelSampleResidency[LEVEL_COUNT] = { NULL, // LEVEL_NONE
+#include "levels/level_defines.h"
+};
+
+#undef STUB_LEVEL
+#undef DEFINE_LEVEL
+
+#define MAX_RESIDENT_SAMPLES 256
+
+// A sample of the current level that was loaded into sResidentSamplePool.
+struct ResidentSample {
+    uintptr_t source;
+    u32 size;
+    u8 *buffer;
+};
+
+// Sorted by source address
+struct ResidentSample sResidentSamples[MAX_RESIDENT_SAMPLES];
+u32 sResidentSampleCount;
+u8 *sResidentSamplePool;
+s32 sResidentSampleLevel;
+#endif
+
+#ifdef PUPPYPRINT_DEBUG
+struct SampleDmaStats gSampleDmaFrameStats;
+static struct SampleDmaStats sSampleDmaStats;
+
+#define SAMPLE_DMA_STAT(stat, n) (sSampleDmaStats.stat += (n))
+#else
+#define SAMPLE_DMA_STAT(stat, n)
+#endif
+
 // Circular buffer of DMAs with ttl = 0. tail <= head, wrapping around mod 256.
 u8 sSampleDmaReuseQueue1[256];
 u8 sSampleDmaReuseQueue2[256];
@@ -152,29 +216,84 @@ void audio_dma_partial_copy_async(uintptr_t *devAddr, u8 **vAddr, ssize_t *remai
     *vAddr += transfer;
 }
 
+static void set_sample_dma_ttl(u32 index, u8 ttl) {
+    if (sSampleTTLs[index] == 0) {
+        sSampleDmaLive[sSampleDmaLiveCount++] = index;
+    }
+    sSampleTTLs[index] = ttl;
+}
+
+static void unlink_sample_dma(u32 index) {
+    u8 *link = &sSampleDmaBuckets[SAMPLE_DMA_BUCKET(sSampleDmas[index].source)];
+
+    while (*link != index) {
+        link = &sSampleDmaBucketNext[*link];
+    }
+    *link = sSampleDmaBucketNext[index];
+}
+
+static void link_sample_dma(u32 index) {
+    u8 *bucket = &sSampleDmaBuckets[SAMPLE_DMA_BUCKET(sSampleDmas[index].source)];
+
+    sSampleDmaBucketNext[index] = *bucket;
+    *bucket = index;
+}
+
 void decrease_sample_dma_ttls() {
     u32 i;
-
-    for (i = 0; i < sSampleDmaListSize1; i++) {
-        if (sSampleTTLs[i] != 0) {
-            sSampleTTLs[i]--;
-            if (sSampleTTLs[i] == 0) {
-                sSampleDmas[i].reuseIndex = sSampleDmaReuseQueueHead1;
-                sSampleDmaReuseQueue1[sSampleDmaReuseQueueHead1++] = (u8) i;
+    u32 index;
+
+    // Going backwards, so that the DMA moved into the place of one that expires has already been visited.
+    for (i = sSampleDmaLiveCount; i-- > 0;) {
+        index = sSampleDmaLive[i];
+        if (--sSampleTTLs[index] == 0) {
+            if (index < sSampleDmaListSize1) {
+                sSampleDmas[index].reuseIndex = sSampleDmaReuseQueueHead1;
+                sSampleDmaReuseQueue1[sSampleDmaReuseQueueHead1++] = (u8) index;
+            } else {
+                sSampleDmas[index].reuseIndex = sSampleDmaReuseQueueHead2;
+                sSampleDmaReuseQueue2[sSampleDmaReuseQueueHead2++] = (u8) index;
             }
+            sSampleDmaLive[i] = sSampleDmaLive[--sSampleDmaLiveCount];
         }
     }
 
-    for (i = sSampleDmaListSize1; i < gSampleDmaNumListItems; i++) {
-        if (sSampleTTLs[i] != 0) {
-            sSampleTTLs[i]--;
-            if (sSampleTTLs[i] == 0) {
-                sSampleDmas[i].reuseIndex = sSampleDmaReuseQueueHead2;
-                sSampleDmaReuseQueue2[sSampleDmaReuseQueueHead2++] = (u8) i;
-            }
+#ifdef PUPPYPRINT_DEBUG
+    // Called once at the end of every audio frame
+    gSampleDmaFrameStats = sSampleDmaStats;
+    bzero(&sSampleDmaStats, sizeof(sSampleDmaStats));
+#endif
+}
+
+#ifdef SAMPLE_RESIDENCY_POOL_SIZE
+/**
+ * Returns where the sample data at devAddr is kept in RAM, or NULL if it is not resident and has to be streamed.
+ */
+static u8 *find_resident_sample(uintptr_t devAddr, u32 size) {
+    struct ResidentSample *sample;
+    u32 lo = 0;
+    u32 hi = sResidentSampleCount;
+    u32 mid;
+
+    // Find the last sample that starts at or before devAddr.
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (sResidentSamples[mid].source <= devAddr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
     }
+    if (lo == 0) {
+        return NULL;
+    }
+    sample = &sResidentSamples[lo - 1];
+    if (devAddr + size > sample->source + sample->size) {
+        return NULL;
+    }
+    return (devAddr - sample->source) + sample->buffer;
 }
+#endif
 
 void *dma_sample_data(uintptr_t devAddr, u32 size, s32 arg2, u8 *dmaIndexRef) {
     s32 hasDma = FALSE;
@@ -182,29 +301,41 @@ void *dma_sample_data(uintptr_t devAddr, u32 size, s32 arg2, u8 *dmaIndexRef) {
     uintptr_t dmaDevAddr;
     u32 transfer;
     u32 i;
+    u32 bucket;
     u32 dmaIndex;
     ssize_t bufferPos;
 
+#ifdef SAMPLE_RESIDENCY_POOL_SIZE
+    u8 *resident = find_resident_sample(devAddr, size);
+    if (resident != NULL) {
+        return resident;
+    }
+#endif
+
     if (arg2 != 0 || *dmaIndexRef >= sSampleDmaListSize1) {
-        for (i = sSampleDmaListSize1; i < gSampleDmaNumListItems; i++) {
-            dma = &sSampleDmas[i];
-            bufferPos = devAddr - dma->source;
-            if (0 <= bufferPos && (size_t) bufferPos <= dma->bufSize - size) {
-                // We already have a DMA request for this memory range.
-                if (sSampleTTLs[i] == 0 && sSampleDmaReuseQueueTail2 != sSampleDmaReuseQueueHead2) {
-                    // Move the DMA out of the reuse queue, by swapping it with the
-                    // tail, and then incrementing the tail.
-                    if (dma->reuseIndex != sSampleDmaReuseQueueTail2) {
-                        sSampleDmaReuseQueue2[dma->reuseIndex] =
-                            sSampleDmaReuseQueue2[sSampleDmaReuseQueueTail2];
-                        sSampleDmas[sSampleDmaReuseQueue2[sSampleDmaReuseQueueTail2]].reuseIndex =
-                            dma->reuseIndex;
+        for (bucket = 0; bucket < 2; bucket++) {
+            for (i = sSampleDmaBuckets[SAMPLE_DMA_BUCKET(devAddr - bucket * SAMPLE_DMA_INDEX_SPAN)];
+                 i != SAMPLE_DMA_NONE; i = sSampleDmaBucketNext[i]) {
+                dma = &sSampleDmas[i];
+                bufferPos = devAddr - dma->source;
+                if (0 <= bufferPos && (size_t) bufferPos <= dma->bufSize - size) {
+                    // We already have a DMA request for this memory range.
+                    if (sSampleTTLs[i] == 0 && sSampleDmaReuseQueueTail2 != sSampleDmaReuseQueueHead2) {
+                        // Move the DMA out of the reuse queue, by swapping it with the
+                        // tail, and then incrementing the tail.
+                        if (dma->reuseIndex != sSampleDmaReuseQueueTail2) {
+                            sSampleDmaReuseQueue2[dma->reuseIndex] =
+                                sSampleDmaReuseQueue2[sSampleDmaReuseQueueTail2];
+                            sSampleDmas[sSampleDmaReuseQueue2[sSampleDmaReuseQueueTail2]].reuseIndex =
+                                dma->reuseIndex;
+                        }
+                        sSampleDmaReuseQueueTail2++;
                     }
-                    sSampleDmaReuseQueueTail2++;
+                    set_sample_dma_ttl(i, 60);
+                    *dmaIndexRef = (u8) i;
+                    SAMPLE_DMA_STAT(hits, 1);
+                    return (devAddr - dma->source) + dma->buffer;
                 }
-                sSampleTTLs[i] = 60;
-                *dmaIndexRef = (u8) i;
-                return (devAddr - dma->source) + dma->buffer;
             }
         }
 
@@ -214,7 +345,7 @@ void *dma_sample_data(uintptr_t devAddr, u32 size, s32 arg2, u8 *dmaIndexRef) {
             dmaIndex = sSampleDmaReuseQueue2[sSampleDmaReuseQueueTail2];
             sSampleDmaReuseQueueTail2++;
             dma = sSampleDmas + dmaIndex;
-            sSampleTTLs[dmaIndex] = 2;
+            set_sample_dma_ttl(dmaIndex, 2);
             hasDma = TRUE;
         }
     } else {
@@ -233,7 +364,8 @@ void *dma_sample_data(uintptr_t devAddr, u32 size, s32 arg2, u8 *dmaIndexRef) {
                 }
                 sSampleDmaReuseQueueTail1++;
             }
-            sSampleTTLs[*dmaIndexRef] = 2;
+            set_sample_dma_ttl(*dmaIndexRef, 2);
+            SAMPLE_DMA_STAT(hits, 1);
             return dma->buffer + (devAddr - dma->source);
         }
     }
@@ -243,13 +375,24 @@ void *dma_sample_data(uintptr_t devAddr, u32 size, s32 arg2, u8 *dmaIndexRef) {
         // be empty, since TTL 2 is so small.
         dmaIndex = sSampleDmaReuseQueue1[sSampleDmaReuseQueueTail1++];
         dma = sSampleDmas + dmaIndex;
-        sSampleTTLs[dmaIndex] = 2;
+        set_sample_dma_ttl(dmaIndex, 2);
         hasDma = TRUE;
     }
 
     transfer = dma->bufSize;
     dmaDevAddr = devAddr & ~0xF;
+    if (dma->source != 0) {
+        SAMPLE_DMA_STAT(evictions, 1);
+        if (dmaIndex >= sSampleDmaListSize1) {
+            unlink_sample_dma(dmaIndex);
+        }
+    }
     dma->source = dmaDevAddr;
+    if (dmaIndex >= sSampleDmaListSize1) {
+        link_sample_dma(dmaIndex);
+    }
+    SAMPLE_DMA_STAT(misses, 1);
+    SAMPLE_DMA_STAT(bytes, transfer);
 #ifdef VERSION_US // TODO: Is there a reason this only exists in US?
     osInvalDCache(dma->buffer, transfer);
 #endif
@@ -267,9 +410,9 @@ void init_sample_dma_buffers() {
     sDmaBufSize = DMA_BUF_SIZE_0;
 
 #if defined(VERSION_EU)
-    for (i = 0; i < gMaxSimultaneousNotes * 3 * gAudioBufferParameters.presetUnk4; i++) {
+    for (i = 0; i < gMaxSimultaneousNotes * DMA_BUFS_PER_NOTE_0 * gAudioBufferParameters.presetUnk4; i++) {
 #else
-    for (i = 0; i < gMaxSimultaneousNotes * 3; i++) {
+    for (i = 0; i < gMaxSimultaneousNotes * DMA_BUFS_PER_NOTE_0; i++) {
 #endif
         sSampleDmas[gSampleDmaNumListItems].buffer = soundAlloc(&gNotesAndBuffersPool, sDmaBufSize);
         if (sSampleDmas[gSampleDmaNumListItems].buffer == NULL) {
@@ -296,7 +439,7 @@ void init_sample_dma_buffers() {
 
     sDmaBufSize = DMA_BUF_SIZE_1;
 
-    for (i = 0; i < gMaxSimultaneousNotes; i++) {
+    for (i = 0; i < gMaxSimultaneousNotes * DMA_BUFS_PER_NOTE_1; i++) {
         sSampleDmas[gSampleDmaNumListItems].buffer = soundAlloc(&gNotesAndBuffersPool, sDmaBufSize);
         if (sSampleDmas[gSampleDmaNumListItems].buffer == NULL) {
             break;
@@ -320,6 +463,16 @@ void init_sample_dma_buffers() {
 
     sSampleDmaReuseQueueTail2 = 0;
     sSampleDmaReuseQueueHead2 = gSampleDmaNumListItems - sSampleDmaListSize1;
+
+    sSampleDmaLiveCount = 0;
+    for (i = 0; i < ARRAY_COUNT(sSampleDmaBuckets); i++) {
+        sSampleDmaBuckets[i] = SAMPLE_DMA_NONE;
+    }
+#ifdef PUPPYPRINT_DEBUG
+    bzero(&sSampleDmaStats, sizeof(sSampleDmaStats));
+    bzero(&gSampleDmaFrameStats, sizeof(gSampleDmaFrameStats));
+#endif
+
 }
 
 #if defined(VERSION_JP) || defined(VERSION_US)
@@ -680,6 +833,56 @@ void preload_sequence(u32 seqId, u8 preloadMask) {
     gAudioLoadLock = AUDIO_LOCK_NOT_LOADING;
 }
 
+#ifdef SAMPLE_RESIDENCY_POOL_SIZE
+/**
+ * Replaces the resident samples with those listed for a level, loading them in order until the pool is full.
+ * Samples that don't fit are skipped, so a smaller one further down the list may still be loaded.
+ */
+void preload_level_samples(s32 levelNum) {
+    const struct SampleResidencyEntry *entry = NULL;
+    struct ResidentSample *sample;
+    uintptr_t source;
+    u32 size;
+    u32 used = 0;
+    u32 count = 0;
+
+    if (levelNum == sResidentSampleLevel || sResidentSamplePool == NULL) {
+        return;
+    }
+
+    gAudioLoadLock = AUDIO_LOCK_LOADING;
+
+    // Nothing is resident while the pool is being overwritten.
+    sResidentSampleCount = 0;
+    sResidentSampleLevel = levelNum;
+    if (levelNum > LEVEL_NONE && levelNum < LEVEL_COUNT) {
+        entry = sLevelSampleResidency[levelNum];
+    }
+
+    for (; entry != NULL && entry->size != 0 && count < ARRAY_COUNT(sResidentSamples); entry++) {
+        // Copied from a 16 byte boundary, so that the data keeps the alignment it has in ROM.
+        source = ((uintptr_t) gSoundDataRaw + entry->offset) & ~0xF;
+        size = ALIGN16((uintptr_t) gSoundDataRaw + entry->offset + entry->size) - source;
+        if (used + size > SAMPLE_RESIDENCY_SIZE) {
+            continue;
+        }
+        audio_dma_copy_immediate(source, sResidentSamplePool + used, size);
+
+        for (sample = &sResidentSamples[count]; sample != sResidentSamples && sample[-1].source > source; sample--) {
+            *sample = sample[-1];
+        }
+        sample->source = source;
+        sample->size = size;
+        sample->buffer = sResidentSamplePool + used;
+        used += size;
+        count++;
+    }
+
+    sResidentSampleCount = count;
+    gAudioLoadLock = AUDIO_LOCK_NOT_LOADING;
+}
+#endif
+
 void load_sequence_internal(u32 player, u32 seqId, s32 loadAsync);
 
 void load_sequence(u32 player, u32 seqId, s32 loadAsync) {
@@ -834,6 +1037,14 @@ void audio_init() {
         gAiBuffers[i] = soundAlloc(&gAudioInitPool, AIBUFFER_LEN);
     }
 
+#ifdef SAMPLE_RESIDENCY_POOL_SIZE
+    // Allocated once rather than with each session, so the resident samples survive sound resets
+    // and are only loaded again when the level changes.
+    sResidentSamplePool = soundAlloc(&gAudioInitPool, SAMPLE_RESIDENCY_SIZE);
+    sResidentSampleCount = 0;
+    sResidentSampleLevel = LEVEL_NONE;
+#endif
+
 #if defined(VERSION_EU)
     gAudioResetPresetIdToLoad = 0;
     gAudioResetStatus = 1;
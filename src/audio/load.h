@@ -34,6 +34,26 @@ extern struct NotePool gNoteFreeLists;
 
 extern OSMesgQueue gCurrAudioFrameDmaQueue;
 extern u32 gSampleDmaNumListItems;
+
+#ifdef PUPPYPRINT_DEBUG
+struct SampleDmaStats {
+    u32 hits;      // requests for sample data that was already loaded
+    u32 misses;    // requests that started a DMA
+    u32 evictions; // misses that replaced sample data another note could still have used
+    u32 bytes;     // bytes read from ROM
+};
+
+// Sample DMA requests of the last audio frame
+extern struct SampleDmaStats gSampleDmaFrameStats;
+#endif
+
+#ifdef SAMPLE_RESIDENCY_POOL_SIZE
+// A sample to keep in RAM while a level is loaded, as listed by assemble_sound.py
+struct SampleResidencyEntry {
+    u32 offset; // in sound_data.tbl
+    u32 size;
+};
+#endif
 extern ALSeqFile *gAlCtlHeader;
 extern ALSeqFile *gAlTbl;
 extern ALSeqFile *gSeqFileHeader;
@@ -99,6 +119,9 @@ void preload_sequence(u32 seqId, s32 preloadMask);
 void preload_sequence(u32 seqId, u8 preloadMask);
 #endif
 void load_sequence(u32 player, u32 seqId, s32 loadAsync);
+#ifdef SAMPLE_RESIDENCY_POOL_SIZE
+void preload_level_samples(s32 levelNum);
+#endif
 
 #ifdef VERSION_SH
 void func_sh_802f3158(s32 seqId, s32 arg1, s32 arg2, OSMesgQueue *retQueue);
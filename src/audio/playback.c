@@ -9,6 +9,24 @@
 #include "effects.h"
 #include "external.h"
 
+#ifdef ADAPTIVE_POLYPHONY
+// Frames the average audio time has to stay over the target before each note the budget is lowered by, giving the
+// notes that are playing a chance to end, and under three quarters of it before each note it is raised by.
+#define NOTE_BUDGET_LOWER_FRAMES 4
+#define NOTE_BUDGET_RAISE_FRAMES 30
+
+s32 gNoteBudget;
+struct NoteBudgetStats gNoteBudgetStats;
+
+// Notes that aren't disabled, counted at the end of process_notes and as notes are taken from the disabled lists.
+static s32 sNotesInUse;
+static s32 sNoteBudgetFramesOver;
+static s32 sNoteBudgetFramesUnder;
+static s32 sAudioFrameTime;
+static u32 sNotesStolen;
+static u32 sNoteBudgetStatsFrames;
+#endif
+
 void note_set_resampling_rate(struct Note *note, f32 resamplingRateInput);
 
 #if defined(VERSION_EU) || defined(VERSION_SH)
@@ -610,8 +628,58 @@ void process_notes(void) {
     }
 #undef PREPEND
 #undef POP
+
+#ifdef ADAPTIVE_POLYPHONY
+    sNotesInUse = 0;
+    for (i = 0; i < gMaxSimultaneousNotes; i++) {
+        if (gNotes[i].priority != NOTE_PRIORITY_DISABLED) {
+            sNotesInUse++;
+        }
+    }
+#endif
 }
 
+#ifdef ADAPTIVE_POLYPHONY
+/**
+ * Called by the audio thread once a frame with the time it took, in CPU cycles, to move the note budget towards what
+ * the audio thread can afford. Lowering it doesn't stop any notes, it only keeps new ones from using more.
+ */
+void update_note_budget(u32 frameCycles) {
+    s32 frameTime = OS_CYCLES_TO_USEC(frameCycles);
+
+    // Moves an eighth of the way towards each new time, so a single slow frame doesn't lower the budget.
+    sAudioFrameTime += (frameTime - sAudioFrameTime) / 8;
+
+    if (sAudioFrameTime > ADAPTIVE_POLYPHONY_TARGET_US) {
+        sNoteBudgetFramesUnder = 0;
+        if (++sNoteBudgetFramesOver >= NOTE_BUDGET_LOWER_FRAMES) {
+            sNoteBudgetFramesOver = 0;
+            if (gNoteBudget > ADAPTIVE_POLYPHONY_MIN_NOTES) {
+                gNoteBudget--;
+            }
+        }
+    } else if (sAudioFrameTime < ADAPTIVE_POLYPHONY_TARGET_US * 3 / 4) {
+        sNoteBudgetFramesOver = 0;
+        if (++sNoteBudgetFramesUnder >= NOTE_BUDGET_RAISE_FRAMES) {
+            sNoteBudgetFramesUnder = 0;
+            if (gNoteBudget < gMaxSimultaneousNotes) {
+                gNoteBudget++;
+            }
+        }
+    } else {
+        sNoteBudgetFramesOver = 0;
+        sNoteBudgetFramesUnder = 0;
+    }
+
+    gNoteBudgetStats.frameTime = sAudioFrameTime;
+    if (++sNoteBudgetStatsFrames >= 60) {
+        gNoteBudgetStats.notesStolen = sNotesStolen;
+        sNotesStolen = 0;
+        sNoteBudgetStatsFrames = 0;
+    }
+}
+#endif
+
 #if defined(VERSION_SH)
 // These three are matching but have been moved from above in shindou:
 struct AudioBankSound *instrument_get_audio_bank_sound(struct Instrument *instrument, s32 semitone) {
@@ -936,6 +1004,11 @@ void init_note_free_list(void) {
         gNotes[i].listItem.prev = NULL;
         audio_list_push_back(&gNoteFreeLists.disabled, &gNotes[i].listItem);
     }
+
+#ifdef ADAPTIVE_POLYPHONY
+    gNoteBudget = gMaxSimultaneousNotes;
+    sNotesInUse = 0;
+#endif
 }
 
 void note_pool_clear(struct NotePool *pool) {
@@ -1188,7 +1261,16 @@ void note_release_and_take_ownership(struct Note *note, struct SequenceChannelLa
 }
 
 struct Note *alloc_note_from_disabled(struct NotePool *pool, struct SequenceChannelLayer *seqLayer) {
-    struct Note *note = audio_list_pop_back(&pool->disabled);
+    struct Note *note;
+
+#ifdef ADAPTIVE_POLYPHONY
+    // Over budget, the note has to take over a decaying or lower priority one instead.
+    if (sNotesInUse >= gNoteBudget) {
+        return NULL;
+    }
+#endif
+
+    note = audio_list_pop_back(&pool->disabled);
     if (note != NULL) {
 #if defined(VERSION_EU) || defined(VERSION_SH)
         note_init_for_layer(note, seqLayer);
@@ -1199,6 +1281,9 @@ struct Note *alloc_note_from_disabled(struct NotePool *pool, struct SequenceChan
         }
 #endif
         audio_list_push_front(&pool->active, &note->listItem);
+#ifdef ADAPTIVE_POLYPHONY
+        sNotesInUse++;
+#endif
     }
     return note;
 }
@@ -1208,6 +1293,9 @@ struct Note *alloc_note_from_decaying(struct NotePool *pool, struct SequenceChan
     if (note != NULL) {
         note_release_and_take_ownership(note, seqLayer);
         audio_list_push_back(&pool->releasing, &note->listItem);
+#ifdef ADAPTIVE_POLYPHONY
+        sNotesStolen++;
+#endif
     }
     return note;
 }
@@ -1238,6 +1326,9 @@ struct Note *alloc_note_from_active(struct NotePool *pool, struct SequenceChanne
 #else
         func_80319728(aNote, seqLayer);
         audio_list_push_back(&pool->releasing, &aNote->listItem);
+#endif
+#ifdef ADAPTIVE_POLYPHONY
+        sNotesStolen++;
 #endif
     }
 
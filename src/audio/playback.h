@@ -18,6 +18,18 @@ enum NoteAlloc {
     NOTE_ALLOC_GLOBAL_FREELIST = (1 << 3), // 0x8
 };
 
+#ifdef ADAPTIVE_POLYPHONY
+struct NoteBudgetStats {
+    u32 frameTime;   // audio thread time per frame in microseconds, averaged over the last few frames
+    u32 notesStolen; // notes that took over a decaying or lower priority note in the last second
+};
+
+extern s32 gNoteBudget;
+extern struct NoteBudgetStats gNoteBudgetStats;
+
+void update_note_budget(u32 frameCycles);
+#endif
+
 void process_notes(void);
 void seq_channel_layer_note_decay(struct SequenceChannelLayer *seqLayer);
 void seq_channel_layer_note_release(struct SequenceChannelLayer *seqLayer);
@@ -47,11 +47,6 @@ u8 toggleBetterReverb = FALSE;
 u8 betterReverbLightweight = FALSE;
 u8 monoReverb;
 s8 betterReverbDownsampleRate;
-static s32         reverbMults[SYNTH_CHANNEL_STEREO_COUNT][NUM_ALLPASS / 3] = {0};
-static s32          allpassIdx[SYNTH_CHANNEL_STEREO_COUNT][NUM_ALLPASS] = {0};
-static s32  betterReverbDelays[SYNTH_CHANNEL_STEREO_COUNT][NUM_ALLPASS] = {0};
-static s32 historySamplesLight[SYNTH_CHANNEL_STEREO_COUNT];
-static s16         **delayBufs[SYNTH_CHANNEL_STEREO_COUNT];
 u8 *gReverbMults[SYNTH_CHANNEL_STEREO_COUNT];
 s32 reverbLastFilterIndex;
 s32 reverbFilterCount;
@@ -83,94 +78,7 @@ f32 *currentRampingTableLeft;
 f32 *currentRampingTableRight;
 
 #ifdef BETTER_REVERB
-static void reverb_samples(s16 *start, s16 *end, s16 *downsampleBuffer, s32 channel) {
-    s16 *curDelaySample;
-    s32 historySample;
-    s32 tmpCarryover;
-    s32 outSampleTotal;
-    s32 i;
-    s32 j;
-    s32 k;
-
-    s32 downsampleIncrement = gReverbDownsampleRate;
-    s32 *delaysLocal = betterReverbDelays[channel];
-    s32 *reverbMultsLocal = reverbMults[channel];
-    s32 *allpassIdxLocal = allpassIdx[channel];
-    s16 **delayBufsLocal = delayBufs[channel];
-
-    s32 lastFilterIndex = reverbLastFilterIndex;
-    s32 revIndex = betterReverbRevIndex;
-    s32 gainIndex = betterReverbGainIndex;
-
-    // Set j outside of the loop only. Because we're forcing filter count to always be a multiple of 3, we can count on j always being 0 when exiting the second for loop.
-    j = 0;
-
-    for (; start < end; start++, downsampleBuffer += downsampleIncrement) {
-        // Mix the very last filter output with new incoming sample
-        tmpCarryover = ((delayBufsLocal[lastFilterIndex][allpassIdxLocal[lastFilterIndex]] * revIndex) >> 8) + *downsampleBuffer;
-        outSampleTotal = 0;
-        i = 0;
-        k = 0;
-
-        for (; i <= lastFilterIndex; ++i, ++j) {
-            curDelaySample = &delayBufsLocal[i][allpassIdxLocal[i]];
-            historySample = *curDelaySample;
-
-            if (j == 2) {
-                j = -1;
-                outSampleTotal += ((historySample * reverbMultsLocal[k++]) >> 8);
-                *curDelaySample = CLAMP_S16(tmpCarryover);
-                if (i != lastFilterIndex)
-                    tmpCarryover = ((historySample * revIndex) >> 8)/* + *downsampleBuffer*/;
-            } else {
-                tmpCarryover += (historySample * (-gainIndex)) >> 8;
-                *curDelaySample = CLAMP_S16(tmpCarryover);
-                tmpCarryover = ((tmpCarryover * gainIndex) >> 8) + historySample;
-            }
-
-            if (++allpassIdxLocal[i] == delaysLocal[i]) allpassIdxLocal[i] = 0;
-        }
-
-        *start = CLAMP_S16(outSampleTotal);
-    }
-}
-
-static void reverb_samples_light(s16 *start, s16 *end, s16 *downsampleBuffer, s32 channel) {
-    s16 *curDelaySample;
-    s32 historySample;
-    s32 tmpCarryover;
-    s32 i;
-
-    s32 downsampleIncrement = gReverbDownsampleRate;
-    s32 *delaysLocal = betterReverbDelays[channel];
-    s32 *allpassIdxLocal = allpassIdx[channel];
-    s16 **delayBufsLocal = delayBufs[channel];
-
-    // Get history sample from last processing tick
-    tmpCarryover = historySamplesLight[channel];
-
-    for (; start < end; start++, downsampleBuffer += downsampleIncrement) {
-        // Mix previous sample with new incoming sample
-        tmpCarryover = ((tmpCarryover * BETTER_REVERB_REVERB_INDEX_LIGHT) >> 8) + *downsampleBuffer;
-
-        for (i = 0; i < BETTER_REVERB_FILTER_COUNT_LIGHT; ++i) {
-            curDelaySample = &delayBufsLocal[i][allpassIdxLocal[i]];
-            historySample = *curDelaySample;
-
-            tmpCarryover += ((historySample * (-BETTER_REVERB_GAIN_INDEX_LIGHT)) >> 8);
-            *curDelaySample = CLAMP_S16(tmpCarryover);
-            tmpCarryover = ((tmpCarryover * BETTER_REVERB_GAIN_INDEX_LIGHT) >> 8) + historySample;
-
-            if (++allpassIdxLocal[i] == delaysLocal[i]) allpassIdxLocal[i] = 0;
-        }
-
-        // Lightweight does not use the final filter type at all, unlike standard reverb processing
-        *start = CLAMP_S16(tmpCarryover);
-    }
-    
-    // Copy history sample to temporary buffer for processing next tick
-    historySamplesLight[channel] = tmpCarryover;
-}
+#include "better_reverb.inc.c"
 
 void initialize_better_reverb_buffers(void) {
     delayBufs[SYNTH_CHANNEL_LEFT] = (s16**) soundAlloc(&gBetterReverbPool, BETTER_REVERB_PTR_SIZE);
@@ -344,6 +252,7 @@ u64 *synthesis_execute(u64 *cmdBuf, s32 *writtenCmds, s16 *aiBuf, s32 bufLen) {
     }
 
     reverbLastFilterIndex = reverbFilterCount - 1;
+    set_reverb_index_shifts();
 
     // Update reverbMults every audio frame just in case gReverbMults is ever to change.
     if (gReverbMults[SYNTH_CHANNEL_LEFT] != NULL && gReverbMults[SYNTH_CHANNEL_RIGHT] != NULL) {
@@ -39,6 +39,10 @@ enum ChannelIndexes {
 // as this default is configured to handle the emulator RCVI settings.
 #define BETTER_REVERB_SIZE ALIGN16(0xEDE0 + BETTER_REVERB_PTR_SIZE)
 
+// Number of samples each filter is run over at a time. Larger blocks spend less time switching between delay lines,
+// but cost 8 bytes of stack each; blocks are also never longer than the delay of the last filter.
+#define BETTER_REVERB_BLOCK_SIZE 32
+
 
 /* ------ BETTER REVERB LIGHTWEIGHT PARAMETER OVERRIDES ------ */
 
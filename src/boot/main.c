@@ -21,6 +21,7 @@
 #endif
 #include "game/puppyprint.h"
 #include "game/profiling.h"
+#include "game/sampling_profiler.h"
 #include "game/emutest.h"
 
 // Message IDs
@@ -292,6 +293,7 @@ void handle_sp_complete(void) {
 
 void handle_dp_complete(void) {
     // Gfx SP task is completely done.
+    profiler_rdp_completed();
     if (sCurrentDisplaySPTask->msgqueue != NULL) {
         osSendMesg(sCurrentDisplaySPTask->msgqueue, sCurrentDisplaySPTask->msg, OS_MESG_NOBLOCK);
     }
@@ -357,6 +359,7 @@ void thread3_main(UNUSED void *arg) {
 #ifdef UNF
     debug_initialize();
 #endif
+    sampling_profiler_init();
 
 #ifdef DEBUG
     osSyncPrintf("Super Mario 64\n");
@@ -20,6 +20,7 @@
 #include "usb/debug.h"
 #endif
 #include "game/puppyprint.h"
+#include "game/gfx_pool_stats.h"
 
 
 struct MainPoolState {
@@ -367,6 +368,10 @@ void *load_to_fixed_pool_addr(u8 *destAddr, u8 *srcStart, u8 *srcEnd) {
     return dest;
 }
 
+#ifdef PUPPYPRINT_DEBUG
+struct SegmentLoadStats gSegmentLoadStats;
+#endif
+
 /**
  * Decompress the block of ROM data from srcStart to srcEnd and return a
  * pointer to an allocated buffer holding the decompressed data. Set the
@@ -374,6 +379,9 @@ void *load_to_fixed_pool_addr(u8 *destAddr, u8 *srcStart, u8 *srcEnd) {
  */
 void *load_segment_decompress(s32 segment, u8 *srcStart, u8 *srcEnd) {
     void *dest = NULL;
+#ifdef PUPPYPRINT_DEBUG
+    OSTime first = osGetTime();
+#endif
 
 #ifdef GZIP
     u32 compSize = (srcEnd - 4 - srcStart);
@@ -395,6 +403,9 @@ void *load_segment_decompress(s32 segment, u8 *srcStart, u8 *srcEnd) {
 #else
         dma_read(compressed, srcStart, srcEnd);
         dest = main_pool_alloc(*size, MEMORY_POOL_LEFT);
+#endif
+#ifdef PUPPYPRINT_DEBUG
+        gSegmentLoadStats.readTime += osGetTime() - first;
 #endif
         if (dest != NULL) {
             osSyncPrintf("start decompress\n");
@@ -417,6 +428,10 @@ void *load_segment_decompress(s32 segment, u8 *srcStart, u8 *srcEnd) {
 #ifdef PUPPYPRINT_DEBUG
     u32 ppSize = ALIGN16((u32)*size) + 16;
     set_segment_memory_printout(segment, ppSize);
+    gSegmentLoadStats.segments++;
+    gSegmentLoadStats.compressedBytes += compSize;
+    gSegmentLoadStats.decompressedBytes += *size;
+    gSegmentLoadStats.time += osGetTime() - first;
 #endif
     return dest;
 }
@@ -593,6 +608,12 @@ void *alloc_display_list(u32 size) {
     if (gGfxPoolEnd - size >= (u8 *) gDisplayListHead) {
         gGfxPoolEnd -= size;
         ptr = gGfxPoolEnd;
+        GFX_POOL_STATS_ADD(GFX_POOL_STAT_ALLOCATIONS, 1);
+        if (size == sizeof(Mtx)) {
+            GFX_POOL_STATS_ADD(GFX_POOL_STAT_MATRICES, 1);
+        }
+    } else {
+        GFX_POOL_STATS_EVENT(gGfxPoolFailedAllocations);
     }
     return ptr;
 }
@@ -632,3 +653,202 @@ s32 load_patchable_table(struct DmaHandlerList *list, s32 index) {
     }
     return FALSE;
 }
+
+#ifdef MARIO_ANIM_CACHE
+void setup_dma_table_cache(struct DmaTableCache *cache, void *srcAddr, void *buffer, u32 size) {
+    bzero(cache, sizeof(struct DmaTableCache));
+    cache->dmaTable = load_dma_table_address(srcAddr);
+    cache->buffer = buffer;
+    cache->bufferSize = size;
+    osCreateMesgQueue(&cache->prefetchMesgQueue, &cache->prefetchMesgBuf, 1);
+}
+
+/**
+ * Starts the next chunk of the prefetch in flight once the previous one is done.
+ * If block is set, waits for the whole prefetch to finish.
+ */
+static void dma_table_cache_poll_prefetch(struct DmaTableCache *cache, s32 block) {
+    while (cache->prefetchEntry != NULL) {
+        if (osRecvMesg(&cache->prefetchMesgQueue, NULL, block ? OS_MESG_BLOCK : OS_MESG_NOBLOCK) == -1) {
+            return;
+        }
+
+        if (cache->prefetchRemaining == 0) {
+            cache->prefetchEntry = NULL;
+            return;
+        }
+
+        u32 copySize = (cache->prefetchRemaining >= 0x1000) ? 0x1000 : cache->prefetchRemaining;
+        osPiStartDma(&cache->prefetchIoMesg, OS_MESG_PRI_NORMAL, OS_READ, (uintptr_t) cache->prefetchSrc, cache->prefetchDest,
+                     copySize, &cache->prefetchMesgQueue);
+        cache->prefetchSrc += copySize;
+        cache->prefetchDest += copySize;
+        cache->prefetchRemaining -= copySize;
+    }
+}
+
+static struct DmaTableCacheEntry *dma_table_cache_find(struct DmaTableCache *cache, s32 index) {
+    for (s32 i = 0; i < DMA_TABLE_CACHE_ENTRIES; i++) {
+        if (cache->entries[i].addr != NULL && cache->entries[i].index == index) {
+            return &cache->entries[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Returns a free range of the buffer that fits size bytes, or NULL.
+ * Entries are either at the start of the buffer or right after another entry.
+ */
+static u8 *dma_table_cache_find_space(struct DmaTableCache *cache, u32 size) {
+    for (s32 i = -1; i < DMA_TABLE_CACHE_ENTRIES; i++) {
+        u8 *start;
+
+        if (i < 0) {
+            start = cache->buffer;
+        } else if (cache->entries[i].addr != NULL) {
+            start = cache->entries[i].addr + cache->entries[i].size;
+        } else {
+            continue;
+        }
+        if (start + size > cache->buffer + cache->bufferSize) {
+            continue;
+        }
+
+        s32 j;
+        for (j = 0; j < DMA_TABLE_CACHE_ENTRIES; j++) {
+            struct DmaTableCacheEntry *other = &cache->entries[j];
+            if (other->addr != NULL && other->addr < start + size && start < other->addr + other->size) {
+                break;
+            }
+        }
+        if (j == DMA_TABLE_CACHE_ENTRIES) {
+            return start;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Makes room for an entry of the given size, evicting the least recently used entries as needed.
+ * Entries used since minAge are never evicted, nor is the prefetch in flight.
+ * Returns an empty entry pointing at the space, or NULL if there isn't enough.
+ */
+static struct DmaTableCacheEntry *dma_table_cache_alloc(struct DmaTableCache *cache, u32 size, u32 minAge) {
+    while (TRUE) {
+        struct DmaTableCacheEntry *free = NULL;
+        struct DmaTableCacheEntry *oldest = NULL;
+
+        for (s32 i = 0; i < DMA_TABLE_CACHE_ENTRIES; i++) {
+            struct DmaTableCacheEntry *entry = &cache->entries[i];
+            if (entry->addr == NULL) {
+                free = entry;
+            } else if (entry != cache->prefetchEntry && entry->lastUsed < minAge
+                       && (oldest == NULL || entry->lastUsed < oldest->lastUsed)) {
+                oldest = entry;
+            }
+        }
+
+        if (free != NULL) {
+            u8 *addr = dma_table_cache_find_space(cache, size);
+            if (addr != NULL) {
+                free->addr = addr;
+                free->size = size;
+                return free;
+            }
+        }
+        if (oldest == NULL) {
+            return NULL;
+        }
+        oldest->addr = NULL;
+    }
+}
+
+/**
+ * Points *entry at the given entry of the table, loading it into the cache if it isn't there yet.
+ * Returns TRUE if the entry was newly loaded and still has to be patched by the caller.
+ */
+s32 load_cached_patchable_table(struct DmaTableCache *cache, s32 index, void **entry) {
+    struct DmaTable *table = cache->dmaTable;
+    struct DmaTableCacheEntry *cached;
+
+    *entry = NULL;
+    if ((u32) index >= table->count) {
+        return FALSE;
+    }
+
+    cache->clock++;
+    cached = dma_table_cache_find(cache, index);
+    if (cached != NULL) {
+        if (cached == cache->prefetchEntry) {
+            dma_table_cache_poll_prefetch(cache, TRUE);
+        }
+        cache->hits++;
+        cached->lastUsed = cache->clock;
+        *entry = cached->addr;
+        if (cached->prefetched) {
+            cache->prefetchHits++;
+            cached->prefetched = FALSE;
+            return TRUE;
+        }
+        return FALSE;
+    }
+
+    u8 *src = table->srcAddr + table->anim[index].offset;
+    u32 size = ALIGN16(table->anim[index].size);
+
+    cached = dma_table_cache_alloc(cache, size, cache->clock);
+    if (cached == NULL) {
+        // Only the prefetch in flight is in the way.
+        dma_table_cache_poll_prefetch(cache, TRUE);
+        cached = dma_table_cache_alloc(cache, size, cache->clock);
+        if (cached == NULL) {
+            return FALSE;
+        }
+    }
+
+    dma_read(cached->addr, src, src + size);
+    cache->misses++;
+    cache->dmaBytes += size;
+    cached->index = index;
+    cached->lastUsed = cache->clock;
+    cached->prefetched = FALSE;
+    *entry = cached->addr;
+    return TRUE;
+}
+
+/**
+ * Starts loading the given entry of the table in the background, if it isn't cached yet and no other prefetch
+ * is in flight. It never evicts the entry that was used last.
+ */
+void prefetch_patchable_table(struct DmaTableCache *cache, s32 index) {
+    struct DmaTable *table = cache->dmaTable;
+    struct DmaTableCacheEntry *cached;
+
+    dma_table_cache_poll_prefetch(cache, FALSE);
+    if (cache->prefetchEntry != NULL || (u32) index >= table->count || dma_table_cache_find(cache, index) != NULL) {
+        return;
+    }
+
+    u32 size = ALIGN16(table->anim[index].size);
+    cached = dma_table_cache_alloc(cache, size, cache->clock);
+    if (cached == NULL) {
+        return;
+    }
+
+    cached->index = index;
+    cached->lastUsed = cache->clock;
+    cached->prefetched = TRUE;
+    cache->prefetches++;
+    cache->dmaBytes += size;
+
+    cache->prefetchEntry = cached;
+    cache->prefetchSrc = table->srcAddr + table->anim[index].offset;
+    cache->prefetchDest = cached->addr;
+    cache->prefetchRemaining = size;
+    osInvalDCache(cached->addr, size);
+    // Start the first chunk as if a previous one had just finished.
+    osSendMesg(&cache->prefetchMesgQueue, NULL, OS_MESG_NOBLOCK);
+    dma_table_cache_poll_prefetch(cache, FALSE);
+}
+#endif
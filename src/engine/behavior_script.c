@@ -14,6 +14,7 @@
 #include "math_util.h"
 #include "graph_node.h"
 #include "surface_collision.h"
+#include "game/puppyprint.h"
 
 // Macros for retrieving arguments from behavior scripts.
 #define BHV_CMD_GET_1ST_U8(index)     (u8)((gCurBhvCommand[index] >> 24) & 0xFF) // unused
@@ -313,7 +314,14 @@ typedef void (*NativeBhvFunc)(void);
 static s32 bhv_cmd_call_native(void) {
     NativeBhvFunc behaviorFunc = BHV_CMD_GET_VPTR_SMALL(0);
 
+#ifdef BEHAVIOR_PROFILER
+    u32 first = osGetCount();
     behaviorFunc();
+    gBehaviorNativeTime += osGetCount() - first;
+    gBehaviorNativeFunc = behaviorFunc;
+#else
+    behaviorFunc();
+#endif
 
     gCurBhvCommand++;
     return BHV_PROC_CONTINUE;
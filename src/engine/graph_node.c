@@ -784,6 +784,30 @@ s32 retrieve_animation_index(s32 frame, u16 **attributes) {
     return result;
 }
 
+/**
+ * Decode every channel of an animation at the given frame into dest in one pass.
+ * This gives the same values as calling retrieve_animation_index for each channel
+ * in order. Constant channels are stored with a length of 1, so they always read
+ * their single value.
+ */
+void geo_decode_animation_frame(s16 *dest, const s16 *values, const u16 *index, s32 frame, s32 numChannels) {
+    const u16 *end = index + (numChannels * 2);
+
+    while (index < end) {
+        s32 length = index[0];
+        s32 offset = index[1];
+
+        if (frame < length) {
+            offset += frame;
+        } else {
+            offset += length - 1;
+        }
+
+        *dest++ = values[offset];
+        index += 2;
+    }
+}
+
 /**
  * Update the animation frame of an object. The animation flags determine
  * whether it plays forwards or backwards, and whether it stops or loops at
@@ -396,6 +396,7 @@ void geo_obj_init_animation(struct GraphNodeObject *graphNode, struct Animation
 void geo_obj_init_animation_accel(struct GraphNodeObject *graphNode, struct Animation **animPtrAddr, u32 animAccel);
 
 s32  retrieve_animation_index(s32 frame, u16 **attributes);
+void geo_decode_animation_frame(s16 *dest, const s16 *values, const u16 *index, s32 frame, s32 numChannels);
 
 s32  geo_update_animation_frame(struct AnimInfo *obj, s32 *accelAssist);
 void geo_retreive_animation_translation(struct GraphNodeObject *obj, Vec3f position);
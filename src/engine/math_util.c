@@ -201,37 +201,47 @@ void mtxf_rotate_zxy_and_translate_and_mul(Vec3s rot, Vec3f trans, Mat4 dest, Ma
     MTXF_END(dest);
 }
 
-/// Build a matrix that rotates around the x axis, then the y axis, then the z axis, and then translates and multiplies.
-void mtxf_rotate_xyz_and_translate_and_mul(Vec3s rot, Vec3f trans, Mat4 dest, Mat4 src) {
-    PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.matrix);
+/// Build the rows of a rotation around the x axis, then the y axis, then the z axis.
+void mtxf_rotate_xyz_basis(Vec3f basis[3], Vec3s rot) {
     f32 sx = sins(rot[0]);
     f32 cx = coss(rot[0]);
     f32 sy = sins(rot[1]);
     f32 cy = coss(rot[1]);
     f32 sz = sins(rot[2]);
     f32 cz = coss(rot[2]);
-    Vec3f entry;
-    entry[0] = (cy * cz);
-    entry[1] = (cy * sz);
-    entry[2] = -sy;
-    linear_mtxf_mul_vec3f(src, dest[0], entry);
+    basis[0][0] = (cy * cz);
+    basis[0][1] = (cy * sz);
+    basis[0][2] = -sy;
     f32 sxcz = (sx * cz);
     f32 cxsz = (cx * sz);
-    entry[0] = ((sxcz * sy) - cxsz);
+    basis[1][0] = ((sxcz * sy) - cxsz);
     f32 sxsz = (sx * sz);
     f32 cxcz = (cx * cz);
-    entry[1] = ((sxsz * sy) + cxcz);
-    entry[2] = (sx * cy);
-    linear_mtxf_mul_vec3f(src, dest[1], entry);
-    entry[0] = ((cxcz * sy) + sxsz);
-    entry[1] = ((cxsz * sy) - sxcz);
-    entry[2] = (cx * cy);
-    linear_mtxf_mul_vec3f(src, dest[2], entry);
+    basis[1][1] = ((sxsz * sy) + cxcz);
+    basis[1][2] = (sx * cy);
+    basis[2][0] = ((cxcz * sy) + sxsz);
+    basis[2][1] = ((cxsz * sy) - sxcz);
+    basis[2][2] = (cx * cy);
+}
+
+/// Build a matrix from a rotation basis (see mtxf_rotate_xyz_basis) and a translation, and multiply it by src.
+void mtxf_mul_basis_and_translate(Mat4 dest, Mat4 src, Vec3f basis[3], Vec3f trans) {
+    PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.matrix);
+    linear_mtxf_mul_vec3f(src, dest[0], basis[0]);
+    linear_mtxf_mul_vec3f(src, dest[1], basis[1]);
+    linear_mtxf_mul_vec3f(src, dest[2], basis[2]);
     linear_mtxf_mul_vec3f(src, dest[3], trans);
     vec3f_add(dest[3], src[3]);
     MTXF_END(dest);
 }
 
+/// Build a matrix that rotates around the x axis, then the y axis, then the z axis, and then translates and multiplies.
+void mtxf_rotate_xyz_and_translate_and_mul(Vec3s rot, Vec3f trans, Mat4 dest, Mat4 src) {
+    Vec3f basis[3];
+    mtxf_rotate_xyz_basis(basis, rot);
+    mtxf_mul_basis_and_translate(dest, src, basis, trans);
+}
+
 /**
  * Set mtx to a look-at matrix for the camera. The resulting transformation
  * transforms the world as if there exists a camera at position 'from' pointed
@@ -1004,6 +1014,9 @@ f32 find_surface_on_ray(Vec3f orig, Vec3f dir, struct Surface **hit_surface, Vec
 // Especially fast for halfword floats, which get loaded with a `lui` + `mtc1`.
 static ALWAYS_INLINE float construct_float(const float f)
 {
+#ifndef TARGET_N64
+    return f;
+#else
     u32 r;
     float f_out;
     u32 i = *(u32*)(&f);
@@ -1037,6 +1050,7 @@ static ALWAYS_INLINE float construct_float(const float f)
                          : "=f"(f_out)
                          : "r"(r));
     return f_out;
+#endif
 }
 
 // Converts a floating point matrix to a fixed point matrix
@@ -76,9 +76,13 @@ extern f32 gSineTable[];
 
 // Absolute value of a float (faster than using the above macro)
 ALWAYS_INLINE f32 absf(f32 in) {
+#ifdef TARGET_N64
     f32 out;
     __asm__("abs.s %0,%1" : "=f" (out) : "f" (in));
     return out;
+#else
+    return __builtin_fabsf(in);
+#endif
 }
 
 // Get the minimum / maximum of a set of numbers
@@ -113,11 +117,16 @@ void min_max_3s(s16 a, s16 b, s16 c, s16 *min, s16 *max);
 // From Wiseguy
 // Round a float to the nearest integer
 ALWAYS_INLINE s32 roundf(f32 in) {
+#ifdef TARGET_N64
     f32 tmp;
     s32 out;
     __asm__("round.w.s %0,%1" : "=f" (tmp) : "f" (in ));
     __asm__("mfc1      %0,%1" : "=r" (out) : "f" (tmp));
     return out;
+#else
+    // Rounds to even like round.w.s does in the default rounding mode.
+    return __builtin_rintf(in);
+#endif
 }
 
 #define round_float roundf
@@ -635,6 +644,8 @@ void mtxf_rotate_zxy_and_translate(Mat4 dest, Vec3f trans, Vec3s rot);
 void mtxf_rotate_xyz_and_translate(Mat4 dest, Vec3f trans, Vec3s rot);
 void mtxf_rotate_zxy_and_translate_and_mul(Vec3s rot, Vec3f trans, Mat4 dest, Mat4 src);
 void mtxf_rotate_xyz_and_translate_and_mul(Vec3s rot, Vec3f trans, Mat4 dest, Mat4 src);
+void mtxf_rotate_xyz_basis(Vec3f basis[3], Vec3s rot);
+void mtxf_mul_basis_and_translate(Mat4 dest, Mat4 src, Vec3f basis[3], Vec3f trans);
 void mtxf_billboard(Mat4 dest, Mat4 mtx, Vec3f position, Vec3f scale, s16 angle);
 void mtxf_shadow(Mat4 dest, Vec3f upDir, Vec3f pos, Vec3f scale, s16 yaw);
 void mtxf_align_terrain_normal(Mat4 dest, Vec3f upDir, Vec3f pos, s16 yaw);
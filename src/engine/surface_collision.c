@@ -10,6 +10,35 @@
 #include "surface_load.h"
 #include "game/puppyprint.h"
 
+/**
+ * Returns the static surface list of a given type for a position,
+ * using the smaller subcell list if the cell it's in has been subdivided.
+ */
+static struct SurfaceNode *get_static_surface_list(s32 cellX, s32 cellZ, s32 x, s32 z, s32 listIndex) {
+#ifdef STATIC_SURFACE_SUBDIVISION_THRESHOLD
+    SpatialPartitionCell *subcells = gStaticSurfaceSubcells[cellZ][cellX];
+
+    if (subcells != NULL) {
+        return subcells[(GET_SUBCELL_COORD(z) * STATIC_SURFACE_SUBCELLS) + GET_SUBCELL_COORD(x)][listIndex];
+    }
+#endif
+    return gStaticSurfacePartition[cellZ][cellX][listIndex];
+}
+
+/**
+ * Cheap check against a surface's precomputed lateral bounds, done before the exact triangle checks.
+ * A point outside of the bounds can never be inside of the triangle.
+ */
+ALWAYS_INLINE static s32 check_within_surface_bounds(s32 x, s32 z, struct Surface *surf) {
+    if (x < surf->minX || x > surf->maxX || z < surf->minZ || z > surf->maxZ) {
+        PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.collision_bounds_rejected);
+        return FALSE;
+    }
+
+    PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.collision_bounds_tested);
+    return TRUE;
+}
+
 /**************************************************
  *                      WALLS                     *
  **************************************************/
@@ -70,6 +99,7 @@ static s32 find_wall_collisions_from_list(struct SurfaceNode *surfaceNode, struc
         surf        = surfaceNode->surface;
         surfaceNode = surfaceNode->next;
         type        = surf->type;
+        PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.collision_nodes);
 
         // Exclude a large number of walls immediately to optimize.
         if (pos[1] < surf->lowerY || pos[1] > surf->upperY) continue;
@@ -226,6 +256,17 @@ s32 find_wall_collisions(struct WallCollisionData *colData) {
 
             // Check for surfaces that are a part of level geometry.
             node = gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_WALLS];
+#ifdef STATIC_SURFACE_SUBDIVISION_THRESHOLD
+            // Only use a subcell if the whole radius fits inside of it, otherwise walls spanning
+            // several subcells would be checked (and push) more than once.
+            if (
+                minCellX == maxCellX && minCellZ == maxCellZ
+                && GET_SUBCELL_COORD(x - colData->radius) == GET_SUBCELL_COORD(x + colData->radius)
+                && GET_SUBCELL_COORD(z - colData->radius) == GET_SUBCELL_COORD(z + colData->radius)
+            ) {
+                node = get_static_surface_list(cellX, cellZ, x, z, SPATIAL_PARTITION_WALLS);
+            }
+#endif
             numCollisions += find_wall_collisions_from_list(node, colData);
         }
     }
@@ -308,6 +349,7 @@ static struct Surface *find_ceil_from_list(struct SurfaceNode *surfaceNode, s32
         surf = surfaceNode->surface;
         surfaceNode = surfaceNode->next;
         type = surf->type;
+        PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.collision_nodes);
 
         // Exclude all ceilings below the point
         if (y > surf->upperY) continue;
@@ -322,6 +364,9 @@ static struct Surface *find_ceil_from_list(struct SurfaceNode *surfaceNode, s32
             continue;
         }
 
+        // Exclude ceilings whose lateral bounds don't contain the point
+        if (!check_within_surface_bounds(x, z, surf)) continue;
+
         // Check that the point is within the triangle bounds
         if (!check_within_ceil_triangle_bounds(x, z, surf, 1.5f)) continue;
 
@@ -347,30 +392,14 @@ static struct Surface *find_ceil_from_list(struct SurfaceNode *surfaceNode, s32
 }
 
 /**
- * Find the lowest ceiling above a given position and return the height.
+ * Find the lowest ceiling above a given position within a cell, checking both object and level geometry.
  */
-f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
-    f32 height        = CELL_HEIGHT_LIMIT;
-    f32 dynamicHeight = CELL_HEIGHT_LIMIT;
-    PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.collision_ceil);
-    PUPPYPRINT_GET_SNAPSHOT();
-    s32 x = posX;
-    s32 y = posY;
-    s32 z = posZ;
-    *pceil = NULL;
-
-    if (is_outside_level_bounds(x, z)) {
-        profiler_collision_update(first);
-        return height;
-    }
-
-    // Each level is split into cells to limit load, find the appropriate cell.
-    s32 cellX = GET_CELL_COORD(x);
-    s32 cellZ = GET_CELL_COORD(z);
-
+static struct Surface *find_ceil_in_cell(s32 cellX, s32 cellZ, s32 x, s32 y, s32 z, f32 *pheight) {
     struct SurfaceNode *surfaceList;
     struct Surface *ceil = NULL;
     struct Surface *dynamicCeil = NULL;
+    f32 height = CELL_HEIGHT_LIMIT;
+    f32 dynamicHeight = CELL_HEIGHT_LIMIT;
 
     s32 includeDynamic = !(gCollisionFlags & COLLISION_FLAG_EXCLUDE_DYNAMIC);
 
@@ -384,7 +413,7 @@ f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
     }
 
     // Check for surfaces that are a part of level geometry.
-    surfaceList = gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_CEILS];
+    surfaceList = get_static_surface_list(cellX, cellZ, x, z, SPATIAL_PARTITION_CEILS);
     ceil = find_ceil_from_list(surfaceList, x, y, z, &height);
 
     // Use the lower ceiling.
@@ -393,6 +422,33 @@ f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
         height = dynamicHeight;
     }
 
+    *pheight = height;
+    return ceil;
+}
+
+/**
+ * Find the lowest ceiling above a given position and return the height.
+ */
+f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
+    f32 height = CELL_HEIGHT_LIMIT;
+    PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.collision_ceil);
+    PUPPYPRINT_GET_SNAPSHOT();
+    s32 x = posX;
+    s32 y = posY;
+    s32 z = posZ;
+    *pceil = NULL;
+
+    if (is_outside_level_bounds(x, z)) {
+        profiler_collision_update(first);
+        return height;
+    }
+
+    // Each level is split into cells to limit load, find the appropriate cell.
+    s32 cellX = GET_CELL_COORD(x);
+    s32 cellZ = GET_CELL_COORD(z);
+
+    struct Surface *ceil = find_ceil_in_cell(cellX, cellZ, x, y, z, &height);
+
     // To prevent accidentally leaving the floor tangible, stop checking for it.
     gCollisionFlags &= ~(COLLISION_FLAG_RETURN_FIRST | COLLISION_FLAG_EXCLUDE_DYNAMIC | COLLISION_FLAG_INCLUDE_INTANGIBLE);
 
@@ -442,6 +498,7 @@ static struct Surface *find_floor_from_list(struct SurfaceNode *surfaceNode, s32
         surf = surfaceNode->surface;
         surfaceNode = surfaceNode->next;
         type        = surf->type;
+        PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.collision_nodes);
 
         // To prevent the Merry-Go-Round room from loading when Mario passes above the hole that leads
         // there, SURFACE_INTANGIBLE is used. This prevent the wrong room from loading, but can also allow
@@ -461,6 +518,8 @@ static struct Surface *find_floor_from_list(struct SurfaceNode *surfaceNode, s32
 
         // Exclude all floors above the point.
         if (bufferY < surf->lowerY) continue;
+        // Exclude floors whose lateral bounds don't contain the point.
+        if (!check_within_surface_bounds(x, z, surf)) continue;
         // Check that the point is within the triangle bounds.
         if (!check_within_floor_triangle_bounds(x, z, surf)) continue;
 
@@ -513,6 +572,7 @@ struct Surface *find_water_floor_from_list(struct SurfaceNode *surfaceNode, s32
         // skip wall angled water
         if (surf->type != SURFACE_NEW_WATER_BOTTOM || absf(surf->normal.y) < NORMAL_FLOOR_THRESHOLD) continue;
 
+        if (!check_within_surface_bounds(x, z, surf)) continue;
         if (!check_within_bounds_y_norm(x, z, surf)) continue;
 
         curBottomHeight = get_surface_height_at_location(x, z, surf);
@@ -533,6 +593,7 @@ struct Surface *find_water_floor_from_list(struct SurfaceNode *surfaceNode, s32
         // skip water tops or wall angled water bottoms
         if (surf->type == SURFACE_NEW_WATER_BOTTOM || absf(surf->normal.y) < NORMAL_FLOOR_THRESHOLD) continue;
 
+        if (!check_within_surface_bounds(x, z, surf)) continue;
         if (!check_within_bounds_y_norm(x, z, surf)) continue;
 
         curHeight = get_surface_height_at_location(x, z, surf);
@@ -586,7 +647,7 @@ f32 find_floor_marioair(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
     }
 
     // Check for surfaces that are a part of level geometry.
-    surfaceList = gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_FLOORS];
+    surfaceList = get_static_surface_list(cellX, cellZ, x, z, SPATIAL_PARTITION_FLOORS);
     floor = find_floor_from_list(surfaceList, x, y, z, &height);
 
     if (dynamicHeight > height) {
@@ -623,35 +684,14 @@ f32 unused_find_dynamic_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfl
 }
 
 /**
- * Find the highest floor under a given position and return the height.
+ * Find the highest floor under a given position within a cell, checking both object and level geometry.
  */
-f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
-    PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.collision_floor);
-    PUPPYPRINT_GET_SNAPSHOT();
-
-    f32 height        = FLOOR_LOWER_LIMIT;
-    f32 dynamicHeight = FLOOR_LOWER_LIMIT;
-
-    //! (Parallel Universes) Because position is casted to an s16, reaching higher
-    //  float locations can return floors despite them not existing there.
-    //  (Dynamic floors will unload due to the range.)
-    s32 x = xPos;
-    s32 y = yPos;
-    s32 z = zPos;
-
-    *pfloor = NULL;
-
-    if (is_outside_level_bounds(x, z)) {
-        profiler_collision_update(first);
-        return height;
-    }
-    // Each level is split into cells to limit load, find the appropriate cell.
-    s32 cellX = GET_CELL_COORD(x);
-    s32 cellZ = GET_CELL_COORD(z);
-
+static struct Surface *find_floor_in_cell(s32 cellX, s32 cellZ, s32 x, s32 y, s32 z, f32 *pheight) {
     struct SurfaceNode *surfaceList;
     struct Surface *floor = NULL;
     struct Surface *dynamicFloor = NULL;
+    f32 height = FLOOR_LOWER_LIMIT;
+    f32 dynamicHeight = FLOOR_LOWER_LIMIT;
 
     s32 includeDynamic = !(gCollisionFlags & COLLISION_FLAG_EXCLUDE_DYNAMIC);
 
@@ -665,7 +705,7 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
     }
 
     // Check for surfaces that are a part of level geometry.
-    surfaceList = gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_FLOORS];
+    surfaceList = get_static_surface_list(cellX, cellZ, x, z, SPATIAL_PARTITION_FLOORS);
     floor = find_floor_from_list(surfaceList, x, y, z, &height);
 
     // Use the higher floor.
@@ -674,6 +714,38 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
         height = dynamicHeight;
     }
 
+    *pheight = height;
+    return floor;
+}
+
+/**
+ * Find the highest floor under a given position and return the height.
+ */
+f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
+    PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.collision_floor);
+    PUPPYPRINT_GET_SNAPSHOT();
+
+    f32 height = FLOOR_LOWER_LIMIT;
+
+    //! (Parallel Universes) Because position is casted to an s16, reaching higher
+    //  float locations can return floors despite them not existing there.
+    //  (Dynamic floors will unload due to the range.)
+    s32 x = xPos;
+    s32 y = yPos;
+    s32 z = zPos;
+
+    *pfloor = NULL;
+
+    if (is_outside_level_bounds(x, z)) {
+        profiler_collision_update(first);
+        return height;
+    }
+    // Each level is split into cells to limit load, find the appropriate cell.
+    s32 cellX = GET_CELL_COORD(x);
+    s32 cellZ = GET_CELL_COORD(z);
+
+    struct Surface *floor = find_floor_in_cell(cellX, cellZ, x, y, z, &height);
+
     // To prevent accidentally leaving the floor tangible, stop checking for it.
     gCollisionFlags &= ~(COLLISION_FLAG_RETURN_FIRST | COLLISION_FLAG_EXCLUDE_DYNAMIC | COLLISION_FLAG_INCLUDE_INTANGIBLE);
     // If a floor was missed, increment the debug counter.
@@ -715,6 +787,25 @@ s32 get_room_at_pos(f32 x, f32 y, f32 z) {
     return -1;
 }
 
+/**
+ * Find the highest water floor under a given position within a cell and return the height.
+ */
+static f32 find_water_floor_in_cell(s32 cellX, s32 cellZ, s32 x, s32 y, s32 z, struct Surface **pfloor) {
+    f32 height = FLOOR_LOWER_LIMIT;
+
+    // Check for surfaces that are a part of level geometry.
+    struct SurfaceNode *surfaceList = gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_WATER];
+    struct Surface     *floor       = find_water_floor_from_list(surfaceList, x, y, z, &height);
+
+    if (floor == NULL) {
+        height = FLOOR_LOWER_LIMIT;
+    } else {
+        *pfloor = floor;
+    }
+
+    return height;
+}
+
 /**
  * Find the highest water floor under a given position and return the height.
  */
@@ -731,15 +822,7 @@ f32 find_water_floor(s32 xPos, s32 yPos, s32 zPos, struct Surface **pfloor) {
     s32 cellX = GET_CELL_COORD(x);
     s32 cellZ = GET_CELL_COORD(z);
 
-    // Check for surfaces that are a part of level geometry.
-    struct SurfaceNode *surfaceList = gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_WATER];
-    struct Surface     *floor       = find_water_floor_from_list(surfaceList, x, y, z, &height);
-
-    if (floor == NULL) {
-        height = FLOOR_LOWER_LIMIT;
-    } else {
-        *pfloor = floor;
-    }
+    height = find_water_floor_in_cell(cellX, cellZ, x, y, z, pfloor);
 #ifdef VANILLA_DEBUG
     // Increment the debug tracker.
     gNumCalls.floor++;
@@ -791,18 +874,15 @@ s32 find_water_level_and_floor(s32 x, s32 y, s32 z, struct Surface **pfloor) {
 }
 
 /**
- * Finds the height of water at a given location.
+ * Finds the height of the first water box containing a given location.
  */
-s32 find_water_level(s32 x, s32 z) { // TODO: Allow y pos
+static s32 find_water_box_level(s32 x, s32 z) {
     s32 val;
     s32 loX, hiX, loZ, hiZ;
     TerrainData *p = gEnvironmentRegions;
-    struct Surface *floor = NULL;
-    PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.collision_water);
-    PUPPYPRINT_GET_SNAPSHOT();
-    s32 waterLevel = find_water_floor(x, ((gCollisionFlags & COLLISION_FLAG_CAMERA) ? gLakituState.pos[1] : gMarioState->pos[1]), z, &floor);
+    s32 waterLevel = FLOOR_LOWER_LIMIT;
 
-    if ((p != NULL) && (waterLevel == FLOOR_LOWER_LIMIT)) {
+    if (p != NULL) {
         s32 numRegions = *p++;
 
         for (s32 i = 0; i < numRegions; i++) {
@@ -823,6 +903,22 @@ s32 find_water_level(s32 x, s32 z) { // TODO: Allow y pos
         }
     }
 
+    return waterLevel;
+}
+
+/**
+ * Finds the height of water at a given location.
+ */
+s32 find_water_level(s32 x, s32 z) { // TODO: Allow y pos
+    struct Surface *floor = NULL;
+    PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.collision_water);
+    PUPPYPRINT_GET_SNAPSHOT();
+    s32 waterLevel = find_water_floor(x, ((gCollisionFlags & COLLISION_FLAG_CAMERA) ? gLakituState.pos[1] : gMarioState->pos[1]), z, &floor);
+
+    if (waterLevel == FLOOR_LOWER_LIMIT) {
+        waterLevel = find_water_box_level(x, z);
+    }
+
     profiler_collision_update(first);
 
     return waterLevel;
@@ -868,6 +964,84 @@ s32 find_poison_gas_level(s32 x, s32 z) {
     return gasLevel;
 }
 
+/**************************************************
+ *                 COMBINED QUERIES               *
+ **************************************************/
+
+/**
+ * Finds any combination of the floor, ceiling, water level and walls at a position at once,
+ * so the bounds check and cell lookup are only done once for all of them.
+ * The floor, ceiling and water level are found at the given position, not the position after
+ * wall pushes, and the water level is found the same way as find_water_level.
+ * @param flags Which collision to find, using RaycastFlags
+ * @param column Receives the results. Anything not requested is left as if nothing was found.
+ * @param wallData If walls are requested, this must have offsetY and radius set. The position is set to the one given, and receives the push like find_wall_collisions.
+ */
+void find_collision_column(f32 posX, f32 posY, f32 posZ, u32 flags, struct CollisionColumn *column, struct WallCollisionData *wallData) {
+    PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.collision_column);
+    s32 x = posX;
+    s32 y = posY;
+    s32 z = posZ;
+    struct Surface *waterFloor = NULL;
+
+    column->floor       = NULL;
+    column->ceil        = NULL;
+    column->floorHeight = FLOOR_LOWER_LIMIT;
+    column->ceilHeight  = CELL_HEIGHT_LIMIT;
+    column->waterLevel  = FLOOR_LOWER_LIMIT;
+
+    // Walls may span several cells, so they do their own lookups. They also clear gCollisionFlags, so preserve them for the other checks.
+    if (flags & RAYCAST_FIND_WALL) {
+        s32 collisionFlags = gCollisionFlags;
+
+        wallData->x = posX;
+        wallData->y = posY;
+        wallData->z = posZ;
+        find_wall_collisions(wallData);
+        gCollisionFlags = collisionFlags;
+    }
+
+    PUPPYPRINT_GET_SNAPSHOT();
+
+    if (!is_outside_level_bounds(x, z)) {
+        // Each level is split into cells to limit load, find the appropriate cell.
+        s32 cellX = GET_CELL_COORD(x);
+        s32 cellZ = GET_CELL_COORD(z);
+
+        if (flags & RAYCAST_FIND_FLOOR) {
+            PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.collision_floor);
+            column->floor = find_floor_in_cell(cellX, cellZ, x, y, z, &column->floorHeight);
+
+            // If a floor was missed, increment the debug counter.
+            if (column->floor == NULL) {
+                gNumFindFloorMisses++;
+            }
+        }
+
+        if (flags & RAYCAST_FIND_CEIL) {
+            PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.collision_ceil);
+            column->ceil = find_ceil_in_cell(cellX, cellZ, x, y, z, &column->ceilHeight);
+        }
+
+        if (flags & RAYCAST_FIND_WATER) {
+            PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.collision_water);
+            column->waterLevel = find_water_floor_in_cell(cellX, cellZ, x, ((gCollisionFlags & COLLISION_FLAG_CAMERA) ? gLakituState.pos[1] : gMarioState->pos[1]), z, &waterFloor);
+        }
+    } else if (flags & RAYCAST_FIND_FLOOR) {
+        gNumFindFloorMisses++;
+    }
+
+    // Water boxes aren't part of the cells, so they're still checked outside of the level bounds.
+    if ((flags & RAYCAST_FIND_WATER) && column->waterLevel == FLOOR_LOWER_LIMIT) {
+        column->waterLevel = find_water_box_level(x, z);
+    }
+
+    // To prevent accidentally leaving the floor tangible, stop checking for it.
+    gCollisionFlags &= ~(COLLISION_FLAG_RETURN_FIRST | COLLISION_FLAG_EXCLUDE_DYNAMIC | COLLISION_FLAG_INCLUDE_INTANGIBLE);
+
+    profiler_collision_update(first);
+}
+
 /**************************************************
  *                      DEBUG                     *
  **************************************************/
@@ -42,6 +42,15 @@ struct WallCollisionData {
     /*0x18*/ struct Surface *walls[MAX_REFERENCED_WALLS];
 };
 
+// Results of find_collision_column.
+struct CollisionColumn {
+    /*0x00*/ struct Surface *floor;
+    /*0x04*/ struct Surface *ceil;
+    /*0x08*/ f32 floorHeight;
+    /*0x0C*/ f32 ceilHeight;
+    /*0x10*/ s32 waterLevel;
+};
+
 s32 f32_find_wall_collision(f32 *xPtr, f32 *yPtr, f32 *zPtr, f32 offsetY, f32 radius);
 s32 find_wall_collisions(struct WallCollisionData *colData);
 void resolve_and_return_wall_collisions(Vec3f pos, f32 offset, f32 radius, struct WallCollisionData *collisionData);
@@ -60,6 +69,7 @@ s32 get_room_at_pos(f32 x, f32 y, f32 z);
 s32 find_water_level_and_floor(s32 x, s32 y, s32 z, struct Surface **pfloor);
 s32 find_water_level(s32 x, s32 z);
 s32 find_poison_gas_level(s32 x, s32 z);
+void find_collision_column(f32 posX, f32 posY, f32 posZ, u32 flags, struct CollisionColumn *column, struct WallCollisionData *wallData);
 #ifdef VANILLA_DEBUG
 void debug_surface_list_info(f32 xPos, f32 zPos);
 #endif
@@ -33,6 +33,14 @@ struct CellCoords sCellsUsed[NUM_CELLS];
 u16 sNumCellsUsed;
 u8 sClearAllCells;
 
+#ifdef STATIC_SURFACE_SUBDIVISION_THRESHOLD
+/**
+ * Subdivided static cells. Only dense cells are subdivided, so most of these are NULL.
+ */
+SpatialPartitionCell *gStaticSurfaceSubcells[NUM_CELLS][NUM_CELLS];
+u16 gNumSubdividedCells;
+#endif
+
 /**
  * Pools of data that can contain either surface nodes or surfaces.
  * The static surface pool is resized to be exactly the amount of memory needed for the level geometry.
@@ -52,14 +60,53 @@ void *gDynamicSurfacePoolEnd;
  */
 u32 gTotalStaticSurfaceData;
 
+#ifdef CACHE_DYNAMIC_SURFACES
+/**
+ * Dynamic surface nodes are allocated downwards from the end of the dynamic pool,
+ * which keeps the dynamic surfaces contiguous so they can be reused on the next frame.
+ */
+static struct SurfaceNode *sDynamicSurfaceNodePoolEnd;
+
+/**
+ * What each collision object loaded into the dynamic pool on the previous frame, in load order.
+ */
+struct DynamicSurfaceCacheEntry {
+    struct Object *object;
+    void *collisionData;
+    struct Surface *surfaces;
+    s32 numSurfaces;
+    Mat4 transform;
+};
+
+static struct DynamicSurfaceCacheEntry sDynamicSurfaceCache[DYNAMIC_SURFACE_CACHE_SIZE];
+static u16 sDynamicSurfaceCacheIndex;
+
+/**
+ * Number of dynamic surfaces that were rebuilt and reused this frame.
+ */
+u16 gNumDynamicSurfacesTransformed;
+u16 gNumDynamicSurfacesReused;
+#endif
+
 /**
  * Allocate the part of the surface node pool to contain a surface node.
  */
 static struct SurfaceNode *alloc_surface_node(u32 dynamic) {
+    struct SurfaceNode *node;
+
+#ifdef CACHE_DYNAMIC_SURFACES
+    if (dynamic) {
+        node = --sDynamicSurfaceNodePoolEnd;
+    } else {
+        node = gCurrStaticSurfacePoolEnd;
+        gCurrStaticSurfacePoolEnd = node + 1;
+    }
+#else
     struct SurfaceNode **poolEnd = (struct SurfaceNode **)(dynamic ? &gDynamicSurfacePoolEnd : &gCurrStaticSurfacePoolEnd);
 
-    struct SurfaceNode *node = *poolEnd;
+    node = *poolEnd;
     (*poolEnd)++;
+#endif
     gSurfaceNodesAllocated++;
 
     node->next = NULL;
@@ -109,53 +156,40 @@ static void clear_spatial_partition(SpatialPartitionCell *cells) {
 static void clear_static_surfaces(void) {
     gTotalStaticSurfaceData = 0;
     clear_spatial_partition(&gStaticSurfacePartition[0][0]);
+#ifdef STATIC_SURFACE_SUBDIVISION_THRESHOLD
+    bzero(gStaticSurfaceSubcells, sizeof(gStaticSurfaceSubcells));
+    gNumSubdividedCells = 0;
+#endif
 }
 
 /**
- * Add a surface to the correct cell list of surfaces.
- * @param dynamic Determines whether the surface is static or dynamic
- * @param cellX The X position of the cell in which the surface resides
- * @param cellZ The Z position of the cell in which the surface resides
- * @param surface The surface to add
+ * Returns which of a cell's lists a surface belongs to, and the direction that list is sorted in.
  */
-static void add_surface_to_cell(s32 dynamic, s32 cellX, s32 cellZ, struct Surface *surface) {
-    struct SurfaceNode **list;
-    s32 priority;
-    s32 sortDir = 1; // highest to lowest, then insertion order (water and floors)
-    s32 listIndex;
+static s32 get_surface_list_index(struct Surface *surface, s32 *sortDir) {
+    *sortDir = 1; // highest to lowest, then insertion order (water and floors)
 
     if (SURFACE_IS_NEW_WATER(surface->type)) {
-        listIndex = SPATIAL_PARTITION_WATER;
+        return SPATIAL_PARTITION_WATER;
     } else if (surface->normal.y > NORMAL_FLOOR_THRESHOLD) {
-        listIndex = SPATIAL_PARTITION_FLOORS;
+        return SPATIAL_PARTITION_FLOORS;
     } else if (surface->normal.y < NORMAL_CEIL_THRESHOLD) {
-        listIndex = SPATIAL_PARTITION_CEILS;
-        sortDir = -1; // lowest to highest, then insertion order
-    } else {
-        listIndex = SPATIAL_PARTITION_WALLS;
-        sortDir = 0; // insertion order
+        *sortDir = -1; // lowest to highest, then insertion order
+        return SPATIAL_PARTITION_CEILS;
     }
 
-    s32 surfacePriority = surface->upperY * sortDir;
-
-    struct SurfaceNode *newNode = alloc_surface_node(dynamic);
-    newNode->surface = surface;
+    *sortDir = 0; // insertion order
+    return SPATIAL_PARTITION_WALLS;
+}
 
-    if (dynamic) {
-        list = &gDynamicSurfacePartition[cellZ][cellX][listIndex];
-        if (sNumCellsUsed >= sizeof(sCellsUsed) / sizeof(struct CellCoords)) {
-            sClearAllCells = TRUE;
-        } else {
-            if (*list == NULL) {
-                sCellsUsed[sNumCellsUsed].z = cellZ;
-                sCellsUsed[sNumCellsUsed].x = cellX;
-                sCellsUsed[sNumCellsUsed].partition = listIndex;
-                sNumCellsUsed++;
-            }
-        }
-    } else {
-        list = &gStaticSurfacePartition[cellZ][cellX][listIndex];
-    }
+/**
+ * Insert a surface node into a surface list, keeping the list sorted by upperY.
+ * @param list The list to insert the node into
+ * @param newNode The node to insert
+ * @param sortDir The direction the list is sorted in
+ */
+static void insert_surface_node(struct SurfaceNode **list, struct SurfaceNode *newNode, s32 sortDir) {
+    s32 priority;
+    s32 surfacePriority = newNode->surface->upperY * sortDir;
 
     if (*list == NULL) {
         *list = newNode;
@@ -179,6 +213,77 @@ static void add_surface_to_cell(s32 dynamic, s32 cellX, s32 cellZ, struct Surfac
     curNode->next = newNode;
 }
 
+#ifdef STATIC_SURFACE_SUBDIVISION_THRESHOLD
+/**
+ * Determines the range of subcells within a cell that a surface overlaps.
+ * Works the same way as lower_cell_index and upper_cell_index, but at subcell resolution.
+ */
+static void get_surface_subcell_range(s32 cellX, s32 cellZ, struct Surface *surface, s32 *minSubX, s32 *maxSubX, s32 *minSubZ, s32 *maxSubZ) {
+    *minSubX = MAX(0, ((surface->minX + LEVEL_BOUNDARY_MAX) / SUBCELL_SIZE) - (cellX * STATIC_SURFACE_SUBCELLS));
+    *maxSubX = MIN((STATIC_SURFACE_SUBCELLS - 1), ((surface->maxX + LEVEL_BOUNDARY_MAX) / SUBCELL_SIZE) - (cellX * STATIC_SURFACE_SUBCELLS));
+    *minSubZ = MAX(0, ((surface->minZ + LEVEL_BOUNDARY_MAX) / SUBCELL_SIZE) - (cellZ * STATIC_SURFACE_SUBCELLS));
+    *maxSubZ = MIN((STATIC_SURFACE_SUBCELLS - 1), ((surface->maxZ + LEVEL_BOUNDARY_MAX) / SUBCELL_SIZE) - (cellZ * STATIC_SURFACE_SUBCELLS));
+}
+
+/**
+ * Add a static surface to every subcell of an already subdivided cell that it overlaps.
+ */
+static void add_surface_to_subcells(SpatialPartitionCell *subcells, s32 cellX, s32 cellZ, struct Surface *surface, s32 listIndex, s32 sortDir) {
+    s32 subX, subZ;
+    s32 minSubX, maxSubX, minSubZ, maxSubZ;
+
+    get_surface_subcell_range(cellX, cellZ, surface, &minSubX, &maxSubX, &minSubZ, &maxSubZ);
+
+    for (subZ = minSubZ; subZ <= maxSubZ; subZ++) {
+        for (subX = minSubX; subX <= maxSubX; subX++) {
+            struct SurfaceNode *newNode = alloc_surface_node(FALSE);
+            newNode->surface = surface;
+            insert_surface_node(&subcells[subZ * STATIC_SURFACE_SUBCELLS + subX][listIndex], newNode, sortDir);
+        }
+    }
+}
+#endif
+
+/**
+ * Add a surface to the correct cell list of surfaces.
+ * @param dynamic Determines whether the surface is static or dynamic
+ * @param cellX The X position of the cell in which the surface resides
+ * @param cellZ The Z position of the cell in which the surface resides
+ * @param surface The surface to add
+ */
+static void add_surface_to_cell(s32 dynamic, s32 cellX, s32 cellZ, struct Surface *surface) {
+    struct SurfaceNode **list;
+    s32 sortDir;
+    s32 listIndex = get_surface_list_index(surface, &sortDir);
+
+    struct SurfaceNode *newNode = alloc_surface_node(dynamic);
+    newNode->surface = surface;
+
+    if (dynamic) {
+        list = &gDynamicSurfacePartition[cellZ][cellX][listIndex];
+        if (sNumCellsUsed >= sizeof(sCellsUsed) / sizeof(struct CellCoords)) {
+            sClearAllCells = TRUE;
+        } else {
+            if (*list == NULL) {
+                sCellsUsed[sNumCellsUsed].z = cellZ;
+                sCellsUsed[sNumCellsUsed].x = cellX;
+                sCellsUsed[sNumCellsUsed].partition = listIndex;
+                sNumCellsUsed++;
+            }
+        }
+    } else {
+        list = &gStaticSurfacePartition[cellZ][cellX][listIndex];
+#ifdef STATIC_SURFACE_SUBDIVISION_THRESHOLD
+        // Surfaces added after the terrain has been loaded (e.g. static object models) must also go into the subcells.
+        if (gStaticSurfaceSubcells[cellZ][cellX] != NULL && listIndex != SPATIAL_PARTITION_WATER) {
+            add_surface_to_subcells(gStaticSurfaceSubcells[cellZ][cellX], cellX, cellZ, surface, listIndex, sortDir);
+        }
+#endif
+    }
+
+    insert_surface_node(list, newNode, sortDir);
+}
+
 /**
  * Every level is split into CELL_SIZE * CELL_SIZE cells of surfaces (to limit computing
  * time). This function determines the lower cell for a given x/z position.
@@ -226,15 +331,11 @@ static s32 upper_cell_index(s32 coord) {
  */
 static void add_surface(struct Surface *surface, s32 dynamic) {
     s32 cellZ, cellX;
-    s32 minX, maxX, minZ, maxZ;
-
-    min_max_3i(surface->vertex1[0], surface->vertex2[0], surface->vertex3[0], &minX, &maxX);
-    min_max_3i(surface->vertex1[2], surface->vertex2[2], surface->vertex3[2], &minZ, &maxZ);
 
-    s32 minCellX = lower_cell_index(minX);
-    s32 maxCellX = upper_cell_index(maxX);
-    s32 minCellZ = lower_cell_index(minZ);
-    s32 maxCellZ = upper_cell_index(maxZ);
+    s32 minCellX = lower_cell_index(surface->minX);
+    s32 maxCellX = upper_cell_index(surface->maxX);
+    s32 minCellZ = lower_cell_index(surface->minZ);
+    s32 maxCellZ = upper_cell_index(surface->maxZ);
 
     for (cellZ = minCellZ; cellZ <= maxCellZ; cellZ++) {
         for (cellX = minCellX; cellX <= maxCellX; cellX++) {
@@ -290,6 +391,10 @@ static struct Surface *read_surface_data(TerrainData *vertexData, TerrainData **
     surface->lowerY = (min - SURFACE_VERTICAL_BUFFER);
     surface->upperY = (max + SURFACE_VERTICAL_BUFFER);
 
+    // Lateral bounds, used to quickly reject surfaces before doing the exact triangle checks.
+    min_max_3s(v[0][0], v[1][0], v[2][0], &surface->minX, &surface->maxX);
+    min_max_3s(v[0][2], v[1][2], v[2][2], &surface->minZ, &surface->maxZ);
+
     return surface;
 }
 
@@ -424,6 +529,11 @@ static void load_environmental_regions(TerrainData **data) {
 void alloc_surface_pools(void) {
     gDynamicSurfacePool = main_pool_alloc(DYNAMIC_SURFACE_POOL_SIZE, MEMORY_POOL_LEFT);
     gDynamicSurfacePoolEnd = gDynamicSurfacePool;
+#ifdef CACHE_DYNAMIC_SURFACES
+    sDynamicSurfaceNodePoolEnd = (struct SurfaceNode *)((uintptr_t)gDynamicSurfacePool + DYNAMIC_SURFACE_POOL_SIZE);
+    bzero(sDynamicSurfaceCache, sizeof(sDynamicSurfaceCache));
+    sDynamicSurfaceCacheIndex = 0;
+#endif
 
     gCCMEnteredSlide = FALSE;
     reset_red_coins_collected();
@@ -486,6 +596,183 @@ u32 get_area_terrain_size(TerrainData *data) {
 #endif
 
 
+#ifdef STATIC_SURFACE_SUBDIVISION_THRESHOLD
+/**
+ * Counts the floors, ceilings and walls in a static cell.
+ */
+static s32 count_static_cell_surfaces(s32 cellX, s32 cellZ) {
+    struct SurfaceNode *node;
+    s32 count = 0;
+
+    for (s32 listIndex = SPATIAL_PARTITION_FLOORS; listIndex <= SPATIAL_PARTITION_WALLS; listIndex++) {
+        for (node = gStaticSurfacePartition[cellZ][cellX][listIndex]; node != NULL; node = node->next) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Splits a static cell into subcells. Each of the cell's lists is already sorted,
+ * so every surface is appended to the end of the subcell lists it overlaps.
+ * Water is left out, since it's only stored in the parent cell.
+ */
+static void subdivide_static_cell(s32 cellX, s32 cellZ) {
+    struct SurfaceNode *node, *newNode;
+    struct SurfaceNode *tails[NUM_SUBCELLS];
+    s32 subX, subZ, subIndex;
+    s32 minSubX, maxSubX, minSubZ, maxSubZ;
+
+    SpatialPartitionCell *subcells = gCurrStaticSurfacePoolEnd;
+    gCurrStaticSurfacePoolEnd = subcells + NUM_SUBCELLS;
+    bzero(subcells, NUM_SUBCELLS * sizeof(SpatialPartitionCell));
+
+    for (s32 listIndex = SPATIAL_PARTITION_FLOORS; listIndex <= SPATIAL_PARTITION_WALLS; listIndex++) {
+        bzero(tails, sizeof(tails));
+
+        for (node = gStaticSurfacePartition[cellZ][cellX][listIndex]; node != NULL; node = node->next) {
+            get_surface_subcell_range(cellX, cellZ, node->surface, &minSubX, &maxSubX, &minSubZ, &maxSubZ);
+
+            for (subZ = minSubZ; subZ <= maxSubZ; subZ++) {
+                for (subX = minSubX; subX <= maxSubX; subX++) {
+                    subIndex = (subZ * STATIC_SURFACE_SUBCELLS) + subX;
+
+                    newNode = alloc_surface_node(FALSE);
+                    newNode->surface = node->surface;
+
+                    if (tails[subIndex] == NULL) {
+                        subcells[subIndex][listIndex] = newNode;
+                    } else {
+                        tails[subIndex]->next = newNode;
+                    }
+                    tails[subIndex] = newNode;
+                }
+            }
+        }
+    }
+
+    gStaticSurfaceSubcells[cellZ][cellX] = subcells;
+    gNumSubdividedCells++;
+}
+
+/**
+ * Subdivide every static cell that has more than STATIC_SURFACE_SUBDIVISION_THRESHOLD surfaces in it.
+ */
+static void subdivide_dense_static_cells(void) {
+    s32 cellX, cellZ;
+
+    for (cellZ = 0; cellZ < NUM_CELLS; cellZ++) {
+        for (cellX = 0; cellX < NUM_CELLS; cellX++) {
+            if (count_static_cell_surfaces(cellX, cellZ) > STATIC_SURFACE_SUBDIVISION_THRESHOLD) {
+                subdivide_static_cell(cellX, cellZ);
+            }
+        }
+    }
+}
+#endif
+
+#ifdef COMPACT_STATIC_SURFACES
+// Write cursors into the scratch area the compacted pool is built in.
+static struct Surface *sCompactSurfaces;
+static SpatialPartitionCell *sCompactSubcells;
+static struct SurfaceNode *sCompactNodes;
+// Distance between the scratch area and the start of the pool it gets copied back to.
+static uintptr_t sCompactOffset;
+
+#define COMPACT_FINAL_ADDR(ptr) ((void *)((uintptr_t)(ptr) - sCompactOffset))
+
+/**
+ * Copy a surface into the compacted pool, if it hasn't been copied yet, and return its final address.
+ * Static surfaces never belong to an object, so the object field is used as a forwarding pointer.
+ */
+static struct Surface *compact_surface(struct Surface *surf) {
+    if (surf->object == NULL) {
+        *sCompactSurfaces = *surf;
+        surf->object = COMPACT_FINAL_ADDR(sCompactSurfaces);
+        sCompactSurfaces++;
+    }
+
+    return (struct Surface *) surf->object;
+}
+
+/**
+ * Copy a surface list into one contiguous run of nodes and return its final address.
+ */
+static struct SurfaceNode *compact_surface_list(struct SurfaceNode *node) {
+    struct SurfaceNode *newNode;
+
+    if (node == NULL) {
+        return NULL;
+    }
+
+    struct SurfaceNode *head = COMPACT_FINAL_ADDR(sCompactNodes);
+
+    while (node != NULL) {
+        newNode = sCompactNodes++;
+        newNode->surface = compact_surface(node->surface);
+        node = node->next;
+        newNode->next = ((node != NULL) ? COMPACT_FINAL_ADDR(sCompactNodes) : NULL);
+    }
+
+    return head;
+}
+
+/**
+ * Rebuild the static surface pool so that every list is contiguous, with the surfaces laid out in the order the lists use them.
+ * The new pool is built past the end of the current one, then copied back over it.
+ * @param poolSize The total size of the memory allocated for the static surface pool
+ */
+static void compact_static_surfaces(u32 poolSize) {
+    s32 cellX, cellZ, listIndex;
+    uintptr_t poolStart = (uintptr_t)gCurrStaticSurfacePool;
+    u32 usedSize = (uintptr_t)gCurrStaticSurfacePoolEnd - poolStart;
+
+    if ((usedSize * 2) > poolSize) {
+        return;
+    }
+
+    void *scratch = gCurrStaticSurfacePoolEnd;
+    sCompactOffset   = (uintptr_t)scratch - poolStart;
+    sCompactSurfaces = scratch;
+    sCompactSubcells = (SpatialPartitionCell *)(sCompactSurfaces + gSurfacesAllocated);
+#ifdef STATIC_SURFACE_SUBDIVISION_THRESHOLD
+    sCompactNodes    = (struct SurfaceNode *)(sCompactSubcells + (gNumSubdividedCells * NUM_SUBCELLS));
+#else
+    sCompactNodes    = (struct SurfaceNode *)sCompactSubcells;
+#endif
+
+    for (cellZ = 0; cellZ < NUM_CELLS; cellZ++) {
+        for (cellX = 0; cellX < NUM_CELLS; cellX++) {
+            for (listIndex = 0; listIndex < NUM_SPATIAL_PARTITIONS; listIndex++) {
+                gStaticSurfacePartition[cellZ][cellX][listIndex] = compact_surface_list(gStaticSurfacePartition[cellZ][cellX][listIndex]);
+            }
+
+#ifdef STATIC_SURFACE_SUBDIVISION_THRESHOLD
+            SpatialPartitionCell *subcells = gStaticSurfaceSubcells[cellZ][cellX];
+            if (subcells != NULL) {
+                gStaticSurfaceSubcells[cellZ][cellX] = COMPACT_FINAL_ADDR(sCompactSubcells);
+
+                for (s32 i = 0; i < NUM_SUBCELLS; i++) {
+                    for (listIndex = 0; listIndex < NUM_SPATIAL_PARTITIONS; listIndex++) {
+                        sCompactSubcells[i][listIndex] = compact_surface_list(subcells[i][listIndex]);
+                    }
+                }
+
+                sCompactSubcells += NUM_SUBCELLS;
+            }
+#endif
+        }
+    }
+
+    // The compacted pool is never larger than the original one, so the two copies can't overlap.
+    u32 compactSize = (uintptr_t)sCompactNodes - (uintptr_t)scratch;
+    memcpy(gCurrStaticSurfacePool, scratch, compactSize);
+    gCurrStaticSurfacePoolEnd = (void *)(poolStart + compactSize);
+    gSurfacesAllocated = ((uintptr_t)sCompactSurfaces - (uintptr_t)scratch) / sizeof(struct Surface);
+}
+#endif
+
 /**
  * Process the level file, loading in vertices, surfaces, some objects, and environmental
  * boxes (water, gas, JRB fog).
@@ -507,7 +794,8 @@ void load_area_terrain(s32 index, TerrainData *data, RoomData *surfaceRooms, s16
     clear_static_surfaces();
 
     // Initialise a new surface pool for this block of static surface data
-    gCurrStaticSurfacePool = main_pool_alloc(main_pool_available() - 0x10, MEMORY_POOL_LEFT);
+    u32 poolSize = main_pool_available() - 0x10;
+    gCurrStaticSurfacePool = main_pool_alloc(poolSize, MEMORY_POOL_LEFT);
     gCurrStaticSurfacePoolEnd = gCurrStaticSurfacePool;
 
     // A while loop iterating through each section of the level data. Sections of data
@@ -546,6 +834,13 @@ void load_area_terrain(s32 index, TerrainData *data, RoomData *surfaceRooms, s16
         }
     }
 
+#ifdef STATIC_SURFACE_SUBDIVISION_THRESHOLD
+    subdivide_dense_static_cells();
+#endif
+#ifdef COMPACT_STATIC_SURFACES
+    compact_static_surfaces(poolSize);
+#endif
+
     surfacePoolData = (uintptr_t)gCurrStaticSurfacePoolEnd - (uintptr_t)gCurrStaticSurfacePool;
     gTotalStaticSurfaceData += surfacePoolData;
     main_pool_realloc(gCurrStaticSurfacePool, surfacePoolData);
@@ -566,6 +861,12 @@ void clear_dynamic_surfaces(void) {
         gSurfacesAllocated = gNumStaticSurfaces;
         gSurfaceNodesAllocated = gNumStaticSurfaceNodes;
         gDynamicSurfacePoolEnd = gDynamicSurfacePool;
+#ifdef CACHE_DYNAMIC_SURFACES
+        sDynamicSurfaceNodePoolEnd = (struct SurfaceNode *)((uintptr_t)gDynamicSurfacePool + DYNAMIC_SURFACE_POOL_SIZE);
+        sDynamicSurfaceCacheIndex = 0;
+        gNumDynamicSurfacesTransformed = 0;
+        gNumDynamicSurfacesReused = 0;
+#endif
         if (sClearAllCells) {
             clear_spatial_partition(&gDynamicSurfacePartition[0][0]);
         } else {
@@ -580,22 +881,37 @@ void clear_dynamic_surfaces(void) {
 }
 
 /**
- * Applies an object's transformation to the object's vertices.
+ * Returns the amount of the dynamic surface pool in use this frame, in bytes.
  */
-void transform_object_vertices(TerrainData **data, TerrainData *vertexData) {
-    Mat4 *objectTransform = &o->transform;
-
-    register s32 numVertices = *(*data)++;
+u32 get_dynamic_surface_pool_used(void) {
+    u32 used = (uintptr_t)gDynamicSurfacePoolEnd - (uintptr_t)gDynamicSurfacePool;
+#ifdef CACHE_DYNAMIC_SURFACES
+    used += ((uintptr_t)gDynamicSurfacePool + DYNAMIC_SURFACE_POOL_SIZE) - (uintptr_t)sDynamicSurfaceNodePoolEnd;
+#endif
+    return used;
+}
 
-    register TerrainData *vertices = *data;
+/**
+ * Builds the matrix used to transform the current object's collision vertices.
+ */
+static void get_object_collision_transform(Mat4 dest) {
+    Mat4 *objectTransform = &o->transform;
 
     if (o->header.gfx.throwMatrix == NULL) {
         o->header.gfx.throwMatrix = objectTransform;
         obj_build_transform_from_pos_and_angle(o, O_POS_INDEX, O_FACE_ANGLE_INDEX);
     }
 
-    Mat4 transform;
-    mtxf_scale_vec3f(transform, *objectTransform, o->header.gfx.scale);
+    mtxf_scale_vec3f(dest, *objectTransform, o->header.gfx.scale);
+}
+
+/**
+ * Applies a transformation to the object's vertices.
+ */
+static void transform_object_vertices_with(TerrainData **data, TerrainData *vertexData, Mat4 transform) {
+    register s32 numVertices = *(*data)++;
+
+    register TerrainData *vertices = *data;
 
     // Go through all vertices, rotating and translating them to transform the object.
     Vec3f pos;
@@ -612,6 +928,16 @@ void transform_object_vertices(TerrainData **data, TerrainData *vertexData) {
     *data = vertices;
 }
 
+/**
+ * Applies an object's transformation to the object's vertices.
+ */
+void transform_object_vertices(TerrainData **data, TerrainData *vertexData) {
+    Mat4 transform;
+
+    get_object_collision_transform(transform);
+    transform_object_vertices_with(data, vertexData, transform);
+}
+
 /**
  * Load in the surfaces for the o. This includes setting the flags, exertion, and room.
  */
@@ -686,6 +1012,60 @@ static void get_optimal_coll_dist(struct Object *obj) {
 
 static TerrainData sVertexData[600];
 
+#ifdef CACHE_DYNAMIC_SURFACES
+/**
+ * Load the current object's dynamic surfaces, reusing the ones it built last frame if nothing has changed.
+ * This is the case when the object is at the same place in the load order, its surfaces start at the same
+ * place in the pool, and its collision transform is bit-for-bit identical.
+ */
+static void load_object_surfaces_cached(TerrainData **data) {
+    struct DynamicSurfaceCacheEntry *entry = NULL;
+    struct Surface *surfaces = gDynamicSurfacePoolEnd;
+    Mat4 transform;
+    s32 i;
+
+    get_object_collision_transform(transform);
+
+    if (sDynamicSurfaceCacheIndex < DYNAMIC_SURFACE_CACHE_SIZE) {
+        entry = &sDynamicSurfaceCache[sDynamicSurfaceCacheIndex++];
+
+        if (entry->object == o
+            && entry->collisionData == o->collisionData
+            && entry->surfaces == surfaces
+            && memcmp(entry->transform, transform, sizeof(Mat4)) == 0
+        ) {
+            // The surfaces from last frame are still in place, so they only need to be relinked.
+            gDynamicSurfacePoolEnd = surfaces + entry->numSurfaces;
+            gSurfacesAllocated += entry->numSurfaces;
+            gNumDynamicSurfacesReused += entry->numSurfaces;
+
+            for (i = 0; i < entry->numSurfaces; i++) {
+                add_surface(&surfaces[i], TRUE);
+            }
+            return;
+        }
+    }
+
+    transform_object_vertices_with(data, sVertexData, transform);
+
+    // TERRAIN_LOAD_CONTINUE acts as an "end" to the terrain data.
+    while (**data != TERRAIN_LOAD_CONTINUE) {
+        load_object_surfaces(data, sVertexData, TRUE);
+    }
+
+    s32 numSurfaces = ((struct Surface *)gDynamicSurfacePoolEnd - surfaces);
+    gNumDynamicSurfacesTransformed += numSurfaces;
+
+    if (entry != NULL) {
+        entry->object = o;
+        entry->collisionData = o->collisionData;
+        entry->surfaces = surfaces;
+        entry->numSurfaces = numSurfaces;
+        mtxf_copy(entry->transform, transform);
+    }
+}
+#endif
+
 /**
  * Transform an object's vertices, reload them, and render the object.
  */
@@ -724,12 +1104,16 @@ void load_object_collision_model(void) {
         && !(o->activeFlags & ACTIVE_FLAG_IN_DIFFERENT_ROOM)
     ) {
         collisionData++;
+#ifdef CACHE_DYNAMIC_SURFACES
+        load_object_surfaces_cached(&collisionData);
+#else
         transform_object_vertices(&collisionData, sVertexData);
 
         // TERRAIN_LOAD_CONTINUE acts as an "end" to the terrain data.
         while (*collisionData != TERRAIN_LOAD_CONTINUE) {
             load_object_surfaces(&collisionData, sVertexData, TRUE);
         }
+#endif
     }
 
     f32 marioDist = o->oDistanceToMario;
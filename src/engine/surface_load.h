@@ -35,11 +35,35 @@ typedef struct SurfaceNode *SpatialPartitionCell[NUM_SPATIAL_PARTITIONS];
 
 extern SpatialPartitionCell gStaticSurfacePartition[NUM_CELLS][NUM_CELLS];
 extern SpatialPartitionCell gDynamicSurfacePartition[NUM_CELLS][NUM_CELLS];
+
+#ifdef STATIC_SURFACE_SUBDIVISION_THRESHOLD
+STATIC_ASSERT((STATIC_SURFACE_SUBCELLS >= 2) && ((STATIC_SURFACE_SUBCELLS & (STATIC_SURFACE_SUBCELLS - 1)) == 0), "STATIC_SURFACE_SUBCELLS must be a power of two!");
+
+#define NUM_SUBCELLS (STATIC_SURFACE_SUBCELLS * STATIC_SURFACE_SUBCELLS)
+#define SUBCELL_SIZE (CELL_SIZE / STATIC_SURFACE_SUBCELLS)
+
+/**
+ * Use this to convert game units to subcell coordinates within their cell.
+ */
+#define GET_SUBCELL_COORD(p) (((((s32)(p) + LEVEL_BOUNDARY_MAX) & (CELL_SIZE - 1))) / SUBCELL_SIZE)
+
+/**
+ * Dense static cells point to an array of NUM_SUBCELLS smaller cells, indexed by [subZ * STATIC_SURFACE_SUBCELLS + subX].
+ * Cells that weren't subdivided are NULL.
+ */
+extern SpatialPartitionCell *gStaticSurfaceSubcells[NUM_CELLS][NUM_CELLS];
+extern u16 gNumSubdividedCells;
+#endif
+
 extern void *gCurrStaticSurfacePool;
 extern void *gDynamicSurfacePool;
 extern void *gCurrStaticSurfacePoolEnd;
 extern void *gDynamicSurfacePoolEnd;
 extern u32 gTotalStaticSurfaceData;
+#ifdef CACHE_DYNAMIC_SURFACES
+extern u16 gNumDynamicSurfacesTransformed;
+extern u16 gNumDynamicSurfacesReused;
+#endif
 
 void alloc_surface_pools(void);
 #ifdef NO_SEGMENTED_MEMORY
@@ -47,6 +71,7 @@ u32 get_area_terrain_size(TerrainData *data);
 #endif
 void load_area_terrain(s32 index, TerrainData *data, RoomData *surfaceRooms, MacroObject *macroObjects);
 void clear_dynamic_surfaces(void);
+u32 get_dynamic_surface_pool_used(void);
 void load_object_collision_model(void);
 void load_object_static_model(void);
 
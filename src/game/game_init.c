@@ -30,6 +30,8 @@
 #include "debug_box.h"
 #include "vc_ultra.h"
 #include "profiling.h"
+#include "sampling_profiler.h"
+#include "gfx_pool_stats.h"
 #include "emutest.h"
 
 // Emulators that the Instant Input patch should not be applied to
@@ -72,6 +74,9 @@ uintptr_t gPhysicalZBuffer;
 void *gMarioAnimsMemAlloc;
 void *gDemoInputsMemAlloc;
 struct DmaHandlerList gMarioAnimsBuf;
+#ifdef MARIO_ANIM_CACHE
+struct DmaTableCache gMarioAnimCache;
+#endif
 struct DmaHandlerList gDemoInputsBuf;
 
 // General timer that runs as the game starts
@@ -743,7 +748,11 @@ void setup_game_memory(void) {
     // Setup Mario Animations
     gMarioAnimsMemAlloc = main_pool_alloc(MARIO_ANIMS_POOL_SIZE, MEMORY_POOL_LEFT);
     set_segment_base_addr(SEGMENT_MARIO_ANIMS, (void *) gMarioAnimsMemAlloc);
+#ifdef MARIO_ANIM_CACHE
+    setup_dma_table_cache(&gMarioAnimCache, gMarioAnims, gMarioAnimsMemAlloc, MARIO_ANIMS_POOL_SIZE);
+#else
     setup_dma_table_list(&gMarioAnimsBuf, gMarioAnims, gMarioAnimsMemAlloc);
+#endif
 #ifdef PUPPYPRINT_DEBUG
     set_segment_memory_printout(SEGMENT_MARIO_ANIMS, MARIO_ANIMS_POOL_SIZE);
     set_segment_memory_printout(SEGMENT_DEMO_INPUTS, DEMO_INPUTS_POOL_SIZE);
@@ -822,6 +831,8 @@ void thread5_game_loop(UNUSED void *arg) {
 #ifdef PUPPYPRINT_DEBUG
         puppyprint_profiler_process();
 #endif
+        sampling_profiler_update();
+        gfx_pool_stats_update();
 
         display_and_vsync();
 #ifdef VANILLA_DEBUG
@@ -10,7 +10,11 @@
 #include "memory.h"
 #include "config.h"
 
+#ifdef MARIO_ANIM_CACHE
+#define MARIO_ANIMS_POOL_SIZE MARIO_ANIM_CACHE
+#else
 #define MARIO_ANIMS_POOL_SIZE 0x4000
+#endif
 #define DEMO_INPUTS_POOL_SIZE 0x800
 
 struct GfxPool {
@@ -72,6 +76,9 @@ extern struct DemoInput gRecordedDemoInput;
 // this area is the demo input + the header. when the demo is loaded in, there is a header the size
 // of a single word next to the input list. this word is the current ID count.
 extern struct DmaHandlerList gMarioAnimsBuf;
+#ifdef MARIO_ANIM_CACHE
+extern struct DmaTableCache gMarioAnimCache;
+#endif
 extern struct DmaHandlerList gDemoInputsBuf;
 
 extern u8 gMarioAnims[];
@@ -0,0 +1,99 @@
+#include <ultra64.h>
+
+#include "sm64.h"
+#include "game_init.h"
+#include "gfx_pool_stats.h"
+
+#ifdef GFX_POOL_STATS
+
+#ifdef UNF
+#include "printf.h"
+#include "usb/debug.h"
+#endif
+
+/**
+ * Session statistics for the gfx pool, to help size GFX_POOL_SIZE.
+ * Counters are added to gGfxPoolFrameCounts while a frame is built, then folded into the
+ * minimum, maximum and total of each statistic once the master display list is finished.
+ */
+
+u32 gGfxPoolFrameCounts[GFX_POOL_STAT_COUNT];
+struct GfxPoolStat gGfxPoolStats[GFX_POOL_STAT_COUNT];
+u32 gGfxPoolNumFrames = 0;
+u32 gGfxPoolSkippedLayers = 0;
+u32 gGfxPoolFailedAllocations = 0;
+
+static const char *sGfxPoolStatNames[GFX_POOL_STAT_DISPLAY_LISTS] = {
+    [GFX_POOL_STAT_USED]        = "used",
+    [GFX_POOL_STAT_COMMANDS]    = "commands",
+    [GFX_POOL_STAT_ALLOCATED]   = "allocated",
+    [GFX_POOL_STAT_ALLOCATIONS] = "allocations",
+    [GFX_POOL_STAT_MATRICES]    = "matrices",
+};
+
+u32 gfx_pool_stats_average(enum GfxPoolStatType stat) {
+    if (gGfxPoolNumFrames == 0) {
+        return 0;
+    }
+    return gGfxPoolStats[stat].total / gGfxPoolNumFrames;
+}
+
+void gfx_pool_stats_reset(void) {
+    bzero(gGfxPoolStats, sizeof(gGfxPoolStats));
+    gGfxPoolNumFrames = 0;
+    gGfxPoolSkippedLayers = 0;
+    gGfxPoolFailedAllocations = 0;
+}
+
+/**
+ * Prints the session statistics over USB, one line per statistic and one per layer, in bytes or counts.
+ */
+void gfx_pool_stats_dump(void) {
+#ifdef UNF
+    s32 i;
+
+    debug_printf("GFXPOOL BEGIN %d %d %d %d %d\n", gGfxPoolNumFrames, (s32) (GFX_POOL_SIZE * sizeof(Gfx)),
+                 (s32) (GFX_POOL_RESERVE * sizeof(Gfx)), gGfxPoolSkippedLayers, gGfxPoolFailedAllocations);
+    for (i = 0; i < GFX_POOL_STAT_DISPLAY_LISTS; i++) {
+        debug_printf("S %s %d %d %d\n", sGfxPoolStatNames[i], gGfxPoolStats[i].min, gfx_pool_stats_average(i), gGfxPoolStats[i].max);
+    }
+    for (i = 0; i < LAYER_COUNT; i++) {
+        struct GfxPoolStat *stat = &gGfxPoolStats[GFX_POOL_STAT_DISPLAY_LISTS + i];
+        debug_printf("L %d %d %d %d\n", i, stat->min, gfx_pool_stats_average(GFX_POOL_STAT_DISPLAY_LISTS + i), stat->max);
+    }
+    debug_printf("GFXPOOL END\n");
+#endif
+}
+
+/**
+ * Called once the master display list is finished. Press L + D-Pad Right to dump the statistics.
+ */
+void gfx_pool_stats_update(void) {
+    u32 commands = (u8 *) gDisplayListHead - (u8 *) gGfxPool->buffer;
+    u32 allocated = (u8 *) (gGfxPool->buffer + GFX_POOL_SIZE) - gGfxPoolEnd;
+
+    gGfxPoolFrameCounts[GFX_POOL_STAT_USED] = commands + allocated;
+    gGfxPoolFrameCounts[GFX_POOL_STAT_COMMANDS] = commands;
+    gGfxPoolFrameCounts[GFX_POOL_STAT_ALLOCATED] = allocated;
+
+    for (s32 i = 0; i < GFX_POOL_STAT_COUNT; i++) {
+        struct GfxPoolStat *stat = &gGfxPoolStats[i];
+        u32 count = gGfxPoolFrameCounts[i];
+
+        if (gGfxPoolNumFrames == 0 || count < stat->min) {
+            stat->min = count;
+        }
+        if (count > stat->max) {
+            stat->max = count;
+        }
+        stat->total += count;
+        gGfxPoolFrameCounts[i] = 0;
+    }
+    gGfxPoolNumFrames++;
+
+    if ((gPlayer1Controller->buttonPressed & (L_TRIG | R_JPAD)) && (gPlayer1Controller->buttonDown & L_TRIG) && (gPlayer1Controller->buttonDown & R_JPAD)) {
+        gfx_pool_stats_dump();
+    }
+}
+
+#endif
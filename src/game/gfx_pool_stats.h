@@ -0,0 +1,47 @@
+#ifndef GFX_POOL_STATS_H
+#define GFX_POOL_STATS_H
+
+#include <PR/ultratypes.h>
+
+#include "config.h"
+#include "sm64.h"
+
+#ifdef GFX_POOL_STATS
+enum GfxPoolStatType {
+    GFX_POOL_STAT_USED,         // Bytes of the pool used, from both ends.
+    GFX_POOL_STAT_COMMANDS,     // Bytes of commands written through gDisplayListHead.
+    GFX_POOL_STAT_ALLOCATED,    // Bytes allocated from the end of the pool by alloc_display_list.
+    GFX_POOL_STAT_ALLOCATIONS,
+    GFX_POOL_STAT_MATRICES,
+    GFX_POOL_STAT_DISPLAY_LISTS, // One entry per layer.
+    GFX_POOL_STAT_COUNT = GFX_POOL_STAT_DISPLAY_LISTS + LAYER_COUNT,
+};
+
+struct GfxPoolStat {
+    u32 min;
+    u32 max;
+    u64 total;
+};
+
+extern u32 gGfxPoolFrameCounts[GFX_POOL_STAT_COUNT];
+extern struct GfxPoolStat gGfxPoolStats[GFX_POOL_STAT_COUNT];
+extern u32 gGfxPoolNumFrames;
+extern u32 gGfxPoolSkippedLayers;
+extern u32 gGfxPoolFailedAllocations;
+
+#define GFX_POOL_STATS_ADD(stat, amount) (gGfxPoolFrameCounts[stat] += (amount))
+#define GFX_POOL_STATS_EVENT(counter) ((counter)++)
+
+u32 gfx_pool_stats_average(enum GfxPoolStatType stat);
+void gfx_pool_stats_reset(void);
+void gfx_pool_stats_dump(void);
+void gfx_pool_stats_update(void);
+#else
+#define GFX_POOL_STATS_ADD(stat, amount)
+#define GFX_POOL_STATS_EVENT(counter)
+#define gfx_pool_stats_reset()
+#define gfx_pool_stats_dump()
+#define gfx_pool_stats_update()
+#endif
+
+#endif // GFX_POOL_STATS_H
@@ -1319,6 +1319,14 @@ s32 init_level(void) {
     }
 
     append_puppyprint_log("Level loaded in %d" PP_CYCLE_STRING ".", (s32)(PP_CYCLE_CONV(osGetTime() - first)));
+#ifdef PUPPYPRINT_DEBUG
+    if (gSegmentLoadStats.segments != 0) {
+        append_puppyprint_log("%d segments, %dKB in %d" PP_CYCLE_STRING " (%d" PP_CYCLE_STRING " reading).",
+                              gSegmentLoadStats.segments, gSegmentLoadStats.decompressedBytes / 1024,
+                              (s32)(PP_CYCLE_CONV(gSegmentLoadStats.time)), (s32)(PP_CYCLE_CONV(gSegmentLoadStats.readTime)));
+        bzero(&gSegmentLoadStats, sizeof(gSegmentLoadStats));
+    }
+#endif
     return TRUE;
 }
 
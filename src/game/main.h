@@ -27,6 +27,7 @@ enum ThreadID {
     THREAD_7_HVQM,
     THREAD_8_TIMEKEEPER,
     THREAD_9_DA_COUNTER,
+    THREAD_10_SAMPLING_PROFILER,
 };
 
 struct RumbleData {
@@ -6,6 +6,9 @@
 
 #define STACK_TRAVERSAL_LIMIT 100
 
+// Must match INDEX_STRIDE in tools/mapPacker.py.
+#define MAP_INDEX_STRIDE 32
+
 struct MapEntry {
 	u32 addr;
 	u32 nm_offset;
@@ -15,6 +18,9 @@ struct MapEntry {
 extern u8 gMapStrings[];
 extern struct MapEntry gMapEntries[];
 extern u32 gMapEntrySize;
+// The address of every MAP_INDEX_STRIDE'th entry, so most of the search stays in a small table.
+extern u32 gMapIndex[];
+extern u32 gMapIndexSize;
 extern u8 _mapDataSegmentRomStart[];
 
 
@@ -41,18 +47,43 @@ void map_data_init(void) {
 	while (headless_pi_status() & (PI_STATUS_DMA_BUSY | PI_STATUS_ERROR));
 }
 
+/**
+ * Finds the name of the function containing pc, which is the last symbol at or before it.
+ * The entries are sorted by address, so the index is binary searched for the block, then the block for the entry.
+ */
 char *parse_map(u32 pc) {
-	u32 i;
+	u32 lo, hi, mid;
 
-	for (i = 0; i < gMapEntrySize; i++) {
-		if (gMapEntries[i].addr >= pc) break;
+	if (gMapEntrySize == 0 || pc < gMapEntries[0].addr) {
+		return NULL;
 	}
 
-	if (i == gMapEntrySize - 1) {
-		return NULL;
-	} else {
-		return (char*) ((u32)gMapStrings + gMapEntries[i - 1].nm_offset);
+	lo = 0;
+	hi = gMapIndexSize;
+	while (hi - lo > 1) {
+		mid = (lo + hi) / 2;
+		if (gMapIndex[mid] <= pc) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
 	}
+
+	lo *= MAP_INDEX_STRIDE;
+	hi = lo + MAP_INDEX_STRIDE;
+	if (hi > gMapEntrySize) {
+		hi = gMapEntrySize;
+	}
+	while (hi - lo > 1) {
+		mid = (lo + hi) / 2;
+		if (gMapEntries[mid].addr <= pc) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return (char *) &gMapStrings[gMapEntries[lo].nm_offset];
 }
 
 extern u8 _mainSegmentStart[];
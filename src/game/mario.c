@@ -57,16 +57,59 @@ s32 is_anim_past_end(struct MarioState *m) {
 }
 
 /**
- * Sets Mario's animation without any acceleration, running at its default rate.
+ * Returns Mario's animation targetAnimID, loading it from ROM if it isn't in RAM yet.
  */
-s16 set_mario_animation(struct MarioState *m, s32 targetAnimID) {
-    struct Object *marioObj = m->marioObj;
+static struct Animation *load_mario_animation(struct MarioState *m, s32 targetAnimID) {
+#ifdef MARIO_ANIM_CACHE
+    struct Animation *targetAnim;
+    s32 loaded = load_cached_patchable_table(&gMarioAnimCache, targetAnimID, (void **) &targetAnim);
+
+    if (targetAnim == NULL) {
+        return m->marioObj->header.gfx.animInfo.curAnim;
+    }
+#else
     struct Animation *targetAnim = m->animList->bufTarget;
+    s32 loaded = load_patchable_table(m->animList, targetAnimID);
+#endif
 
-    if (load_patchable_table(m->animList, targetAnimID)) {
+    if (loaded) {
         targetAnim->values = (void *) VIRTUAL_TO_PHYSICAL((u8 *) targetAnim + (uintptr_t) targetAnim->values);
         targetAnim->index  = (void *) VIRTUAL_TO_PHYSICAL((u8 *) targetAnim + (uintptr_t) targetAnim->index);
     }
+    return targetAnim;
+}
+
+#ifdef MARIO_ANIM_CACHE
+#define NUM_PREFETCHED_ANIMS 4
+
+// Animations that Mario usually switches to from each action group.
+static const s16 sPrefetchedMarioAnims[][NUM_PREFETCHED_ANIMS] = {
+    [ACT_GROUP_STATIONARY >> 6] = { MARIO_ANIM_START_TIPTOE, MARIO_ANIM_WALKING, MARIO_ANIM_SINGLE_JUMP, MARIO_ANIM_START_CROUCHING },
+    [ACT_GROUP_MOVING     >> 6] = { MARIO_ANIM_RUNNING, MARIO_ANIM_SKID_ON_GROUND, MARIO_ANIM_STOP_SKID, MARIO_ANIM_SINGLE_JUMP },
+    [ACT_GROUP_AIRBORNE   >> 6] = { MARIO_ANIM_GENERAL_FALL, MARIO_ANIM_LAND_FROM_SINGLE_JUMP, MARIO_ANIM_DOUBLE_JUMP_RISE, MARIO_ANIM_RUNNING },
+    [ACT_GROUP_SUBMERGED  >> 6] = { MARIO_ANIM_WATER_IDLE, MARIO_ANIM_SWIM_PART1, MARIO_ANIM_FLUTTERKICK, MARIO_ANIM_GENERAL_FALL },
+};
+
+/**
+ * Starts loading an animation that is likely to come next, so changing to it doesn't have to wait for the DMA.
+ */
+static void prefetch_mario_animations(struct MarioState *m) {
+    u32 group = (m->action & ACT_GROUP_MASK) >> 6;
+
+    if (group < ARRAY_COUNT(sPrefetchedMarioAnims)) {
+        for (s32 i = 0; i < NUM_PREFETCHED_ANIMS; i++) {
+            prefetch_patchable_table(&gMarioAnimCache, sPrefetchedMarioAnims[group][i]);
+        }
+    }
+}
+#endif
+
+/**
+ * Sets Mario's animation without any acceleration, running at its default rate.
+ */
+s16 set_mario_animation(struct MarioState *m, s32 targetAnimID) {
+    struct Object *marioObj = m->marioObj;
+    struct Animation *targetAnim = load_mario_animation(m, targetAnimID);
 
     if (marioObj->header.gfx.animInfo.animID != targetAnimID) {
         marioObj->header.gfx.animInfo.animID = targetAnimID;
@@ -94,12 +137,7 @@ s16 set_mario_animation(struct MarioState *m, s32 targetAnimID) {
  */
 s16 set_mario_anim_with_accel(struct MarioState *m, s32 targetAnimID, s32 accel) {
     struct Object *marioObj = m->marioObj;
-    struct Animation *targetAnim = m->animList->bufTarget;
-
-    if (load_patchable_table(m->animList, targetAnimID)) {
-        targetAnim->values = (void *) VIRTUAL_TO_PHYSICAL((u8 *) targetAnim + (uintptr_t) targetAnim->values);
-        targetAnim->index = (void *) VIRTUAL_TO_PHYSICAL((u8 *) targetAnim + (uintptr_t) targetAnim->index);
-    }
+    struct Animation *targetAnim = load_mario_animation(m, targetAnimID);
 
     if (marioObj->header.gfx.animInfo.animID != targetAnimID) {
         marioObj->header.gfx.animInfo.animID = targetAnimID;
@@ -1770,6 +1808,9 @@ s32 execute_mario_action(UNUSED struct Object *obj) {
             }
         }
 
+#ifdef MARIO_ANIM_CACHE
+        prefetch_mario_animations(gMarioState);
+#endif
         sink_mario_in_quicksand(gMarioState);
         squish_mario_model(gMarioState);
         set_submerged_cam_preset_and_spawn_bubbles(gMarioState);
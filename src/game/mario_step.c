@@ -21,6 +21,10 @@ struct Surface gWaterSurfacePseudoFloor = {
      0,                         // room
     -SURFACE_VERTICAL_BUFFER,   // lowerY
      SURFACE_VERTICAL_BUFFER,   // upperY
+     0,                         // minX
+     0,                         // maxX
+     0,                         // minZ
+     0,                         // maxZ
     { 0, 0, 0 },                // vertex1
     { 0, 0, 0 },                // vertex2
     { 0, 0, 0 },                // vertex3
@@ -38,6 +38,44 @@ struct DmaHandlerList {
     void *bufTarget;
 };
 
+#ifdef MARIO_ANIM_CACHE
+#define DMA_TABLE_CACHE_ENTRIES 48
+
+struct DmaTableCacheEntry {
+    u8 *addr; // Where the entry is in the cache's buffer, or NULL if the entry is empty.
+    u32 size;
+    u32 lastUsed;
+    s16 index;
+    u8 prefetched; // Loaded ahead of time and not returned yet, so the caller still has to patch it.
+};
+
+/**
+ * Keeps recently used entries of a DMA table in one buffer, evicting the least recently used ones when it fills up.
+ * One entry at a time can be loaded ahead of time in the background.
+ */
+struct DmaTableCache {
+    struct DmaTable *dmaTable;
+    u8 *buffer;
+    u32 bufferSize;
+    u32 clock;
+    struct DmaTableCacheEntry entries[DMA_TABLE_CACHE_ENTRIES];
+    // The prefetch in flight, which is copied in chunks like dma_read.
+    struct DmaTableCacheEntry *prefetchEntry;
+    u8 *prefetchSrc;
+    u8 *prefetchDest;
+    u32 prefetchRemaining;
+    OSIoMesg prefetchIoMesg;
+    OSMesgQueue prefetchMesgQueue;
+    OSMesg prefetchMesgBuf;
+    // Statistics
+    u32 hits;
+    u32 misses;
+    u32 prefetches;
+    u32 prefetchHits;
+    u32 dmaBytes;
+};
+#endif
+
 #define EFFECTS_MEMORY_POOL 0x4000
 
 extern struct MemoryPool *gEffectsMemoryPool;
@@ -56,6 +94,19 @@ u32 main_pool_available(void);
 u32 main_pool_push_state(void);
 u32 main_pool_pop_state(void);
 
+#ifdef PUPPYPRINT_DEBUG
+// Totals for the compressed segments loaded since the last level load was logged.
+struct SegmentLoadStats {
+    u32 segments;
+    u32 compressedBytes;
+    u32 decompressedBytes;
+    OSTime time;
+    OSTime readTime; // Time spent reading from ROM rather than decompressing.
+};
+
+extern struct SegmentLoadStats gSegmentLoadStats;
+#endif
+
 #ifndef NO_SEGMENTED_MEMORY
 void *load_segment(s32 segment, u8 *srcStart, u8 *srcEnd, u32 side, u8 *bssStart, u8 *bssEnd);
 void *load_to_fixed_pool_addr(u8 *destAddr, u8 *srcStart, u8 *srcEnd);
@@ -79,5 +130,10 @@ void mem_pool_free(struct MemoryPool *pool, void *addr);
 void *alloc_display_list(u32 size);
 void setup_dma_table_list(struct DmaHandlerList *list, void *srcAddr, void *buffer);
 s32 load_patchable_table(struct DmaHandlerList *list, s32 index);
+#ifdef MARIO_ANIM_CACHE
+void setup_dma_table_cache(struct DmaTableCache *cache, void *srcAddr, void *buffer, u32 size);
+s32 load_cached_patchable_table(struct DmaTableCache *cache, s32 index, void **entry);
+void prefetch_patchable_table(struct DmaTableCache *cache, s32 index);
+#endif
 
 #endif // MEMORY_H
@@ -120,26 +120,19 @@ void turn_obj_away_from_surface(f32 velX, f32 velZ, f32 nX, UNUSED f32 nY, f32 n
 }
 
 /**
- * Finds any wall collisions, applies them, and turns away from the surface.
+ * Applies the wall collisions found for an object's hitbox, and turns away from the surface.
  */
-s8 obj_find_wall(f32 objNewX, f32 objY, f32 objNewZ, f32 objVelX, f32 objVelZ) {
-    struct WallCollisionData hitbox;
+static s8 obj_resolve_wall_hitbox(struct WallCollisionData *hitbox, f32 objVelX, f32 objVelZ) {
     f32 wall_nX, wall_nY, wall_nZ, objVelXCopy, objVelZCopy, objYawX, objYawZ;
 
-    hitbox.x = objNewX;
-    hitbox.y = objY;
-    hitbox.z = objNewZ;
-    hitbox.offsetY = o->hitboxHeight / 2;
-    hitbox.radius = o->hitboxRadius;
+    if (hitbox->numWalls != 0) {
+        o->oPosX = hitbox->x;
+        o->oPosY = hitbox->y;
+        o->oPosZ = hitbox->z;
 
-    if (find_wall_collisions(&hitbox) != 0) {
-        o->oPosX = hitbox.x;
-        o->oPosY = hitbox.y;
-        o->oPosZ = hitbox.z;
-
-        wall_nX = hitbox.walls[0]->normal.x;
-        wall_nY = hitbox.walls[0]->normal.y;
-        wall_nZ = hitbox.walls[0]->normal.z;
+        wall_nX = hitbox->walls[0]->normal.x;
+        wall_nY = hitbox->walls[0]->normal.y;
+        wall_nZ = hitbox->walls[0]->normal.z;
 
         objVelXCopy = objVelX;
         objVelZCopy = objVelZ;
@@ -154,6 +147,23 @@ s8 obj_find_wall(f32 objNewX, f32 objY, f32 objNewZ, f32 objVelX, f32 objVelZ) {
     return TRUE;
 }
 
+/**
+ * Finds any wall collisions, applies them, and turns away from the surface.
+ */
+s8 obj_find_wall(f32 objNewX, f32 objY, f32 objNewZ, f32 objVelX, f32 objVelZ) {
+    struct WallCollisionData hitbox;
+
+    hitbox.x = objNewX;
+    hitbox.y = objY;
+    hitbox.z = objNewZ;
+    hitbox.offsetY = o->hitboxHeight / 2;
+    hitbox.radius = o->hitboxRadius;
+
+    find_wall_collisions(&hitbox);
+
+    return obj_resolve_wall_hitbox(&hitbox, objVelX, objVelZ);
+}
+
 /**
  * Turns an object away from steep floors, similarly to walls.
  */
@@ -373,18 +383,27 @@ s16 object_step(void) {
 
     s16 collisionFlags = 0;
 
-    // Find any wall collisions, receive the push, and set the flag.
-    if (obj_find_wall(objX + objVelX, objY, objZ + objVelZ, objVelX, objVelZ) == 0) {
+    struct WallCollisionData hitbox;
+    struct CollisionColumn column;
+
+    // Find the walls, floor and water at the new position in one query.
+    hitbox.offsetY = o->hitboxHeight / 2;
+    hitbox.radius = o->hitboxRadius;
+    find_collision_column(objX + objVelX, objY, objZ + objVelZ, (RAYCAST_FIND_FLOOR | RAYCAST_FIND_WALL | RAYCAST_FIND_WATER), &column, &hitbox);
+
+    // Receive the push from any wall collisions and set the flag.
+    if (obj_resolve_wall_hitbox(&hitbox, objVelX, objVelZ) == 0) {
         collisionFlags += OBJ_COL_FLAG_HIT_WALL;
     }
 
-    floorY = find_floor(objX + objVelX, objY, objZ + objVelZ, &sObjFloor);
+    sObjFloor = column.floor;
+    floorY    = column.floorHeight;
 
     o->oFloor       = sObjFloor;
     o->oFloorHeight = floorY;
 
     if (turn_obj_away_from_steep_floor(sObjFloor, floorY, objVelX, objVelZ) == 1) {
-        waterY = find_water_level(objX + objVelX, objZ + objVelZ);
+        waterY = column.waterLevel;
         if (waterY > objY) {
             calc_new_obj_vel_and_pos_y_underwater(sObjFloor, floorY, objVelX, objVelZ, waterY);
             collisionFlags += OBJ_COL_FLAG_UNDERWATER;
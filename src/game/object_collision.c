@@ -6,6 +6,7 @@
 #include "mario.h"
 #include "object_list_processor.h"
 #include "spawn_object.h"
+#include "puppyprint.h"
 #include "engine/math_util.h"
 
 UNUSED struct Object *debug_print_obj_collision(struct Object *a) {
@@ -23,6 +24,7 @@ UNUSED struct Object *debug_print_obj_collision(struct Object *a) {
 }
 
 s32 detect_object_hitbox_overlap(struct Object *a, struct Object *b) {
+    PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.object_pair_tests);
     f32 dya_bottom = a->oPosY - a->hitboxDownOffset;
     f32 dyb_bottom = b->oPosY - b->hitboxDownOffset;
     f32 dx = a->oPosX - b->oPosX;
@@ -106,6 +108,279 @@ void check_collision_in_list(struct Object *a, struct Object *b, struct Object *
     }
 }
 
+#ifdef OBJECT_COLLISION_BROADPHASE
+/**
+ * A hash grid of every collidable object's hitbox footprint, rebuilt each frame before collisions are checked.
+ * Each object only checks the objects that share a grid cell with it, instead of entire lists.
+ * Since detect_object_hitbox_overlap does nothing for objects that aren't overlapping, the candidates
+ * are sorted back into list order before being checked, so the results are identical to checking every object.
+ */
+#define OBJ_COLLISION_CELL_SHIFT    9
+#define OBJ_COLLISION_NUM_BUCKETS   128
+#define OBJ_COLLISION_MAX_CELLS     4
+#define OBJ_COLLISION_COORD_LIMIT   0x100000
+#define OBJ_COLLISION_NONE          0xFFFF
+
+struct ObjectCollisionEntry {
+    struct Object *obj;
+    u16 stamp;
+    u8 listIndex;
+    u8 oversized; // Hitbox covers too many cells, so it's a candidate for everything.
+};
+
+struct ObjectCollisionNode {
+    u16 entry;
+    u16 next;
+};
+
+static struct ObjectCollisionEntry sObjCollisionEntries[OBJECT_POOL_CAPACITY];
+static struct ObjectCollisionNode sObjCollisionNodes[OBJECT_POOL_CAPACITY * OBJ_COLLISION_MAX_CELLS];
+static u16 sObjCollisionBuckets[OBJ_COLLISION_NUM_BUCKETS];
+static u16 sObjCollisionOversized;
+static u16 sObjCollisionListStart[NUM_OBJ_LISTS];
+static u16 sObjCollisionListEnd[NUM_OBJ_LISTS];
+static u16 sNumObjCollisionEntries;
+static u16 sNumObjCollisionNodes;
+static u16 sObjCollisionStamp;
+static u32 sObjCollisionCandidates[OBJECT_POOL_CAPACITY];
+static s32 sNumObjCollisionCandidates;
+
+// The lists each check looks through, in the order they are checked. The first is the object's own list.
+static const u8 sPlayerCollisionLists[] = {
+    OBJ_LIST_PLAYER, OBJ_LIST_POLELIKE, OBJ_LIST_LEVEL, OBJ_LIST_GENACTOR,
+    OBJ_LIST_PUSHABLE, OBJ_LIST_SURFACE, OBJ_LIST_DESTRUCTIVE,
+};
+static const u8 sDestructiveCollisionLists[] = {
+    OBJ_LIST_DESTRUCTIVE, OBJ_LIST_GENACTOR, OBJ_LIST_PUSHABLE, OBJ_LIST_SURFACE,
+};
+static const u8 sPushableCollisionLists[] = {
+    OBJ_LIST_PUSHABLE,
+};
+
+static s32 get_obj_collision_cell(f32 pos) {
+    return ((s32) CLAMP(pos, -OBJ_COLLISION_COORD_LIMIT, OBJ_COLLISION_COORD_LIMIT)) >> OBJ_COLLISION_CELL_SHIFT;
+}
+
+static u32 get_obj_collision_bucket(s32 cellX, s32 cellZ) {
+    return (((u32) cellX * 73856093) ^ ((u32) cellZ * 19349663)) & (OBJ_COLLISION_NUM_BUCKETS - 1);
+}
+
+/**
+ * Gets the range of cells covered by an object's hitbox, padded by a unit so rounding can't miss an overlap.
+ * Returns FALSE if the hitbox covers more cells than an object can be linked into.
+ */
+static s32 get_obj_collision_cell_range(struct Object *obj, s32 *minCellX, s32 *maxCellX, s32 *minCellZ, s32 *maxCellZ) {
+    f32 radius = obj->hitboxRadius + 1.0f;
+
+    if (radius < 1.0f) {
+        return FALSE;
+    }
+
+    *minCellX = get_obj_collision_cell(obj->oPosX - radius);
+    *maxCellX = get_obj_collision_cell(obj->oPosX + radius);
+    *minCellZ = get_obj_collision_cell(obj->oPosZ - radius);
+    *maxCellZ = get_obj_collision_cell(obj->oPosZ + radius);
+
+    return (((*maxCellX - *minCellX + 1) * (*maxCellZ - *minCellZ + 1)) <= OBJ_COLLISION_MAX_CELLS);
+}
+
+static void link_obj_collision_node(u16 *head, s32 entryIndex) {
+    struct ObjectCollisionNode *node = &sObjCollisionNodes[sNumObjCollisionNodes];
+
+    node->entry = entryIndex;
+    node->next = *head;
+    *head = sNumObjCollisionNodes++;
+}
+
+static void add_obj_collision_entry(struct Object *obj, s32 listIndex) {
+    s32 entryIndex = sNumObjCollisionEntries++;
+    struct ObjectCollisionEntry *entry = &sObjCollisionEntries[entryIndex];
+    s32 minCellX, maxCellX, minCellZ, maxCellZ;
+
+    entry->obj = obj;
+    entry->stamp = 0;
+    entry->listIndex = listIndex;
+    entry->oversized = !get_obj_collision_cell_range(obj, &minCellX, &maxCellX, &minCellZ, &maxCellZ);
+
+    // Intangible objects can't be collided with this frame, so they're only needed for their own checks.
+    if (obj->oIntangibleTimer != 0) {
+        return;
+    }
+
+    if (entry->oversized) {
+        link_obj_collision_node(&sObjCollisionOversized, entryIndex);
+        return;
+    }
+
+    for (s32 cellZ = minCellZ; cellZ <= maxCellZ; cellZ++) {
+        for (s32 cellX = minCellX; cellX <= maxCellX; cellX++) {
+            link_obj_collision_node(&sObjCollisionBuckets[get_obj_collision_bucket(cellX, cellZ)], entryIndex);
+        }
+    }
+}
+
+/**
+ * Builds the grid from every object in the player's list order. Objects in each list end up as a contiguous range of entries.
+ * Every object comes from the object pool, so the entries can't overflow.
+ */
+static void build_obj_collision_grid(void) {
+    s32 i;
+
+    sNumObjCollisionEntries = 0;
+    sNumObjCollisionNodes = 0;
+    sObjCollisionStamp = 0;
+    sObjCollisionOversized = OBJ_COLLISION_NONE;
+
+    for (i = 0; i < OBJ_COLLISION_NUM_BUCKETS; i++) {
+        sObjCollisionBuckets[i] = OBJ_COLLISION_NONE;
+    }
+
+    for (i = 0; i < NUM_OBJ_LISTS; i++) {
+        sObjCollisionListStart[i] = 0;
+        sObjCollisionListEnd[i] = 0;
+    }
+
+    for (i = 0; i < (s32) ARRAY_COUNT(sPlayerCollisionLists); i++) {
+        s32 listIndex = sPlayerCollisionLists[i];
+        struct Object *listHead = (struct Object *) &gObjectLists[listIndex];
+        struct Object *obj = (struct Object *) listHead->header.next;
+
+        sObjCollisionListStart[listIndex] = sNumObjCollisionEntries;
+
+        while (obj != listHead) {
+            add_obj_collision_entry(obj, listIndex);
+            obj = (struct Object *) obj->header.next;
+        }
+
+        sObjCollisionListEnd[listIndex] = sNumObjCollisionEntries;
+    }
+}
+
+static void check_collision_in_lists(struct Object *a, const u8 *lists, s32 numLists) {
+    struct Object *ownList = (struct Object *) &gObjectLists[lists[0]];
+
+    check_collision_in_list(a, (struct Object *) a->header.next, ownList);
+
+    for (s32 i = 1; i < numLists; i++) {
+        check_collision_in_list(a, (struct Object *) gObjectLists[lists[i]].next, (struct Object *) &gObjectLists[lists[i]]);
+    }
+}
+
+/**
+ * Adds the objects in a cell's list that entryIndex should check, sorted by list order and then by position in the list.
+ * @param ranks The 1-based position of each list in the order they should be checked, or 0 if the list isn't checked.
+ */
+static void gather_obj_collision_candidates(u16 nodeIndex, s32 entryIndex, s32 ownList, const u8 *ranks) {
+    s32 i;
+
+    while (nodeIndex != OBJ_COLLISION_NONE) {
+        struct ObjectCollisionNode *node = &sObjCollisionNodes[nodeIndex];
+        struct ObjectCollisionEntry *entry = &sObjCollisionEntries[node->entry];
+        nodeIndex = node->next;
+
+        // Objects can be in several of the cells being checked.
+        if (entry->stamp == sObjCollisionStamp) continue;
+        entry->stamp = sObjCollisionStamp;
+
+        if (ranks[entry->listIndex] == 0) continue;
+        // Objects in the same list only check the objects after them.
+        if (entry->listIndex == ownList && node->entry <= entryIndex) continue;
+
+        u32 key = (ranks[entry->listIndex] << 16) | node->entry;
+        for (i = sNumObjCollisionCandidates; i > 0 && sObjCollisionCandidates[i - 1] > key; i--) {
+            sObjCollisionCandidates[i] = sObjCollisionCandidates[i - 1];
+        }
+        sObjCollisionCandidates[i] = key;
+        sNumObjCollisionCandidates++;
+    }
+}
+
+/**
+ * Checks an object for collisions with the objects that share a cell with it, in the same order check_collision_in_lists would.
+ */
+static void check_collision_in_grid(s32 entryIndex, const u8 *lists, s32 numLists, const u8 *ranks) {
+    struct ObjectCollisionEntry *entry = &sObjCollisionEntries[entryIndex];
+    struct Object *a = entry->obj;
+    s32 minCellX, maxCellX, minCellZ, maxCellZ;
+    s32 cellX, cellZ, i;
+
+    if (a->oIntangibleTimer != 0) {
+        return;
+    }
+
+    if (entry->oversized) {
+        check_collision_in_lists(a, lists, numLists);
+        return;
+    }
+
+    get_obj_collision_cell_range(a, &minCellX, &maxCellX, &minCellZ, &maxCellZ);
+    sObjCollisionStamp++;
+    sNumObjCollisionCandidates = 0;
+
+    for (cellZ = minCellZ; cellZ <= maxCellZ; cellZ++) {
+        for (cellX = minCellX; cellX <= maxCellX; cellX++) {
+            gather_obj_collision_candidates(sObjCollisionBuckets[get_obj_collision_bucket(cellX, cellZ)], entryIndex, lists[0], ranks);
+        }
+    }
+    gather_obj_collision_candidates(sObjCollisionOversized, entryIndex, lists[0], ranks);
+
+    for (i = 0; i < sNumObjCollisionCandidates; i++) {
+        struct Object *b = sObjCollisionEntries[sObjCollisionCandidates[i] & 0xFFFF].obj;
+
+        if (detect_object_hitbox_overlap(a, b) && b->hurtboxRadius != 0.0f) {
+            detect_object_hurtbox_overlap(a, b);
+        }
+    }
+}
+
+static void get_obj_collision_list_ranks(const u8 *lists, s32 numLists, u8 *ranks) {
+    s32 i;
+
+    for (i = 0; i < NUM_OBJ_LISTS; i++) {
+        ranks[i] = 0;
+    }
+    for (i = 0; i < numLists; i++) {
+        ranks[lists[i]] = i + 1;
+    }
+}
+
+void check_player_object_collision(void) {
+    s32 listIndex = sPlayerCollisionLists[0];
+    u8 ranks[NUM_OBJ_LISTS];
+
+    get_obj_collision_list_ranks(sPlayerCollisionLists, ARRAY_COUNT(sPlayerCollisionLists), ranks);
+
+    for (s32 i = sObjCollisionListStart[listIndex]; i < sObjCollisionListEnd[listIndex]; i++) {
+        check_collision_in_grid(i, sPlayerCollisionLists, ARRAY_COUNT(sPlayerCollisionLists), ranks);
+    }
+}
+
+void check_pushable_object_collision(void) {
+    s32 listIndex = sPushableCollisionLists[0];
+    u8 ranks[NUM_OBJ_LISTS];
+
+    get_obj_collision_list_ranks(sPushableCollisionLists, ARRAY_COUNT(sPushableCollisionLists), ranks);
+
+    for (s32 i = sObjCollisionListStart[listIndex]; i < sObjCollisionListEnd[listIndex]; i++) {
+        check_collision_in_grid(i, sPushableCollisionLists, ARRAY_COUNT(sPushableCollisionLists), ranks);
+    }
+}
+
+void check_destructive_object_collision(void) {
+    s32 listIndex = sDestructiveCollisionLists[0];
+    u8 ranks[NUM_OBJ_LISTS];
+
+    get_obj_collision_list_ranks(sDestructiveCollisionLists, ARRAY_COUNT(sDestructiveCollisionLists), ranks);
+
+    for (s32 i = sObjCollisionListStart[listIndex]; i < sObjCollisionListEnd[listIndex]; i++) {
+        struct Object *obj = sObjCollisionEntries[i].obj;
+
+        if (obj->oDistanceToMario < 2000.0f && !(obj->activeFlags & ACTIVE_FLAG_DESTRUCTIVE_OBJ_DONT_DESTROY)) {
+            check_collision_in_grid(i, sDestructiveCollisionLists, ARRAY_COUNT(sDestructiveCollisionLists), ranks);
+        }
+    }
+}
+#else
 void check_player_object_collision(void) {
     struct Object *playerObj = (struct Object *) &gObjectLists[OBJ_LIST_PLAYER];
     struct Object   *nextObj = (struct Object *) playerObj->header.next;
@@ -161,6 +436,7 @@ void check_destructive_object_collision(void) {
         nextObj = (struct Object *) nextObj->header.next;
     }
 }
+#endif
 
 void detect_object_collisions(void) {
     clear_object_collision((struct Object *) &gObjectLists[OBJ_LIST_POLELIKE]);
@@ -170,6 +446,9 @@ void detect_object_collisions(void) {
     clear_object_collision((struct Object *) &gObjectLists[OBJ_LIST_LEVEL]);
     clear_object_collision((struct Object *) &gObjectLists[OBJ_LIST_SURFACE]);
     clear_object_collision((struct Object *) &gObjectLists[OBJ_LIST_DESTRUCTIVE]);
+#ifdef OBJECT_COLLISION_BROADPHASE
+    build_obj_collision_grid();
+#endif
     check_player_object_collision();
     check_destructive_object_collision();
     check_pushable_object_collision();
@@ -282,6 +282,23 @@ void bhv_mario_update(void) {
     }
 }
 
+/**
+ * Run the current object's update, attributing the time taken to its behavior when profiling.
+ */
+static void update_current_object(void) {
+#ifdef BEHAVIOR_PROFILER
+    const BehaviorScript *behavior = gCurrentObject->behavior;
+    u32 first = osGetCount();
+
+    gBehaviorNativeTime = 0;
+    gBehaviorNativeFunc = NULL;
+    cur_obj_update();
+    puppyprint_behavior_profiler_record(behavior, osGetCount() - first, gBehaviorNativeTime, gBehaviorNativeFunc);
+#else
+    cur_obj_update();
+#endif
+}
+
 /**
  * Update every object that occurs after firstObj in the given object list,
  * including firstObj itself. Return the number of objects that were updated.
@@ -293,7 +310,7 @@ s32 update_objects_starting_at(struct ObjectNode *objList, struct ObjectNode *fi
         gCurrentObject = (struct Object *) firstObj;
 
         gCurrentObject->header.gfx.node.flags |= GRAPH_RENDER_HAS_ANIMATION;
-        cur_obj_update();
+        update_current_object();
 
         firstObj = firstObj->next;
         count++;
@@ -340,7 +357,7 @@ s32 update_objects_during_time_stop(struct ObjectNode *objList, struct ObjectNod
         // Only update if unfrozen
         if (unfrozen) {
             gCurrentObject->header.gfx.node.flags |= GRAPH_RENDER_HAS_ANIMATION;
-            cur_obj_update();
+            update_current_object();
         } else {
             gCurrentObject->header.gfx.node.flags &= ~GRAPH_RENDER_HAS_ANIMATION;
         }
@@ -550,7 +567,7 @@ void update_terrain_objects(void) {
     profiler_update(PROFILER_TIME_DYNAMIC, profiler_get_delta(PROFILER_DELTA_COLLISION) - first);
 
     // If the dynamic surface pool has overflowed, throw an error.
-    assert((uintptr_t)gDynamicSurfacePoolEnd <= (uintptr_t)gDynamicSurfacePool + DYNAMIC_SURFACE_POOL_SIZE, "Dynamic surface pool size exceeded");
+    assert(get_dynamic_surface_pool_used() <= DYNAMIC_SURFACE_POOL_SIZE, "Dynamic surface pool size exceeded");
 }
 
 /**
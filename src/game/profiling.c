@@ -5,6 +5,10 @@
 #include "profiling.h"
 #include "fasttext.h"
 #include "puppyprint.h"
+#ifdef PROFILER_TIMELINE
+#include "printf.h"
+#include "usb/debug.h"
+#endif
 
 #ifdef USE_PROFILER
 
@@ -29,6 +33,109 @@ u32 audio_subset_starts[AUDIO_SUBSET_SIZE];
 u32 audio_subset_tallies[AUDIO_SUBSET_SIZE];
 #endif
 
+#ifdef PROFILER_TIMELINE
+
+#define TIMELINE_NUM_EVENTS (PROFILER_TIMELINE_FRAMES * 32)
+
+enum TimelineTrack {
+    TIMELINE_TRACK_FRAME,
+    TIMELINE_TRACK_GAME,
+    TIMELINE_TRACK_AUDIO,
+    TIMELINE_TRACK_RSP,
+    TIMELINE_TRACK_RDP,
+};
+
+typedef struct {
+    u32 start;
+    u32 end;
+    const char *name;
+    u8 track;
+} TimelineEvent;
+
+static const char *timeline_track_names[] = { "Frame", "Game", "Audio", "RSP", "RDP" };
+
+static const char *timeline_event_names[PROFILER_TIME_COUNT] = {
+    [PROFILER_TIME_CONTROLLERS]           = "Controllers",
+    [PROFILER_TIME_SPAWNER]               = "Spawner",
+    [PROFILER_TIME_DYNAMIC]               = "Dynamic",
+    [PROFILER_TIME_BEHAVIOR_BEFORE_MARIO] = "Behavior before Mario",
+    [PROFILER_TIME_MARIO]                 = "Mario",
+    [PROFILER_TIME_BEHAVIOR_AFTER_MARIO]  = "Behavior after Mario",
+    [PROFILER_TIME_GFX]                   = "Graph",
+    [PROFILER_TIME_COLLISION]             = "Collision",
+    [PROFILER_TIME_CAMERA]                = "Camera",
+#ifdef PUPPYPRINT_DEBUG
+    [PROFILER_TIME_PUPPYPRINT1]           = "Puppyprint",
+    [PROFILER_TIME_PUPPYPRINT2]           = "Puppyprint",
+#endif
+};
+
+static const char *timeline_rsp_names[PROFILER_RSP_COUNT] = { "Gfx task", "Audio task" };
+
+TimelineEvent timeline_events[TIMELINE_NUM_EVENTS];
+u32 timeline_index = 0;
+u32 timeline_count = 0;
+// Frames left before another slow frame may be dumped, so that the ring holds a full timeline again
+u32 timeline_cooldown = PROFILER_TIMELINE_FRAMES;
+u32 timeline_frame_start;
+u32 timeline_rsp_starts[PROFILER_RSP_COUNT];
+u8 timeline_gfx_running = FALSE;
+u8 timeline_rdp_pending = FALSE;
+u32 timeline_rdp_start;
+
+static void timeline_record(enum TimelineTrack track, const char *name, u32 start, u32 end) {
+    u32 saved = __osDisableInt();
+    TimelineEvent *event = &timeline_events[timeline_index];
+
+    event->start = start;
+    event->end = end;
+    event->name = (name != NULL) ? name : "?";
+    event->track = track;
+
+    timeline_index++;
+    if (timeline_index >= TIMELINE_NUM_EVENTS) {
+        timeline_index = 0;
+    }
+    if (timeline_count < TIMELINE_NUM_EVENTS) {
+        timeline_count++;
+    }
+    __osRestoreInt(saved);
+}
+
+/**
+ * Prints the recorded events over USB and empties the ring. Times are printed as the number of
+ * CPU counter ticks before now, so they stay ordered even if the counter wrapped in between.
+ */
+static void timeline_dump(u32 frame_time) {
+    u32 saved = __osDisableInt();
+    u32 count = timeline_count;
+    u32 now = osGetCount();
+    u32 index = (timeline_index + TIMELINE_NUM_EVENTS - count) % TIMELINE_NUM_EVENTS;
+    // Copy the events out first, since the audio thread and the RCP interrupts keep recording while we print
+    static TimelineEvent events[TIMELINE_NUM_EVENTS];
+
+    for (u32 i = 0; i < count; i++) {
+        events[i] = timeline_events[index];
+        index++;
+        if (index >= TIMELINE_NUM_EVENTS) {
+            index = 0;
+        }
+    }
+    timeline_index = 0;
+    timeline_count = 0;
+    __osRestoreInt(saved);
+
+    debug_printf("TIMELINE BEGIN %u %u %u\n", count, (u32) OS_CPU_COUNTER, (u32) OS_CYCLES_TO_USEC(frame_time));
+    for (u32 i = 0; i < count; i++) {
+        debug_printf("E %s %u %u %s\n", timeline_track_names[events[i].track], now - events[i].start, now - events[i].end, events[i].name);
+    }
+    debug_printf("TIMELINE END\n");
+}
+
+#else
+#define timeline_record(track, name, start, end)
+#endif
+
 static void buffer_update(ProfileTimeData* data, u32 new, int buffer_index) {
     u32 old = data->counts[buffer_index];
     data->total -= old;
@@ -53,19 +160,45 @@ void profiler_update(enum ProfilerTime which, u32 delta) {
     }
     
     buffer_update(cur_data, diff, profile_buffer_index);
+    // The total covers the whole frame, which the timeline records separately
+    if (which != PROFILER_TIME_TOTAL) {
+        timeline_record(TIMELINE_TRACK_GAME, timeline_event_names[which], prev_time, cur_time);
+    }
     prev_time = cur_time;
 }
 
 void profiler_rsp_started(enum ProfilerRSPTime which) {
     rsp_pending_times[which] = osGetCount();
+
+#ifdef PROFILER_TIMELINE
+    timeline_rsp_starts[which] = rsp_pending_times[which];
+    if (which == PROFILER_RSP_GFX) {
+        timeline_gfx_running = TRUE;
+        // The RDP starts on the task's commands as soon as the RSP outputs them
+        if (!timeline_rdp_pending) {
+            timeline_rdp_start = rsp_pending_times[which];
+            timeline_rdp_pending = TRUE;
+        }
+    }
+#endif
 }
 
 void profiler_rsp_completed(enum ProfilerRSPTime which) {
     ProfileTimeData* cur_data = &all_profiling_data[PROFILER_TIME_RSP_GFX + which];
     int cur_index = rsp_buffer_indices[which];
-    u32 time = osGetCount() - rsp_pending_times[which];
+    u32 now = osGetCount();
+    u32 time = now - rsp_pending_times[which];
     rsp_pending_times[which] = 0;
 
+#ifdef PROFILER_TIMELINE
+    if (which != PROFILER_RSP_GFX || timeline_gfx_running) {
+        timeline_record(TIMELINE_TRACK_RSP, timeline_rsp_names[which], timeline_rsp_starts[which], now);
+    }
+    if (which == PROFILER_RSP_GFX) {
+        timeline_gfx_running = FALSE;
+    }
+#endif
+
     buffer_update(cur_data, time, cur_index);
     cur_index++;
     if (cur_index >= PROFILING_BUFFER_SIZE) {
@@ -75,8 +208,28 @@ void profiler_rsp_completed(enum ProfilerRSPTime which) {
 }
 
 void profiler_rsp_resumed() {
-    rsp_pending_times[PROFILER_RSP_GFX] = osGetCount() - rsp_pending_times[PROFILER_RSP_GFX];
+    u32 now = osGetCount();
+    rsp_pending_times[PROFILER_RSP_GFX] = now - rsp_pending_times[PROFILER_RSP_GFX];
+
+#ifdef PROFILER_TIMELINE
+    // Also called when the task yields, so each run of the gfx task between yields becomes its own event
+    if (timeline_gfx_running) {
+        timeline_record(TIMELINE_TRACK_RSP, timeline_rsp_names[PROFILER_RSP_GFX], timeline_rsp_starts[PROFILER_RSP_GFX], now);
+    } else {
+        timeline_rsp_starts[PROFILER_RSP_GFX] = now;
+    }
+    timeline_gfx_running ^= TRUE;
+#endif
+}
+
+#ifdef PROFILER_TIMELINE
+void profiler_rdp_completed() {
+    if (timeline_rdp_pending) {
+        timeline_record(TIMELINE_TRACK_RDP, "Gfx", timeline_rdp_start, osGetCount());
+        timeline_rdp_pending = FALSE;
+    }
 }
+#endif
 
 // This ends up being the same math as resumed, so we just use resumed for both
 // void profiler_rsp_yielded() {
@@ -127,6 +280,7 @@ void profiler_audio_completed() {
 
     preempted_time = time - audio_start;
     buffer_update(cur_data, time - audio_start, cur_index);
+    timeline_record(TIMELINE_TRACK_AUDIO, "Audio", audio_start, time);
 
 #ifdef AUDIO_PROFILING
     audio_subset_tallies[PROFILER_TIME_SUB_AUDIO_UPDATE - PROFILER_TIME_SUB_AUDIO_START] += time - audio_subset_starts[PROFILER_TIME_SUB_AUDIO_UPDATE - PROFILER_TIME_SUB_AUDIO_START];
@@ -325,6 +479,19 @@ void profiler_print_times() {
 }
 
 void profiler_frame_setup() {
+#ifdef PROFILER_TIMELINE
+    u32 frame_end = osGetCount();
+    u32 frame_time = frame_end - timeline_frame_start;
+
+    timeline_record(TIMELINE_TRACK_FRAME, "Frame", timeline_frame_start, frame_end);
+    if (timeline_cooldown > 0) {
+        timeline_cooldown--;
+    } else if (frame_time > OS_USEC_TO_CYCLES(PROFILER_TIMELINE_THRESHOLD_US)) {
+        timeline_dump(frame_time);
+        timeline_cooldown = PROFILER_TIMELINE_FRAMES;
+    }
+#endif
+
     profile_buffer_index++;
     preempted_time = 0;
 
@@ -333,6 +500,9 @@ void profiler_frame_setup() {
     }
 
     prev_time = cur_start = osGetCount();
+#ifdef PROFILER_TIMELINE
+    timeline_frame_start = cur_start;
+#endif
 }
 
 #endif
@@ -137,6 +137,12 @@ static ALWAYS_INLINE void profiler_rsp_yielded() {
 #define profiler_get_rdp_microseconds() 0
 #endif
 
+#ifdef PROFILER_TIMELINE
+void profiler_rdp_completed();
+#else
+#define profiler_rdp_completed()
+#endif
+
 #ifdef AUDIO_PROFILING
 #define AUDIO_SUBSET_SIZE PROFILER_TIME_SUB_AUDIO_END - PROFILER_TIME_SUB_AUDIO_START
 extern u32 audio_subset_starts[AUDIO_SUBSET_SIZE];
@@ -45,12 +45,16 @@ a modern game engine's developer's console.
 #include "audio/external.h"
 #include "audio/heap.h"
 #include "audio/load.h"
+#include "audio/playback.h"
 #include "hud.h"
 #include "debug_box.h"
 #include "color_presets.h"
 #include "buffers/buffers.h"
 #include "profiling.h"
 #include "segment_symbols.h"
+#include "segments.h"
+#include "farcall.h"
+#include "gfx_pool_stats.h"
 
 #ifdef PUPPYPRINT
 
@@ -144,7 +148,7 @@ void puppyprint_calculate_ram_usage(void) {
     ramsizeSegment[RAM_ZBUFFER] = (u32)&_zbufferSegmentBssEnd - (u32)&_zbufferSegmentBssStart;
     ramsizeSegment[RAM_GODDARD] = (u32)&_goddardSegmentEnd - (u32)&_goddardSegmentStart;
     ramsizeSegment[RAM_POOLS] = gPoolMem;
-    ramsizeSegment[RAM_COLLISION] = ((u32) gCurrStaticSurfacePoolEnd - (u32) gCurrStaticSurfacePool) + ((u32) gDynamicSurfacePoolEnd - (u32) gDynamicSurfacePool);
+    ramsizeSegment[RAM_COLLISION] = ((u32) gCurrStaticSurfacePoolEnd - (u32) gCurrStaticSurfacePool) + get_dynamic_surface_pool_used();
     ramsizeSegment[RAM_MISC] = gMiscMem;
     ramsizeSegment[RAM_AUDIO] = gAudioHeapSize;
 }
@@ -313,7 +317,8 @@ static const char *audioBenchmarkNames[PROFILER_TIME_SUB_AUDIO_END - PROFILER_TI
 STATIC_ASSERT(ARRAY_COUNT(audioBenchmarkNames) == PROFILER_TIME_SUB_AUDIO_END - PROFILER_TIME_SUB_AUDIO_START, "audioBenchmarkNames has incorrect number of entries!");
 #endif
 
-static void print_audio_ram_overview(s32 x, char *textBytes) {
+// Returns the y position of the topmost line printed.
+static s32 print_audio_ram_overview(s32 x, char *textBytes) {
     s32 percentage = 0;
     s32 y = SCREEN_HEIGHT - 6;
     s32 totalMemory[2] = { 0, 0 };
@@ -365,6 +370,19 @@ static void print_audio_ram_overview(s32 x, char *textBytes) {
 
     print_set_envcolour(255, 255, 255, 255);
     print_small_text_light(x, y, textBytes, PRINT_TEXT_ALIGN_LEFT, PRINT_ALL, FONT_OUTLINE);
+
+    return y;
+}
+
+static void print_sample_dma_stats(s32 x, s32 y, char *textBytes) {
+    sprintf(textBytes, "SAMPLE DMAS:\t\t\t\t%d hit %d miss %d evict %dB",
+            gSampleDmaFrameStats.hits,
+            gSampleDmaFrameStats.misses,
+            gSampleDmaFrameStats.evictions,
+            gSampleDmaFrameStats.bytes);
+
+    print_set_envcolour(255, 255, 255, 255);
+    print_small_text_light(x, y, textBytes, PRINT_TEXT_ALIGN_LEFT, PRINT_ALL, FONT_OUTLINE);
 }
 
 static void print_audio_overview(void) {
@@ -389,6 +407,12 @@ static void print_audio_overview(void) {
     print_set_envcolour(255, 255, 255, 255);
     print_small_text_light(x, y, textBytes, PRINT_TEXT_ALIGN_LEFT, PRINT_ALL, FONT_OUTLINE);
 
+#ifdef ADAPTIVE_POLYPHONY
+    sprintf(textBytes, "NOTES: %d / %d, %d stolen, %dus",
+            gNoteBudget, gMaxSimultaneousNotes, (s32) gNoteBudgetStats.notesStolen, (s32) gNoteBudgetStats.frameTime);
+    print_small_text_light(SCREEN_WIDTH - x, y, textBytes, PRINT_TEXT_ALIGN_RIGHT, PRINT_ALL, FONT_OUTLINE);
+#endif
+
 #ifdef AUDIO_PROFILING
     for (s32 i = 0; i < ARRAY_COUNT(audioBenchmarkNames); i++) {
         y += 12;
@@ -415,7 +439,8 @@ static void print_audio_overview(void) {
             "In <COL_FFFF1FFF>profiling.h<COL_-------->.", PRINT_TEXT_ALIGN_LEFT, PRINT_ALL, FONT_OUTLINE);
 #endif
 
-    print_audio_ram_overview(x, textBytes);
+    y = print_audio_ram_overview(x, textBytes);
+    print_sample_dma_stats(x, y - 12, textBytes);
 }
 
 char consoleLogTable[LOG_BUFFER_SIZE][255];
@@ -465,14 +490,154 @@ extern s16 gVisualSurfaceCount;
     #define gVisualSurfaceCount 0
 #endif
 
+#ifdef BEHAVIOR_PROFILER
+#define BEHAVIOR_PROFILER_TABLE_SIZE 128
+#define BEHAVIOR_PROFILER_NUM_SHOWN  12
+
+extern far char *parse_map(u32 pc);
+
+struct BehaviorProfile {
+    const BehaviorScript *behavior;
+    void *nativeFunc; // The last native function the behavior called, used to name it.
+    u32 frameTime;
+    u32 totalTime;
+    u32 nativeTime;
+    u32 peakTime;
+    u16 count; // Object updates in the current frame.
+    u16 peakCount;
+};
+
+u32 gBehaviorNativeTime = 0;
+void *gBehaviorNativeFunc = NULL;
+static struct BehaviorProfile sBehaviorProfiles[BEHAVIOR_PROFILER_TABLE_SIZE];
+// The slowest behaviors of the last NUM_PERF_ITERATIONS frames, sorted by average time.
+static struct BehaviorProfile sBehaviorProfilesShown[BEHAVIOR_PROFILER_NUM_SHOWN];
+static u32 sNumBehaviorProfilesShown = 0;
+static u32 sBehaviorProfilerFrame = 0;
+
+void puppyprint_behavior_profiler_record(const BehaviorScript *behavior, u32 time, u32 nativeTime, void *nativeFunc) {
+    u32 i = (((uintptr_t) behavior >> 2) & (BEHAVIOR_PROFILER_TABLE_SIZE - 1));
+
+    for (s32 probes = 0; probes < BEHAVIOR_PROFILER_TABLE_SIZE; probes++) {
+        struct BehaviorProfile *profile = &sBehaviorProfiles[i];
+
+        if (profile->behavior == behavior || profile->behavior == NULL) {
+            profile->behavior = behavior;
+            profile->frameTime += time;
+            profile->nativeTime += nativeTime;
+            profile->count++;
+            if (nativeFunc != NULL) {
+                profile->nativeFunc = nativeFunc;
+            }
+            return;
+        }
+        i = ((i + 1) & (BEHAVIOR_PROFILER_TABLE_SIZE - 1));
+    }
+}
+
+/**
+ * Ends the frame for every behavior. Every NUM_PERF_ITERATIONS frames, the slowest behaviors are kept for display and the table is cleared.
+ */
+static void puppyprint_behavior_profiler_frame(void) {
+    struct BehaviorProfile *profile;
+    s32 i, j;
+
+    for (i = 0; i < BEHAVIOR_PROFILER_TABLE_SIZE; i++) {
+        profile = &sBehaviorProfiles[i];
+        if (profile->behavior != NULL) {
+            profile->totalTime += profile->frameTime;
+            profile->peakTime = MAX(profile->peakTime, profile->frameTime);
+            profile->peakCount = MAX(profile->peakCount, profile->count);
+            profile->frameTime = 0;
+            profile->count = 0;
+        }
+    }
+
+    if (++sBehaviorProfilerFrame < NUM_PERF_ITERATIONS) {
+        return;
+    }
+    sBehaviorProfilerFrame = 0;
+
+    sNumBehaviorProfilesShown = 0;
+    for (i = 0; i < BEHAVIOR_PROFILER_TABLE_SIZE; i++) {
+        profile = &sBehaviorProfiles[i];
+        if (profile->behavior == NULL) {
+            continue;
+        }
+
+        // Insert sorted by total time, dropping the fastest once the list is full.
+        for (j = sNumBehaviorProfilesShown; j > 0 && sBehaviorProfilesShown[j - 1].totalTime < profile->totalTime; j--) {
+            if (j < BEHAVIOR_PROFILER_NUM_SHOWN) {
+                sBehaviorProfilesShown[j] = sBehaviorProfilesShown[j - 1];
+            }
+        }
+        if (j < BEHAVIOR_PROFILER_NUM_SHOWN) {
+            sBehaviorProfilesShown[j] = *profile;
+            if (sNumBehaviorProfilesShown < BEHAVIOR_PROFILER_NUM_SHOWN) {
+                sNumBehaviorProfilesShown++;
+            }
+        }
+    }
+
+    bzero(sBehaviorProfiles, sizeof(sBehaviorProfiles));
+}
+
+void puppyprint_render_behaviors(void) {
+    char textBytes[80];
+    char *name;
+
+    print_small_text_light(16, 32, "Behavior", PRINT_TEXT_ALIGN_LEFT, PRINT_ALL, FONT_OUTLINE);
+    print_small_text_light(SCREEN_WIDTH - 16, 32, "Avg  Peak (" PP_CYCLE_STRING ")  Native  Objs", PRINT_TEXT_ALIGN_RIGHT, PRINT_ALL, FONT_OUTLINE);
+
+    for (u32 i = 0; i < sNumBehaviorProfilesShown; i++) {
+        struct BehaviorProfile *profile = &sBehaviorProfilesShown[i];
+        s32 posY = 44 + (i * 12);
+
+        name = NULL;
+        if (profile->nativeFunc != NULL && (u32) parse_map != MAP_PARSER_ADDRESS) {
+            name = parse_map((u32) profile->nativeFunc);
+        }
+        if (name != NULL) {
+            sprintf(textBytes, "%.24s", name);
+        } else {
+            sprintf(textBytes, "0x%08X", (u32) profile->behavior);
+        }
+        print_small_text_light(16, posY, textBytes, PRINT_TEXT_ALIGN_LEFT, PRINT_ALL, FONT_OUTLINE);
+
+        sprintf(textBytes, "%d  %d  %d%%  %d",
+            PP_CYCLE_CONV(profile->totalTime / NUM_PERF_ITERATIONS),
+            PP_CYCLE_CONV(profile->peakTime),
+            ((profile->totalTime != 0) ? (s32)(((u64) profile->nativeTime * 100) / profile->totalTime) : 0),
+            profile->peakCount);
+        print_small_text_light(SCREEN_WIDTH - 16, posY, textBytes, PRINT_TEXT_ALIGN_RIGHT, PRINT_ALL, FONT_OUTLINE);
+    }
+}
+#endif
+
 void puppyprint_render_collision(void) {
     char textBytes[128];
     sprintf(textBytes, "Static Pool Size: 0x%X\nDynamic Pool Size: 0x%X\nDynamic Pool Used: 0x%X\nSurfaces Allocated: %d\nNodes Allocated: %d", 
     gTotalStaticSurfaceData,
     DYNAMIC_SURFACE_POOL_SIZE,
-    (uintptr_t)gDynamicSurfacePoolEnd - (uintptr_t)gDynamicSurfacePool,
+    get_dynamic_surface_pool_used(),
     gSurfacesAllocated, gSurfaceNodesAllocated);
     print_small_text_light(SCREEN_WIDTH-16, 60, textBytes, PRINT_TEXT_ALIGN_RIGHT, PRINT_ALL, 1);
+#ifdef STATIC_SURFACE_SUBDIVISION_THRESHOLD
+    sprintf(textBytes, "Subdivided Cells: %d", gNumSubdividedCells);
+    print_small_text_light(SCREEN_WIDTH-16, 120, textBytes, PRINT_TEXT_ALIGN_RIGHT, PRINT_ALL, 1);
+#endif
+    sprintf(textBytes, "Bounds Rejected: %d\nTriangles Tested: %d",
+    gPuppyCallCounter.collision_bounds_rejected,
+    gPuppyCallCounter.collision_bounds_tested);
+    print_small_text_light(SCREEN_WIDTH-16, 132, textBytes, PRINT_TEXT_ALIGN_RIGHT, PRINT_ALL, 1);
+#ifdef CACHE_DYNAMIC_SURFACES
+    sprintf(textBytes, "Dynamic Transformed: %d\nDynamic Reused: %d",
+    gNumDynamicSurfacesTransformed,
+    gNumDynamicSurfacesReused);
+    print_small_text_light(SCREEN_WIDTH-16, 156, textBytes, PRINT_TEXT_ALIGN_RIGHT, PRINT_ALL, 1);
+#endif
+    sprintf(textBytes, "Object Pair Tests: %d", gPuppyCallCounter.object_pair_tests);
+    print_small_text_light(SCREEN_WIDTH-16, 180, textBytes, PRINT_TEXT_ALIGN_RIGHT, PRINT_ALL, 1);
 
 #ifdef VISUAL_DEBUG
     print_small_text_light(160, (SCREEN_HEIGHT - 42), "Use the dpad to toggle visual collision modes", PRINT_TEXT_ALIGN_CENTRE, PRINT_ALL, FONT_OUTLINE);
@@ -488,6 +653,29 @@ void puppyprint_render_collision(void) {
 #endif
 }
 
+#ifdef GFX_POOL_STATS
+void puppyprint_render_gfx_pool(void) {
+    char textBytes[512];
+    s32 length;
+
+    sprintf(textBytes, "Pool Size: %d\nFrames: %d\nSkipped Layers: %d\nFailed Allocations: %d\n\nMin / Avg / Max\nUsed: %d / %d / %d\nCommands: %d / %d / %d\nAllocated: %d / %d / %d\nAllocations: %d / %d / %d\nMatrices: %d / %d / %d",
+        (s32) (GFX_POOL_SIZE * sizeof(Gfx)), gGfxPoolNumFrames, gGfxPoolSkippedLayers, gGfxPoolFailedAllocations,
+        gGfxPoolStats[GFX_POOL_STAT_USED].min,        gfx_pool_stats_average(GFX_POOL_STAT_USED),        gGfxPoolStats[GFX_POOL_STAT_USED].max,
+        gGfxPoolStats[GFX_POOL_STAT_COMMANDS].min,    gfx_pool_stats_average(GFX_POOL_STAT_COMMANDS),    gGfxPoolStats[GFX_POOL_STAT_COMMANDS].max,
+        gGfxPoolStats[GFX_POOL_STAT_ALLOCATED].min,   gfx_pool_stats_average(GFX_POOL_STAT_ALLOCATED),   gGfxPoolStats[GFX_POOL_STAT_ALLOCATED].max,
+        gGfxPoolStats[GFX_POOL_STAT_ALLOCATIONS].min, gfx_pool_stats_average(GFX_POOL_STAT_ALLOCATIONS), gGfxPoolStats[GFX_POOL_STAT_ALLOCATIONS].max,
+        gGfxPoolStats[GFX_POOL_STAT_MATRICES].min,    gfx_pool_stats_average(GFX_POOL_STAT_MATRICES),    gGfxPoolStats[GFX_POOL_STAT_MATRICES].max);
+    print_small_text_light(16, 36, textBytes, PRINT_TEXT_ALIGN_LEFT, PRINT_ALL, FONT_OUTLINE);
+
+    length = sprintf(textBytes, "Display Lists\n\n");
+    for (s32 i = 0; i < LAYER_COUNT; i++) {
+        struct GfxPoolStat *stat = &gGfxPoolStats[GFX_POOL_STAT_DISPLAY_LISTS + i];
+        length += sprintf(&textBytes[length], "Layer %d: %d / %d / %d\n", i, stat->min, gfx_pool_stats_average(GFX_POOL_STAT_DISPLAY_LISTS + i), stat->max);
+    }
+    print_small_text_light(SCREEN_WIDTH - 16, 36, textBytes, PRINT_TEXT_ALIGN_RIGHT, PRINT_ALL, FONT_OUTLINE);
+}
+#endif
+
 extern void print_fps(s32 x, s32 y);
 
 void print_basic_profiling(void) {
@@ -504,15 +692,21 @@ void print_basic_profiling(void) {
 }
 
 void puppyprint_render_standard(void) {
-    char textBytes[128];
+    char textBytes[240];
 
-    sprintf(textBytes, "Matrix Muls: %d\n\nCollision Checks\nFloors: %d\nWalls: %d\nCeilings: %d\n Water: %d\nRaycasts: %d",
+    sprintf(textBytes, "Matrix Muls: %d\nPose Cache Hits: %d\nPose Cache Misses: %d\nDisplay Lists: %d\nState Changes: %d\n\nCollision Checks\nFloors: %d\nWalls: %d\nCeilings: %d\n Water: %d\nRaycasts: %d\nColumns: %d\nNodes: %d",
             gPuppyCallCounter.matrix,
+            gPuppyCallCounter.pose_cache_hits,
+            gPuppyCallCounter.pose_cache_misses,
+            gPuppyCallCounter.display_lists,
+            gPuppyCallCounter.state_changes,
             gPuppyCallCounter.collision_floor,
             gPuppyCallCounter.collision_wall,
             gPuppyCallCounter.collision_ceil,
             gPuppyCallCounter.collision_water,
-            gPuppyCallCounter.collision_raycast
+            gPuppyCallCounter.collision_raycast,
+            gPuppyCallCounter.collision_column,
+            gPuppyCallCounter.collision_nodes
     );
     print_small_text_light(SCREEN_WIDTH-16, 32, textBytes, PRINT_TEXT_ALIGN_RIGHT, PRINT_ALL, FONT_OUTLINE);
 }
@@ -1024,6 +1218,14 @@ void puppyprint_render_general_vars(void) {
         print_small_text_light(16, 36, textBytes, PRINT_TEXT_ALIGN_LEFT, PRINT_ALL, FONT_OUTLINE);
         sprintf(textBytes, "Gfx Pool: %d / %d", ((u32)gDisplayListHead - ((u32)gGfxPool->buffer)) / 4, GFX_POOL_SIZE);
         print_small_text_light(SCREEN_WIDTH/2, SCREEN_HEIGHT-16, textBytes, PRINT_TEXT_ALIGN_CENTRE, PRINT_ALL, FONT_OUTLINE);
+#ifdef MARIO_ANIM_CACHE
+        u32 animLoads = gMarioAnimCache.hits + gMarioAnimCache.misses;
+        sprintf(textBytes, "Anim Cache: %d%% hits, %d prefetched, %dKB DMA",
+            (animLoads > 0) ? (s32) ((100 * gMarioAnimCache.hits) / animLoads) : 0,
+            gMarioAnimCache.prefetchHits,
+            gMarioAnimCache.dmaBytes / 1024);
+        print_small_text_light(SCREEN_WIDTH/2, SCREEN_HEIGHT-26, textBytes, PRINT_TEXT_ALIGN_CENTRE, PRINT_ALL, FONT_OUTLINE);
+#endif
     }
 #endif
 }
@@ -1037,6 +1239,12 @@ struct PuppyPrintPage ppPages[] = {
     [PUPPYPRINT_PAGE_AUDIO]         = {&print_audio_overview,           "Audio"},
     [PUPPYPRINT_PAGE_RAM]           = {&print_ram_overview,             "Segments"},
     [PUPPYPRINT_PAGE_COLLISION]     = {&puppyprint_render_collision,    "Collision"},
+#ifdef GFX_POOL_STATS
+    [PUPPYPRINT_PAGE_GFX_POOL]      = {&puppyprint_render_gfx_pool,     "Gfx Pool"},
+#endif
+#ifdef BEHAVIOR_PROFILER
+    [PUPPYPRINT_PAGE_BEHAVIORS]     = {&puppyprint_render_behaviors,    "Behaviors"},
+#endif
     [PUPPYPRINT_PAGE_LOG]           = {&print_console_log,              "Log"},
     [PUPPYPRINT_PAGE_LEVEL_SELECT]  = {&puppyprint_level_select_menu,   "Level Select"},
     [PUPPYPRINT_PAGE_COVERAGE]      = {&render_coverage_map,            "Coverage"},
@@ -1099,6 +1307,10 @@ void puppyprint_render_profiler(void) {
 void puppyprint_profiler_process(void) {
     PUPPYPRINT_GET_SNAPSHOT();
 
+#ifdef BEHAVIOR_PROFILER
+    puppyprint_behavior_profiler_frame();
+#endif
+
     if (fDebug && (gPlayer1Controller->buttonPressed & L_TRIG)) {
         sDebugMenu ^= TRUE;
         if (sDebugMenu == FALSE) {
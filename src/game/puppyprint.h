@@ -49,7 +49,16 @@ struct CallCounter {
     u16 collision_ceil;
     u16 collision_water;
     u16 collision_raycast;
+    u16 collision_column;
     u16 matrix;
+    u16 pose_cache_hits;
+    u16 pose_cache_misses;
+    u16 display_lists;
+    u16 state_changes; // Matrix, render mode and LookAt loads the master list emits.
+    u32 collision_nodes;
+    u32 collision_bounds_rejected;
+    u32 collision_bounds_tested;
+    u32 object_pair_tests;
 };
 
 struct PuppyPrintPage{
@@ -92,6 +101,12 @@ enum PPPages {
     PUPPYPRINT_PAGE_AUDIO,
     PUPPYPRINT_PAGE_RAM,
     PUPPYPRINT_PAGE_COLLISION,
+#ifdef GFX_POOL_STATS
+    PUPPYPRINT_PAGE_GFX_POOL,
+#endif
+#ifdef BEHAVIOR_PROFILER
+    PUPPYPRINT_PAGE_BEHAVIORS,
+#endif
     PUPPYPRINT_PAGE_LOG,
     PUPPYPRINT_PAGE_LEVEL_SELECT,
     PUPPYPRINT_PAGE_COVERAGE,
@@ -153,5 +168,10 @@ extern void set_segment_memory_printout(u32 segment, u32 amount);
 extern void print_small_text_light(s32 x, s32 y, const char *str, s32 align, s32 amount, u8 font);
 extern void print_small_text_buffered_light(s32 x, s32 y, const char *str, u8 align, s32 amount, u8 font);
 void puppyprint_profiler_process(void);
+#ifdef BEHAVIOR_PROFILER
+extern u32 gBehaviorNativeTime;
+extern void *gBehaviorNativeFunc;
+void puppyprint_behavior_profiler_record(const BehaviorScript *behavior, u32 time, u32 nativeTime, void *nativeFunc);
+#endif
 s32 text_iterate_command(const char *str, s32 i, s32 runCMD);
 void get_char_from_byte(s32 *textX, s32 *textPos, u8 letter, u8 *wideX, u8 *spaceX, s8 *offsetY, u8 font);
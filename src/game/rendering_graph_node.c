@@ -18,6 +18,8 @@
 #include "string.h"
 #include "color_presets.h"
 #include "emutest.h"
+#include "gfx_pool_stats.h"
+#include "debug.h"
 
 #include "config.h"
 #include "config/config_world.h"
@@ -62,8 +64,8 @@ struct GeoAnimState {
     /*0x01*/ u8 enabled;
     /*0x02*/ s16 frame;
     /*0x04*/ f32 translationMultiplier;
-    /*0x08*/ u16 *attribute;
-    /*0x0C*/ s16 *data;
+    /*0x08*/ s16 *pose;
+    /*0x0C*/ Vec3f (*bases)[3];
 };
 
 // For some reason, this is a GeoAnimState struct, but the current state consists
@@ -74,8 +76,36 @@ u8 gCurrAnimType;
 u8 gCurrAnimEnabled;
 s16 gCurrAnimFrame;
 f32 gCurrAnimTranslationMultiplier;
-u16 *gCurrAnimAttribute;
-s16 *gCurrAnimData;
+s16 *gCurrAnimPose;
+Vec3f (*gCurrAnimBases)[3]; // The rotation of each part from the pose cache, or NULL.
+
+// The most animated parts any animation may have. The largest in the tree has 44.
+#define MAX_ANIM_POSE_PARTS 64
+
+// Decoded poses of the object being drawn and of the object it holds.
+static s16 sAnimPoseBuffers[2][(MAX_ANIM_POSE_PARTS + 1) * 3];
+
+#ifdef ANIMATION_POSE_CACHE
+#define POSE_CACHE_ENTRIES 64
+
+/**
+ * A decoded animation frame shared by every object that plays the same animation on the
+ * same frame. The rotation basis of each part is stored too, so objects that find their
+ * pose here only have to multiply each part by its parent.
+ */
+struct PoseCacheEntry {
+    struct Animation *anim;
+    u32 stamp;
+    s16 frame;
+    s16 *pose;
+    Vec3f (*bases)[3];
+};
+
+static struct PoseCacheEntry sPoseCache[POSE_CACHE_ENTRIES];
+static u8 sPoseCacheBuffer[ANIMATION_POSE_CACHE] ALIGNED8;
+static u32 sPoseCacheUsed;
+static u32 sPoseCacheStamp; // Entries from a previous frame are empty.
+#endif
 
 struct AllocOnlyPool *gDisplayListHeap;
 
@@ -231,6 +261,21 @@ static struct RenderPhase sRenderPhases[] = {
 #endif
 };
 
+// Layers that don't need to reload the transform when it's the same as the previous display list's.
+// Nothing drawn on them loads its own modelview matrix; envfx, which does, is drawn on LAYER_OCCLUDE_SILHOUETTE_ALPHA.
+#define IS_SHARED_TRANSFORM_LAYER(layer) (((layer) == LAYER_FORCE) || ((layer) == LAYER_OPAQUE) || ((layer) == LAYER_OPAQUE_INTER))
+
+// The most commands the master list adds for one display list: its matrix, and the display list wrapped in the silhouette ones.
+#if SILHOUETTE
+#define MASTER_LIST_GFX_PER_DISPLAY_LIST 4
+#else
+#define MASTER_LIST_GFX_PER_DISPLAY_LIST 2
+#endif
+
+// The number of display lists on each layer of the current master list, and on all of them.
+static u16 sLayerListCounts[LAYER_COUNT];
+static u16 sMasterListCount;
+
 extern const Gfx init_rsp[];
 
 #define UPPER_FIXED(x) ((int)((unsigned int)((x) * 0x10000) >> 16))
@@ -268,6 +313,12 @@ void geo_process_master_list_sub(struct GraphNodeMasterList *node) {
     struct RenderModeContainer *mode2List = &renderModeTable_2Cycle[enableZBuffer];
     Gfx *tempGfxHead = gDisplayListHead;
 
+#ifdef F3DEX_GBI_2
+    // Every display list uses the same LookAt, so it only needs to be loaded once.
+    gSPLookAt(tempGfxHead++, gCurLookAt);
+    PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.state_changes);
+#endif
+
     // Loop through the render phases
     for (phaseIndex = RENDER_PHASE_FIRST; phaseIndex < finalPhase; phaseIndex++) {
         if (enableZBuffer) {
@@ -286,6 +337,15 @@ void geo_process_master_list_sub(struct GraphNodeMasterList *node) {
         for (currLayer = startLayer; currLayer <= endLayer; currLayer++) {
             // Set 'currList' to the first DisplayListNode on the current layer.
             currList = node->listHeads[currLayer];
+            // Skip the layer if it doesn't fit in the gfx pool without running into the reserve.
+            // Layers are drawn from opaque to transparent, so the least important ones are the first to go.
+            s32 layerSize = ((sLayerListCounts[currLayer] * MASTER_LIST_GFX_PER_DISPLAY_LIST) + 1) * sizeof(Gfx);
+            if ((s32) (gGfxPoolEnd - (u8 *) tempGfxHead) - layerSize < (s32) (GFX_POOL_RESERVE * sizeof(Gfx))) {
+                GFX_POOL_STATS_EVENT(gGfxPoolSkippedLayers);
+                continue;
+            }
+            Mtx *loadedTransform = NULL;
+            s32 shareTransforms = (enableZBuffer && IS_SHARED_TRANSFORM_LAYER(currLayer));
 #if defined(DISABLE_AA) || !SILHOUETTE
             // Set the render mode for the current layer.
             gDPSetRenderMode(tempGfxHead++, mode1List->modes[currLayer],
@@ -302,11 +362,19 @@ void geo_process_master_list_sub(struct GraphNodeMasterList *node) {
                                                      mode2List->modes[currLayer]);
             }
 #endif
+            PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.state_changes);
             // Iterate through all the displaylists on the current layer.
             while (currList != NULL) {
-                // Add the display list's transformation to the master list.
-                gSPMatrix(tempGfxHead++, VIRTUAL_TO_PHYSICAL(currList->transform),
-                          (G_MTX_MODELVIEW | G_MTX_LOAD | G_MTX_NOPUSH));
+                // Display lists from the same graph node share a transform, and level geometry all uses the same one.
+                s32 loadTransform = (!shareTransforms || currList->transform != loadedTransform);
+                loadedTransform = currList->transform;
+                if (loadTransform) {
+                    // Add the display list's transformation to the master list.
+                    gSPMatrix(tempGfxHead++, VIRTUAL_TO_PHYSICAL(currList->transform),
+                              (G_MTX_MODELVIEW | G_MTX_LOAD | G_MTX_NOPUSH));
+                    PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.state_changes);
+                }
+                PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.display_lists);
 #if SILHOUETTE
                 if (phaseIndex == RENDER_PHASE_SILHOUETTE) {
                     // Add the current display list to the master list, with silhouette F3D.
@@ -342,15 +410,22 @@ void geo_process_master_list_sub(struct GraphNodeMasterList *node) {
     gDisplayListHead = tempGfxHead;
 }
 
+/**
+ * Whether the gfx pool is down to GFX_POOL_RESERVE, counting the master list commands still to be
+ * written for the display lists added so far. Once it is, the graph walk stops adding objects and display lists.
+ */
+static s32 geo_gfx_pool_in_reserve(void) {
+    s32 masterListSize = sMasterListCount * MASTER_LIST_GFX_PER_DISPLAY_LIST * sizeof(Gfx);
+
+    return ((s32) (gGfxPoolEnd - (u8 *) gDisplayListHead) - masterListSize) < (s32) (GFX_POOL_RESERVE * sizeof(Gfx));
+}
+
 /**
  * Appends the display list to one of the master lists based on the layer
  * parameter. Look at the RenderModeContainer struct to see the corresponding
  * render modes of layers.
  */
 void geo_append_display_list(void *displayList, s32 layer) {
-#ifdef F3DEX_GBI_2
-    gSPLookAt(gDisplayListHead++, gCurLookAt);
-#endif
 #if SILHOUETTE
     if (gCurGraphNodeObject != NULL) {
         if (gCurGraphNodeObject->node.flags & GRAPH_RENDER_SILHOUETTE) {
@@ -366,14 +441,18 @@ void geo_append_display_list(void *displayList, s32 layer) {
             }
         }
     }
-#endif // F3DEX_GBI_2 || SILHOUETTE
-    if (gCurGraphNodeMasterList != NULL) {
+#endif // SILHOUETTE
+    // A display list without a transform is one whose matrix didn't fit in the gfx pool.
+    if (gCurGraphNodeMasterList != NULL && gMatStackFixed[gMatStackIndex] != NULL && !geo_gfx_pool_in_reserve()) {
         struct DisplayListNode *listNode =
             alloc_only_pool_alloc(gDisplayListHeap, sizeof(struct DisplayListNode));
 
         listNode->transform = gMatStackFixed[gMatStackIndex];
         listNode->displayList = displayList;
         listNode->next = NULL;
+        sLayerListCounts[layer]++;
+        sMasterListCount++;
+        GFX_POOL_STATS_ADD(GFX_POOL_STAT_DISPLAY_LISTS + layer, 1);
         if (gCurGraphNodeMasterList->listHeads[layer] == NULL) {
             gCurGraphNodeMasterList->listHeads[layer] = listNode;
         } else {
@@ -383,10 +462,16 @@ void geo_append_display_list(void *displayList, s32 layer) {
     }
 }
 
+/**
+ * Push the next matrix on the fixed point stack. If it doesn't fit in the gfx pool, the float stack
+ * is still pushed so children keep their transforms and animation state, but nothing under it is drawn.
+ */
 static void inc_mat_stack() {
     Mtx *mtx = alloc_display_list(sizeof(*mtx));
     gMatStackIndex++;
-    mtxf_to_mtx(mtx, gMatStack[gMatStackIndex]);
+    if (mtx != NULL) {
+        mtxf_to_mtx(mtx, gMatStack[gMatStackIndex]);
+    }
     gMatStackFixed[gMatStackIndex] = mtx;
 }
 
@@ -410,7 +495,9 @@ void geo_process_master_list(struct GraphNodeMasterList *node) {
         gCurGraphNodeMasterList = node;
         for (layer = LAYER_FIRST; layer < LAYER_COUNT; layer++) {
             node->listHeads[layer] = NULL;
+            sLayerListCounts[layer] = 0;
         }
+        sMasterListCount = 0;
         geo_process_node_and_siblings(node->node.children);
         geo_process_master_list_sub(gCurGraphNodeMasterList);
         gCurGraphNodeMasterList = NULL;
@@ -421,8 +508,9 @@ void geo_process_master_list(struct GraphNodeMasterList *node) {
  * Process an orthographic projection node.
  */
  void geo_process_ortho_projection(struct GraphNodeOrthoProjection *node) {
-    if (node->node.children != NULL) {
-        Mtx *mtx = alloc_display_list(sizeof(*mtx));
+    Mtx *mtx;
+
+    if (node->node.children != NULL && (mtx = alloc_display_list(sizeof(*mtx))) != NULL) {
         f32 scale = node->scale / 2.0f;
         f32 left = (gCurGraphNodeRoot->x - gCurGraphNodeRoot->width) * scale;
         f32 right = (gCurGraphNodeRoot->x + gCurGraphNodeRoot->width) * scale;
@@ -444,9 +532,10 @@ void geo_process_perspective(struct GraphNodePerspective *node) {
     if (node->fnNode.func != NULL) {
         node->fnNode.func(GEO_CONTEXT_RENDER, &node->fnNode.node, gMatStack[gMatStackIndex]);
     }
-    if (node->fnNode.node.children != NULL) {
+    Mtx *mtx;
+
+    if (node->fnNode.node.children != NULL && (mtx = alloc_display_list(sizeof(*mtx))) != NULL) {
         u16 perspNorm;
-        Mtx *mtx = alloc_display_list(sizeof(*mtx));
 #ifdef WIDE
         if (gConfig.widescreen && gCurrLevelNum != 0x01){
             sAspectRatio = 16.0f / 9.0f; // 1.775f
@@ -538,6 +627,9 @@ Vec3f globalLightDirection = { 0x28, 0x28, 0x28 };
 
 void setup_global_light() {
     Lights1* curLight = (Lights1*)alloc_display_list(sizeof(Lights1));
+    if (curLight == NULL) {
+        return;
+    }
     bcopy(&defaultLight, curLight, sizeof(Lights1));
 
 #ifdef WORLDSPACE_LIGHTING
@@ -562,6 +654,9 @@ void geo_process_camera(struct GraphNodeCamera *node) {
     Mtx *rollMtx = alloc_display_list(sizeof(*rollMtx));
     Mtx *viewMtx = alloc_display_list(sizeof(Mtx));
 
+    if (rollMtx == NULL || viewMtx == NULL) {
+        return;
+    }
     if (node->fnNode.func != NULL) {
         node->fnNode.func(GEO_CONTEXT_RENDER, &node->fnNode.node, gMatStack[gMatStackIndex]);
     }
@@ -746,16 +841,18 @@ void geo_process_background(struct GraphNodeBackground *node) {
 #endif
         Gfx *gfx = gfxStart;
 
-        gDPPipeSync(gfx++);
-        gDPSetCycleType(gfx++, G_CYC_FILL);
-        gDPSetFillColor(gfx++, node->background);
-        gDPFillRectangle(gfx++, GFX_DIMENSIONS_RECT_FROM_LEFT_EDGE(0), gBorderHeight,
-        GFX_DIMENSIONS_RECT_FROM_RIGHT_EDGE(0) - 1, SCREEN_HEIGHT - gBorderHeight - 1);
-        gDPPipeSync(gfx++);
-        gDPSetCycleType(gfx++, G_CYC_1CYCLE);
-        gSPEndDisplayList(gfx++);
-
-        geo_append_display_list((void *) VIRTUAL_TO_PHYSICAL(gfxStart), LAYER_FORCE);
+        if (gfxStart != NULL) {
+            gDPPipeSync(gfx++);
+            gDPSetCycleType(gfx++, G_CYC_FILL);
+            gDPSetFillColor(gfx++, node->background);
+            gDPFillRectangle(gfx++, GFX_DIMENSIONS_RECT_FROM_LEFT_EDGE(0), gBorderHeight,
+            GFX_DIMENSIONS_RECT_FROM_RIGHT_EDGE(0) - 1, SCREEN_HEIGHT - gBorderHeight - 1);
+            gDPPipeSync(gfx++);
+            gDPSetCycleType(gfx++, G_CYC_1CYCLE);
+            gSPEndDisplayList(gfx++);
+
+            geo_append_display_list((void *) VIRTUAL_TO_PHYSICAL(gfxStart), LAYER_FORCE);
+        }
     }
     if (node->fnNode.node.children != NULL) {
         geo_process_node_and_siblings(node->fnNode.node.children);
@@ -770,51 +867,126 @@ void geo_process_animated_part(struct GraphNodeAnimatedPart *node) {
     Vec3s rotation = { 0, 0, 0 };
     Vec3f translation = { node->translation[0], node->translation[1], node->translation[2] };
 
+    // The first animated part also reads the root translation, which can be partially animated.
     if (gCurrAnimType == ANIM_TYPE_TRANSLATION) {
-        translation[0] += gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)]
-                          * gCurrAnimTranslationMultiplier;
-        translation[1] += gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)]
-                          * gCurrAnimTranslationMultiplier;
-        translation[2] += gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)]
-                          * gCurrAnimTranslationMultiplier;
+        translation[0] += gCurrAnimPose[0] * gCurrAnimTranslationMultiplier;
+        translation[1] += gCurrAnimPose[1] * gCurrAnimTranslationMultiplier;
+        translation[2] += gCurrAnimPose[2] * gCurrAnimTranslationMultiplier;
+        gCurrAnimPose += 3;
+        gCurrAnimType = ANIM_TYPE_ROTATION;
+    } else if (gCurrAnimType == ANIM_TYPE_LATERAL_TRANSLATION) {
+        translation[0] += gCurrAnimPose[0] * gCurrAnimTranslationMultiplier;
+        translation[2] += gCurrAnimPose[2] * gCurrAnimTranslationMultiplier;
+        gCurrAnimPose += 3;
+        gCurrAnimType = ANIM_TYPE_ROTATION;
+    } else if (gCurrAnimType == ANIM_TYPE_VERTICAL_TRANSLATION) {
+        translation[1] += gCurrAnimPose[1] * gCurrAnimTranslationMultiplier;
+        gCurrAnimPose += 3;
         gCurrAnimType = ANIM_TYPE_ROTATION;
+    } else if (gCurrAnimType == ANIM_TYPE_NO_TRANSLATION) {
+        gCurrAnimPose += 3;
+        gCurrAnimType = ANIM_TYPE_ROTATION;
+    }
+
+    if (gCurrAnimType == ANIM_TYPE_ROTATION && gCurrAnimBases != NULL) {
+        // The rotation of this part was already built by the pose cache.
+        mtxf_mul_basis_and_translate(gMatStack[gMatStackIndex + 1], gMatStack[gMatStackIndex], *gCurrAnimBases++, translation);
+        gCurrAnimPose += 3;
     } else {
-        if (gCurrAnimType == ANIM_TYPE_LATERAL_TRANSLATION) {
-            translation[0] +=
-                gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)]
-                * gCurrAnimTranslationMultiplier;
-            gCurrAnimAttribute += 2;
-            translation[2] +=
-                gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)]
-                * gCurrAnimTranslationMultiplier;
-            gCurrAnimType = ANIM_TYPE_ROTATION;
-        } else {
-            if (gCurrAnimType == ANIM_TYPE_VERTICAL_TRANSLATION) {
-                gCurrAnimAttribute += 2;
-                translation[1] +=
-                    gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)]
-                    * gCurrAnimTranslationMultiplier;
-                gCurrAnimAttribute += 2;
-                gCurrAnimType = ANIM_TYPE_ROTATION;
-            } else if (gCurrAnimType == ANIM_TYPE_NO_TRANSLATION) {
-                gCurrAnimAttribute += 6;
-                gCurrAnimType = ANIM_TYPE_ROTATION;
-            }
+        if (gCurrAnimType == ANIM_TYPE_ROTATION) {
+            vec3s_copy(rotation, gCurrAnimPose);
+            gCurrAnimPose += 3;
         }
-    }
 
-    if (gCurrAnimType == ANIM_TYPE_ROTATION) {
-        rotation[0] = gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
-        rotation[1] = gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
-        rotation[2] = gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        mtxf_rotate_xyz_and_translate_and_mul(rotation, translation, gMatStack[gMatStackIndex + 1], gMatStack[gMatStackIndex]);
     }
 
-    mtxf_rotate_xyz_and_translate_and_mul(rotation, translation, gMatStack[gMatStackIndex + 1], gMatStack[gMatStackIndex]);
-
     inc_mat_stack();
     append_dl_and_return(((struct GraphNodeDisplayList *)node));
 }
 
+/**
+ * Advance an object's animation frame for this frame. This also has to happen for
+ * objects that are culled, since behaviors check their animation frame.
+ */
+static void geo_advance_animation(struct AnimInfo *node, s32 hasAnimation) {
+    if (hasAnimation) {
+        node->animFrame = geo_update_animation_frame(node, &node->animFrameAccelAssist);
+    }
+    node->animTimer = gAreaUpdateCounter;
+}
+
+#ifdef ANIMATION_POSE_CACHE
+/**
+ * Find the pose of the current animation frame in the pose cache, decoding it into
+ * the cache if it isn't there yet. Returns NULL if the cache is full.
+ */
+static struct PoseCacheEntry *geo_find_cached_pose(struct Animation *anim, s32 numChannels) {
+    u32 slot = (((uintptr_t) anim >> 2) ^ (gCurrAnimFrame * 37)) % POSE_CACHE_ENTRIES;
+
+    for (s32 i = 0; i < POSE_CACHE_ENTRIES; i++) {
+        struct PoseCacheEntry *entry = &sPoseCache[slot];
+
+        if (entry->stamp != sPoseCacheStamp) {
+            u32 poseSize = ALIGN8(numChannels * sizeof(s16));
+            u32 size = poseSize + (anim->numParts * sizeof(Vec3f[3]));
+
+            if (sPoseCacheUsed + size > sizeof(sPoseCacheBuffer)) {
+                return NULL;
+            }
+
+            entry->anim = anim;
+            entry->stamp = sPoseCacheStamp;
+            entry->frame = gCurrAnimFrame;
+            entry->pose = (s16 *) &sPoseCacheBuffer[sPoseCacheUsed];
+            entry->bases = (Vec3f (*)[3]) &sPoseCacheBuffer[sPoseCacheUsed + poseSize];
+            sPoseCacheUsed += size;
+
+            geo_decode_animation_frame(entry->pose, segmented_to_virtual((void *) anim->values),
+                                       segmented_to_virtual((void *) anim->index), gCurrAnimFrame, numChannels);
+            for (s32 part = 0; part < anim->numParts; part++) {
+                mtxf_rotate_xyz_basis(entry->bases[part], &entry->pose[3 + (part * 3)]);
+            }
+            PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.pose_cache_misses);
+            return entry;
+        }
+
+        if (entry->anim == anim && entry->frame == gCurrAnimFrame) {
+            PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.pose_cache_hits);
+            return entry;
+        }
+
+        slot = (slot + 1) % POSE_CACHE_ENTRIES;
+    }
+
+    return NULL;
+}
+#endif
+
+/**
+ * Decode the pose of the current animation frame: the root translation, then a rotation for each part.
+ */
+static void geo_set_animation_pose(struct Animation *anim) {
+    s32 numChannels = (anim->numParts + 1) * 3;
+
+    aggress(anim->numParts <= MAX_ANIM_POSE_PARTS, "Animation has more parts than MAX_ANIM_POSE_PARTS.");
+
+#ifdef ANIMATION_POSE_CACHE
+    struct PoseCacheEntry *entry = geo_find_cached_pose(anim, numChannels);
+    if (entry != NULL) {
+        gCurrAnimPose = entry->pose;
+        gCurrAnimBases = entry->bases;
+        return;
+    }
+    PUPPYPRINT_ADD_COUNTER(gPuppyCallCounter.pose_cache_misses);
+#endif
+
+    gCurrAnimBases = NULL;
+    gCurrAnimPose = sAnimPoseBuffers[gCurGraphNodeHeldObject != NULL];
+    geo_decode_animation_frame(gCurrAnimPose, segmented_to_virtual((void *) anim->values),
+                               segmented_to_virtual((void *) anim->index), gCurrAnimFrame, numChannels);
+}
+
 /**
  * Initialize the animation-related global variables for the currently drawn
  * object's animation.
@@ -822,10 +994,7 @@ void geo_process_animated_part(struct GraphNodeAnimatedPart *node) {
 void geo_set_animation_globals(struct AnimInfo *node, s32 hasAnimation) {
     struct Animation *anim = node->curAnim;
 
-    if (hasAnimation) {
-        node->animFrame = geo_update_animation_frame(node, &node->animFrameAccelAssist);
-    }
-    node->animTimer = gAreaUpdateCounter;
+    geo_advance_animation(node, hasAnimation);
     if (anim->flags & ANIM_FLAG_HOR_TRANS) {
         gCurrAnimType = ANIM_TYPE_VERTICAL_TRANSLATION;
     } else if (anim->flags & ANIM_FLAG_VERT_TRANS) {
@@ -838,8 +1007,7 @@ void geo_set_animation_globals(struct AnimInfo *node, s32 hasAnimation) {
 
     gCurrAnimFrame = node->animFrame;
     gCurrAnimEnabled = (anim->flags & ANIM_FLAG_DISABLED) == 0;
-    gCurrAnimAttribute = segmented_to_virtual((void *) anim->index);
-    gCurrAnimData = segmented_to_virtual((void *) anim->values);
+    geo_set_animation_pose(anim);
 
     if (anim->animYTransDivisor == 0) {
         gCurrAnimTranslationMultiplier = 1.0f;
@@ -881,11 +1049,9 @@ void geo_process_shadow(struct GraphNodeShadow *node) {
 
             f32 animScale = gCurrAnimTranslationMultiplier * objScale;
             Vec3f animOffset;
-            animOffset[0] = gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)] * animScale;
+            animOffset[0] = gCurrAnimPose[0] * animScale;
             animOffset[1] = 0.0f;
-            gCurrAnimAttribute += 2;
-            animOffset[2] = gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)] * animScale;
-            gCurrAnimAttribute -= 6;
+            animOffset[2] = gCurrAnimPose[2] * animScale;
 
             // simple matrix rotation so the shadow offset rotates along with the object
             f32 sinAng = sins(gCurGraphNodeObject->angle[1]);
@@ -1041,50 +1207,61 @@ void geo_process_object(struct Object *node) {
         s32 noThrowMatrix = (node->header.gfx.throwMatrix == NULL);
         // Maintain throw matrix pointer if the game is paused as it won't be updated.
         Mat4 *oldThrowMatrix = (sCurrPlayMode == PLAY_MODE_PAUSED) ? node->header.gfx.throwMatrix : NULL;
-
-        // If the throw matrix is null and the object is invisible, there is no need
-        // to update billboarding, scale, rotation, etc. 
-        // This still updates translation since it is needed for sound.
-        if (isInvisible && noThrowMatrix) {
-            mtxf_translate(gMatStack[gMatStackIndex + 1], node->header.gfx.pos);
+        Vec3f objPos;
+
+        // Get the translation the object's transform would have, so it can be
+        // culled before building the full rotation, scale and billboard matrix.
+        if (!noThrowMatrix) {
+            vec3f_copy(objPos, (*node->header.gfx.throwMatrix)[3]);
+        } else if (node->header.gfx.node.flags & GRAPH_RENDER_BILLBOARD) {
+            vec3f_sum(objPos, node->header.gfx.pos, gMatStack[gMatStackIndex][3]);
+        } else {
+            vec3f_copy(objPos, node->header.gfx.pos);
         }
-        else{
-            if (!noThrowMatrix) {
-                mtxf_scale_vec3f(gMatStack[gMatStackIndex + 1], *node->header.gfx.throwMatrix, node->header.gfx.scale);
-            } else if (node->header.gfx.node.flags & GRAPH_RENDER_BILLBOARD) {
-                mtxf_billboard(gMatStack[gMatStackIndex + 1], gMatStack[gMatStackIndex],
-                            node->header.gfx.pos, node->header.gfx.scale, gCurGraphNodeCamera->roll);
-            } else {
-                mtxf_rotate_zxy_and_translate(gMatStack[gMatStackIndex + 1], node->header.gfx.pos, node->header.gfx.angle);
-                mtxf_scale_vec3f(gMatStack[gMatStackIndex + 1], gMatStack[gMatStackIndex + 1], node->header.gfx.scale);
+
+        // This is still needed by culled and invisible objects since it is used for sound.
+        linear_mtxf_mul_vec3f_and_translate(gCameraTransform, node->header.gfx.cameraToObject, objPos);
+
+        // Objects that would run into the gfx pool's reserve are left out like culled ones.
+        if (isInvisible || !obj_is_in_view(&node->header.gfx) || geo_gfx_pool_in_reserve()) {
+            if (node->header.gfx.animInfo.curAnim != NULL) {
+                geo_advance_animation(&node->header.gfx.animInfo, (node->header.gfx.node.flags & GRAPH_RENDER_HAS_ANIMATION) != 0);
             }
+            node->header.gfx.throwMatrix = oldThrowMatrix;
+            return;
+        }
+
+        if (!noThrowMatrix) {
+            mtxf_scale_vec3f(gMatStack[gMatStackIndex + 1], *node->header.gfx.throwMatrix, node->header.gfx.scale);
+        } else if (node->header.gfx.node.flags & GRAPH_RENDER_BILLBOARD) {
+            mtxf_billboard(gMatStack[gMatStackIndex + 1], gMatStack[gMatStackIndex],
+                           node->header.gfx.pos, node->header.gfx.scale, gCurGraphNodeCamera->roll);
+        } else {
+            mtxf_rotate_zxy_and_translate(gMatStack[gMatStackIndex + 1], node->header.gfx.pos, node->header.gfx.angle);
+            mtxf_scale_vec3f(gMatStack[gMatStackIndex + 1], gMatStack[gMatStackIndex + 1], node->header.gfx.scale);
         }
 
-        node->header.gfx.throwMatrix = &gMatStack[++gMatStackIndex];
-        linear_mtxf_mul_vec3f_and_translate(gCameraTransform, node->header.gfx.cameraToObject, (*node->header.gfx.throwMatrix)[3]);
+        node->header.gfx.throwMatrix = &gMatStack[gMatStackIndex + 1];
 
         // FIXME: correct types
         if (node->header.gfx.animInfo.curAnim != NULL) {
             geo_set_animation_globals(&node->header.gfx.animInfo, (node->header.gfx.node.flags & GRAPH_RENDER_HAS_ANIMATION) != 0);
         }
 
-        if (!isInvisible && obj_is_in_view(&node->header.gfx)) {
-            gMatStackIndex--;
-            inc_mat_stack();
+        inc_mat_stack();
 
-            if (node->header.gfx.sharedChild != NULL) {
+        if (node->header.gfx.sharedChild != NULL) {
 #ifdef VISUAL_DEBUG
-                if (hitboxView) visualise_object_hitbox(node);
+            if (hitboxView) visualise_object_hitbox(node);
 #endif
-                gCurGraphNodeObject = (struct GraphNodeObject *) node;
-                node->header.gfx.sharedChild->parent = &node->header.gfx.node;
-                geo_process_node_and_siblings(node->header.gfx.sharedChild);
-                node->header.gfx.sharedChild->parent = NULL;
-                gCurGraphNodeObject = NULL;
-            }
-            if (node->header.gfx.node.children != NULL) {
-                geo_process_node_and_siblings(node->header.gfx.node.children);
-            }
+            gCurGraphNodeObject = (struct GraphNodeObject *) node;
+            node->header.gfx.sharedChild->parent = &node->header.gfx.node;
+            geo_process_node_and_siblings(node->header.gfx.sharedChild);
+            node->header.gfx.sharedChild->parent = NULL;
+            gCurGraphNodeObject = NULL;
+        }
+        if (node->header.gfx.node.children != NULL) {
+            geo_process_node_and_siblings(node->header.gfx.node.children);
         }
 
         gMatStackIndex--;
@@ -1117,10 +1294,6 @@ void geo_process_held_object(struct GraphNodeHeldObject *node) {
     Vec3f translation;
     Mat4 tempMtx;
 
-#ifdef F3DEX_GBI_2
-    gSPLookAt(gDisplayListHead++, gCurLookAt);
-#endif
-
     if (node->fnNode.func != NULL) {
         node->fnNode.func(GEO_CONTEXT_RENDER, &node->fnNode.node, gMatStack[gMatStackIndex]);
     }
@@ -1143,8 +1316,8 @@ void geo_process_held_object(struct GraphNodeHeldObject *node) {
         gGeoTempState.enabled = gCurrAnimEnabled;
         gGeoTempState.frame = gCurrAnimFrame;
         gGeoTempState.translationMultiplier = gCurrAnimTranslationMultiplier;
-        gGeoTempState.attribute = gCurrAnimAttribute;
-        gGeoTempState.data = gCurrAnimData;
+        gGeoTempState.pose = gCurrAnimPose;
+        gGeoTempState.bases = gCurrAnimBases;
         gCurrAnimType = ANIM_TYPE_NONE;
         gCurGraphNodeHeldObject = (void *) node;
         if (node->objNode->header.gfx.animInfo.curAnim != NULL) {
@@ -1157,8 +1330,8 @@ void geo_process_held_object(struct GraphNodeHeldObject *node) {
         gCurrAnimEnabled = gGeoTempState.enabled;
         gCurrAnimFrame = gGeoTempState.frame;
         gCurrAnimTranslationMultiplier = gGeoTempState.translationMultiplier;
-        gCurrAnimAttribute = gGeoTempState.attribute;
-        gCurrAnimData = gGeoTempState.data;
+        gCurrAnimPose = gGeoTempState.pose;
+        gCurrAnimBases = gGeoTempState.bases;
         gMatStackIndex--;
     }
 
@@ -1242,16 +1415,22 @@ void geo_process_node_and_siblings(struct GraphNode *firstNode) {
  */
 void geo_process_root(struct GraphNodeRoot *node, Vp *b, Vp *c, s32 clearColor) {
     if (node->node.flags & GRAPH_RENDER_ACTIVE) {
-        Mtx *initialMatrix;
         Vp *viewport = alloc_display_list(sizeof(*viewport));
+        Mtx *initialMatrix = alloc_display_list(sizeof(*initialMatrix));
 
-        gDisplayListHeap = alloc_only_pool_init(main_pool_available() - sizeof(struct AllocOnlyPool), MEMORY_POOL_LEFT);
-        initialMatrix = alloc_display_list(sizeof(*initialMatrix));
         gCurLookAt = (LookAt*)alloc_display_list(sizeof(LookAt));
+        if (viewport == NULL || initialMatrix == NULL || gCurLookAt == NULL) {
+            return;
+        }
         bzero(gCurLookAt, sizeof(LookAt));
+        gDisplayListHeap = alloc_only_pool_init(main_pool_available() - sizeof(struct AllocOnlyPool), MEMORY_POOL_LEFT);
 
         gMatStackIndex = 0;
         gCurrAnimType = ANIM_TYPE_NONE;
+#ifdef ANIMATION_POSE_CACHE
+        sPoseCacheStamp++;
+        sPoseCacheUsed = 0;
+#endif
         vec3s_set(viewport->vp.vtrans, node->x * 4, node->y * 4, 511);
         vec3s_set(viewport->vp.vscale, node->width * 4, node->height * 4, 511);
 
@@ -0,0 +1,274 @@
+#include <ultra64.h>
+#include <PR/os_internal.h>
+
+#include "sm64.h"
+#include "buffers/buffers.h"
+#include "farcall.h"
+#include "game_init.h"
+#include "main.h"
+#include "sampling_profiler.h"
+#include "segments.h"
+
+#ifdef SAMPLING_PROFILER
+
+#include "printf.h"
+#include "usb/debug.h"
+
+/**
+ * A statistical profiler for the game thread.
+ * A high priority thread is woken SAMPLING_PROFILER_HZ times a second by a timer, which preempts the game thread and saves its context.
+ * The sampler then records the game thread's PC, and anything on its stack that looks like a return address, into a ring buffer.
+ * Samples where the idle thread or another thread (e.g. audio) was running are only counted.
+ * Dumping symbolizes the buffer with the packed map and prints a flat profile and one collapsed stack per sample over USB.
+ * tools/sampling_profile.py turns the dump into flamegraph-compatible text.
+ */
+
+// How many words above the stack pointer are searched for return addresses.
+#define STACK_SCAN_LIMIT 256
+// Size of the table used to count samples per function for the flat profile.
+#define FLAT_PROFILE_TABLE_SIZE 256
+#define FLAT_PROFILE_NUM_PRINTED 32
+// Names in collapsed stacks are shortened so a whole stack fits in one debug_printf.
+#define COLLAPSED_NAME_LENGTH ((240 / (SAMPLING_PROFILER_STACK_DEPTH + 1)) - 1)
+
+extern far char *parse_map(u32 pc);
+
+// Runnable threads, highest priority first.
+extern OSThread *__osRunQueue;
+
+extern u8 _mainSegmentStart[];
+extern u8 _mainSegmentTextEnd[];
+extern u8 _engineSegmentStart[];
+extern u8 _engineSegmentTextEnd[];
+extern u8 _goddardSegmentStart[];
+extern u8 _goddardSegmentTextEnd[];
+
+struct FlatProfileEntry {
+    char *name;
+    u16 self;
+    u16 total;
+};
+
+static OSThread sSamplerThread;
+static u64 sSamplerThreadStack[0x400 / sizeof(u64)];
+static OSMesgQueue sSamplerMesgQueue;
+static OSMesg sSamplerMesg;
+static OSTimer sSamplerTimer;
+
+static struct ProfilerSample sSamples[SAMPLING_PROFILER_NUM_SAMPLES];
+static u32 sSampleIndex = 0;
+static u32 sNumSamples = 0;
+static u32 sNumIdleSamples = 0;
+static u32 sNumOtherThreadSamples = 0;
+static volatile u8 sSamplingPaused = FALSE;
+
+static struct FlatProfileEntry sFlatProfile[FLAT_PROFILE_TABLE_SIZE];
+
+static s32 is_code_address(u32 addr) {
+    return ((addr >= (u32) _mainSegmentStart    && addr < (u32) _mainSegmentTextEnd)
+         || (addr >= (u32) _engineSegmentStart  && addr < (u32) _engineSegmentTextEnd)
+         || (addr >= (u32) _goddardSegmentStart && addr < (u32) _goddardSegmentTextEnd));
+}
+
+/**
+ * Records the preempted game thread. Frames are found by scanning the stack for words that point into code,
+ * so a few stale return addresses can show up, but there's no unwind info to do better.
+ */
+static void record_sample(OSThread *thread) {
+    __OSThreadContext *tc = &thread->context;
+    struct ProfilerSample *sample = &sSamples[sSampleIndex];
+    u32 *sp = (u32 *)(u32) tc->sp;
+    u32 *stackTop = (u32 *)(gThread5Stack + THREAD5_STACK);
+    u32 prev = (u32) tc->ra;
+    s32 depth = 0;
+    s32 i;
+
+    // The timer interrupt put the thread it interrupted back on the run queue, ahead of any lower priority threads.
+    // The game thread is also runnable while the audio thread or another higher priority thread has preempted it,
+    // so it was only running if it's at the head. Threads with a higher priority than the sampler can't be interrupted,
+    // so their time goes to whichever thread runs when they finish.
+    OSThread *interrupted = __osRunQueue;
+
+    if (interrupted != thread) {
+        // An empty queue ends at a placeholder thread with a priority of -1.
+        if (interrupted->priority <= OS_PRIORITY_IDLE) {
+            sNumIdleSamples++;
+        } else {
+            sNumOtherThreadSamples++;
+        }
+        return;
+    }
+
+    sample->pc = tc->pc;
+
+    // The leaf function may not have saved ra yet.
+    if (is_code_address(prev)) {
+        sample->stack[depth++] = prev;
+    }
+
+    for (i = 0; i < STACK_SCAN_LIMIT && depth < SAMPLING_PROFILER_STACK_DEPTH && &sp[i] < stackTop; i++) {
+        u32 word = sp[i];
+
+        if (word != prev && is_code_address(word)) {
+            sample->stack[depth++] = word;
+            prev = word;
+        }
+    }
+
+    for (; depth < SAMPLING_PROFILER_STACK_DEPTH; depth++) {
+        sample->stack[depth] = 0;
+    }
+
+    if (++sSampleIndex >= SAMPLING_PROFILER_NUM_SAMPLES) {
+        sSampleIndex = 0;
+    }
+    if (sNumSamples < SAMPLING_PROFILER_NUM_SAMPLES) {
+        sNumSamples++;
+    }
+}
+
+static void thread10_sampling_profiler(UNUSED void *arg) {
+    OSMesg msg;
+
+    while (TRUE) {
+        osRecvMesg(&sSamplerMesgQueue, &msg, OS_MESG_BLOCK);
+        if (!sSamplingPaused) {
+            record_sample(&gGameLoopThread);
+        }
+    }
+}
+
+void sampling_profiler_init(void) {
+    OSTime interval = OS_USEC_TO_CYCLES(1000000 / SAMPLING_PROFILER_HZ);
+
+    osCreateMesgQueue(&sSamplerMesgQueue, &sSamplerMesg, 1);
+    osCreateThread(&sSamplerThread, THREAD_10_SAMPLING_PROFILER, thread10_sampling_profiler, NULL,
+                   (u8 *) sSamplerThreadStack + sizeof(sSamplerThreadStack), 30);
+    osStartThread(&sSamplerThread);
+    osSetTimer(&sSamplerTimer, interval, interval, &sSamplerMesgQueue, NULL);
+}
+
+static char *get_symbol_name(u32 addr) {
+    char *name = NULL;
+
+    if ((u32) parse_map != MAP_PARSER_ADDRESS) {
+        name = parse_map(addr);
+    }
+
+    return ((name != NULL) ? name : "?");
+}
+
+static struct FlatProfileEntry *get_flat_profile_entry(char *name) {
+    u32 i = (((u32) name >> 2) & (FLAT_PROFILE_TABLE_SIZE - 1));
+
+    // The names are unique pointers into the map, so they can be hashed directly.
+    for (s32 probes = 0; probes < FLAT_PROFILE_TABLE_SIZE; probes++) {
+        if (sFlatProfile[i].name == name || sFlatProfile[i].name == NULL) {
+            sFlatProfile[i].name = name;
+            return &sFlatProfile[i];
+        }
+        i = ((i + 1) & (FLAT_PROFILE_TABLE_SIZE - 1));
+    }
+
+    return NULL;
+}
+
+static void dump_flat_profile(void) {
+    struct FlatProfileEntry *entry;
+    char *names[SAMPLING_PROFILER_STACK_DEPTH + 1];
+    s32 i, j, k;
+
+    bzero(sFlatProfile, sizeof(sFlatProfile));
+
+    for (i = 0; i < (s32) sNumSamples; i++) {
+        struct ProfilerSample *sample = &sSamples[i];
+        s32 numNames = 0;
+
+        names[numNames++] = get_symbol_name(sample->pc);
+        for (j = 0; j < SAMPLING_PROFILER_STACK_DEPTH && sample->stack[j] != 0; j++) {
+            names[numNames++] = get_symbol_name(sample->stack[j]);
+        }
+
+        entry = get_flat_profile_entry(names[0]);
+        if (entry != NULL) {
+            entry->self++;
+        }
+
+        // Recursive functions only count once towards their total.
+        for (j = 0; j < numNames; j++) {
+            for (k = 0; k < j && names[k] != names[j]; k++);
+            if (k == j && (entry = get_flat_profile_entry(names[j])) != NULL) {
+                entry->total++;
+            }
+        }
+    }
+
+    debug_printf("FLAT self total name\n");
+    for (i = 0; i < FLAT_PROFILE_NUM_PRINTED; i++) {
+        struct FlatProfileEntry *best = NULL;
+
+        for (j = 0; j < FLAT_PROFILE_TABLE_SIZE; j++) {
+            entry = &sFlatProfile[j];
+            if (entry->self != 0 && (best == NULL || entry->self > best->self)) {
+                best = entry;
+            }
+        }
+        if (best == NULL) {
+            break;
+        }
+
+        debug_printf("F %d %d %s\n", best->self, best->total, best->name);
+        best->self = 0;
+    }
+}
+
+/**
+ * Prints one line per sample, outermost frame first, separated by semicolons.
+ */
+static void dump_collapsed_stacks(void) {
+    char line[256];
+
+    for (s32 i = 0; i < (s32) sNumSamples; i++) {
+        struct ProfilerSample *sample = &sSamples[i];
+        s32 len = 0;
+        s32 depth;
+
+        for (depth = 0; depth < SAMPLING_PROFILER_STACK_DEPTH && sample->stack[depth] != 0; depth++);
+
+        while (--depth >= 0) {
+            len += sprintf(&line[len], "%.*s;", COLLAPSED_NAME_LENGTH, get_symbol_name(sample->stack[depth]));
+        }
+        sprintf(&line[len], "%.*s", COLLAPSED_NAME_LENGTH, get_symbol_name(sample->pc));
+
+        debug_printf("S %s\n", line);
+    }
+}
+
+/**
+ * Prints everything in the ring buffer over USB. Sampling is paused while dumping, so the dump doesn't profile itself.
+ */
+void sampling_profiler_dump(void) {
+    sSamplingPaused = TRUE;
+
+    debug_printf("SAMPLEPROF BEGIN %d %d %d %d\n", sNumSamples, sNumIdleSamples, SAMPLING_PROFILER_HZ, sNumOtherThreadSamples);
+    dump_flat_profile();
+    dump_collapsed_stacks();
+    debug_printf("SAMPLEPROF END\n");
+
+    sSampleIndex = 0;
+    sNumSamples = 0;
+    sNumIdleSamples = 0;
+    sNumOtherThreadSamples = 0;
+    sSamplingPaused = FALSE;
+}
+
+/**
+ * Press L + D-Pad Down to dump the profile.
+ */
+void sampling_profiler_update(void) {
+    if ((gPlayer1Controller->buttonPressed & (L_TRIG | D_JPAD)) && (gPlayer1Controller->buttonDown & L_TRIG) && (gPlayer1Controller->buttonDown & D_JPAD)) {
+        sampling_profiler_dump();
+    }
+}
+
+#endif
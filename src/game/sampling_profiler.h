@@ -0,0 +1,24 @@
+#ifndef SAMPLING_PROFILER_H
+#define SAMPLING_PROFILER_H
+
+#include <PR/ultratypes.h>
+
+#include "config.h"
+
+#ifdef SAMPLING_PROFILER
+// One recorded sample of the game thread: its PC followed by the return addresses found on its stack, innermost first.
+struct ProfilerSample {
+    u32 pc;
+    u32 stack[SAMPLING_PROFILER_STACK_DEPTH];
+};
+
+void sampling_profiler_init(void);
+void sampling_profiler_update(void);
+void sampling_profiler_dump(void);
+#else
+#define sampling_profiler_init()
+#define sampling_profiler_update()
+#define sampling_profiler_dump()
+#endif
+
+#endif // SAMPLING_PROFILER_H
@@ -3,6 +3,7 @@
 #include "area.h"
 #include "audio/external.h"
 #include "audio/load.h"
+#include "audio/playback.h"
 #include "engine/graph_node.h"
 #include "engine/math_util.h"
 #include "level_table.h"
@@ -367,6 +368,10 @@ void thread4_sound(UNUSED void *arg) {
         OSMesg msg;
 
         osRecvMesg(&sSoundMesgQueue, &msg, OS_MESG_BLOCK);
+#ifdef ADAPTIVE_POLYPHONY
+        // Timed over the same span as the profiler, but also without it.
+        u32 audioStart = osGetCount();
+#endif
         profiler_audio_started(); // also starts PROFILER_TIME_SUB_AUDIO_UPDATE inside
         if (gResetTimer < 25) {
             struct SPTask *spTask = create_next_audio_frame_task();
@@ -375,5 +380,8 @@ void thread4_sound(UNUSED void *arg) {
             }
         }
         profiler_audio_completed(); // also completes PROFILER_TIME_SUB_AUDIO_UPDATE inside
+#ifdef ADAPTIVE_POLYPHONY
+        update_note_budget(osGetCount() - audioStart);
+#endif
     }
 }
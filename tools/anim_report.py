@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+# Prints the size of every animation in the tree (actor, level and Mario animations), including how
+# many of its channels are constant, and checks that each one can be decoded a whole frame at a time
+# by geo_decode_animation_frame: the part count must match the index and fit the pose buffers, and
+# every channel must stay inside its values array.
+#
+# With --c it prints every animation as C source instead, for tools/animposetest.c.
+#
+# usage: anim_report.py [--totals | --c]   (run from the repository root)
+
+import sys
+import re
+import glob
+
+ARRAY_RE = re.compile(r"(u16|s16)\s+(\w+)\[\]\s*=\s*\{(.*?)\};", re.S)
+ANIM_RE = re.compile(r"struct Animation\s+(\w+)(?:\[\])?\s*=\s*\{(.*?)\};", re.S)
+NUMPARTS_RE = re.compile(r"ANIMINDEX_NUMPARTS\((\w+)\)")
+MAX_ANIM_POSE_PARTS = 64 # src/game/rendering_graph_node.c
+
+def strip_comments(text):
+	text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+	return re.sub(r"//.*", "", text)
+
+def read_arrays(directory):
+	arrays = {}
+	for filename in sorted(glob.glob(directory + "/*.inc.c")):
+		text = strip_comments(open(filename).read())
+		for match in ARRAY_RE.finditer(text):
+			values = [int(x, 0) for x in match.group(3).split(",") if x.strip()]
+			arrays[match.group(2)] = values
+	return arrays
+
+def read_animations():
+	files = sorted(glob.glob("actors/*/anims/*.inc.c")
+	             + glob.glob("levels/*/areas/*/*/anim.inc.c")
+	             + glob.glob("assets/anims/*.inc.c"))
+	arrayCache = {}
+	for filename in files:
+		directory = filename.rsplit("/", 1)[0]
+		if directory not in arrayCache:
+			arrayCache[directory] = read_arrays(directory)
+		arrays = arrayCache[directory]
+
+		text = strip_comments(open(filename).read())
+		for match in ANIM_RE.finditer(text):
+			fields = [x.strip() for x in match.group(2).split(",") if x.strip()]
+			numParts = NUMPARTS_RE.match(fields[5])
+			if numParts:
+				numParts = len(arrays[numParts.group(1)]) // 6 - 1
+			else:
+				numParts = int(fields[5], 0)
+			yield {
+				"name": match.group(1),
+				"file": filename,
+				"frames": int(fields[4], 0),
+				"numParts": numParts,
+				"values": arrays[fields[6]],
+				"index": arrays[fields[7]],
+			}
+
+def print_c_source():
+	arrayNames = {}
+	anims = list(read_animations())
+
+	print('#include <ultra64.h>')
+	print('#include "types.h"')
+	print()
+	for anim in anims:
+		for kind, ctype in (("values", "s16"), ("index", "u16")):
+			if id(anim[kind]) not in arrayNames:
+				name = "sAnim%s%d" % (kind.capitalize(), len(arrayNames))
+				arrayNames[id(anim[kind])] = name
+				if ctype == "s16":
+					data = ", ".join(str(x - 0x10000 if x >= 0x8000 else x) for x in anim[kind])
+				else:
+					data = ", ".join(str(x) for x in anim[kind])
+				print("static const %s %s[] = { %s };" % (ctype, name, data))
+
+	print()
+	print("const struct Animation gAnimPoseTestAnims[] = {")
+	for anim in anims:
+		print("    { 0, 0, 0, 0, %d, %d, %s, %s, 0 }," % (anim["frames"], anim["numParts"], arrayNames[id(anim["values"])], arrayNames[id(anim["index"])]))
+	print("};")
+	print("const char *gAnimPoseTestAnimNames[] = {")
+	for anim in anims:
+		print('    "%s",' % anim["name"])
+	print("};")
+	print("const s32 gAnimPoseTestNumAnims = %d;" % len(anims))
+
+def main():
+	if "--c" in sys.argv[1:]:
+		print_c_source()
+		return
+
+	totalsOnly = "--totals" in sys.argv[1:]
+	errors = 0
+	totals = {"anims": 0, "channels": 0, "constant": 0, "indexBytes": 0, "valueBytes": 0, "poseBytes": 0}
+	sharedValues = set()
+
+	if not totalsOnly:
+		print("%-44s %5s %6s %8s %8s %7s %7s" % ("animation", "parts", "frames", "channels", "constant", "index", "values"))
+
+	for anim in read_animations():
+		index = anim["index"]
+		values = anim["values"]
+		numChannels = (anim["numParts"] + 1) * 3
+		channels = [(index[i * 2], index[i * 2 + 1]) for i in range(len(index) // 2)]
+		constant = sum(1 for length, offset in channels if length <= 1)
+
+		if numChannels * 2 != len(index):
+			print("%s: %s has %d parts but its index holds %d channels" % (anim["file"], anim["name"], anim["numParts"], len(index) // 2), file=sys.stderr)
+			errors += 1
+		if anim["numParts"] > MAX_ANIM_POSE_PARTS:
+			print("%s: %s has %d parts, more than MAX_ANIM_POSE_PARTS (%d)" % (anim["file"], anim["name"], anim["numParts"], MAX_ANIM_POSE_PARTS), file=sys.stderr)
+			errors += 1
+		for length, offset in channels:
+			if length == 0 or offset + length > len(values):
+				print("%s: %s reads past the end of its values" % (anim["file"], anim["name"]), file=sys.stderr)
+				errors += 1
+				break
+
+		totals["anims"] += 1
+		totals["channels"] += len(channels)
+		totals["constant"] += constant
+		totals["indexBytes"] += len(index) * 2
+		if id(values) not in sharedValues:
+			sharedValues.add(id(values))
+			totals["valueBytes"] += len(values) * 2
+		totals["poseBytes"] = max(totals["poseBytes"], numChannels * 2)
+
+		if not totalsOnly:
+			print("%-44s %5d %6d %8d %8d %7d %7d" % (anim["name"], anim["numParts"], anim["frames"], len(channels), constant, len(index) * 2, len(values) * 2))
+
+	print("%d animations, %d channels (%d constant, %.1f%%), %d index bytes, %d value bytes, largest decoded pose %d bytes" % (
+		totals["anims"], totals["channels"], totals["constant"], 100.0 * totals["constant"] / max(totals["channels"], 1),
+		totals["indexBytes"], totals["valueBytes"], totals["poseBytes"]))
+
+	if errors:
+		sys.exit(1)
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ultra64.h>
+
+// Host tests for the MARIO_ANIM_CACHE DMA table cache in src/boot/memory.c
+//
+// Builds a DMA table of animations with random sizes in a fake ROM, then replays random animation
+// changes against the cache the way Mario's animation code uses it: every frame loads the current
+// animation, patching it when the cache says it was newly loaded, and prefetches a few that often
+// follow it. Every returned animation is compared against the ROM data, once when it is returned
+// and again after the prefetches, which must never overwrite the animation in use. Prefetches finish
+// a random number of polls after they start, and their destination holds garbage until they do.
+// The cache size defaults to MARIO_ANIM_CACHE; smaller ones evict more often.
+//
+//   animcachetest [-f frames] [-n animations] [-c cache size] [-s seed]
+
+#include "boot/memory.c"
+
+#define ROM_SIZE 0x400000
+#define MAX_ANIMS 256
+#define MAX_ANIM_SIZE 13000
+#define NUM_COMMON_ANIMS 20
+#define PREFETCHES_PER_FRAME 4
+
+// What memory.c needs from the rest of the game.
+OSIoMesg gDmaIoMesg;
+OSMesg gMainReceivedMesg;
+OSMesgQueue gDmaMesgQueue;
+Gfx *gDisplayListHead;
+u8 *gGfxPoolEnd;
+u8 _engineSegmentStart[1], _engineSegmentEnd[1], _engineSegmentRomStart[1], _engineSegmentRomEnd[1];
+
+static u8 sRom[ROM_SIZE];
+static u8 sPool[0x40000];
+static u8 sCacheBuffer[MARIO_ANIM_CACHE];
+
+// The one transfer in flight for each message queue, finished a few polls after it starts.
+struct PendingDma
+{
+	OSMesgQueue *queue;
+	u8 *dest;
+	const u8 *src;
+	u32 size;
+	s32 polls;
+};
+
+static struct PendingDma sPendingDmas[2];
+
+static void finish_dma(struct PendingDma *dma)
+{
+	memcpy(dma->dest, dma->src, dma->size);
+	dma->queue->validCount++;
+	dma->queue = NULL;
+}
+
+s32 osPiStartDma(UNUSED OSIoMesg *mb, UNUSED s32 priority, UNUSED s32 direction, u32 devAddr, void *vAddr, u32 nbytes,
+                 OSMesgQueue *mq)
+{
+	for (u32 i = 0; i < ARRAY_COUNT(sPendingDmas); i++)
+	{
+		struct PendingDma *dma = &sPendingDmas[i];
+
+		if (dma->queue == NULL)
+		{
+			dma->queue = mq;
+			dma->dest = vAddr;
+			dma->src = (const u8 *) (uintptr_t) devAddr;
+			dma->size = nbytes;
+			dma->polls = rand() % 4;
+			memset(vAddr, 0xAA, nbytes);
+			return 0;
+		}
+	}
+	printf("more than one DMA in flight on a queue\n");
+	exit(1);
+}
+
+s32 osRecvMesg(OSMesgQueue *mq, UNUSED OSMesg *msg, s32 flag)
+{
+	for (u32 i = 0; i < ARRAY_COUNT(sPendingDmas); i++)
+	{
+		struct PendingDma *dma = &sPendingDmas[i];
+
+		if (dma->queue == mq && (flag == OS_MESG_BLOCK || dma->polls-- <= 0))
+			finish_dma(dma);
+	}
+	if (mq->validCount == 0)
+	{
+		if (flag == OS_MESG_BLOCK)
+		{
+			printf("blocking on a queue nothing will send to\n");
+			exit(1);
+		}
+		return -1;
+	}
+	mq->validCount--;
+	return 0;
+}
+
+s32 osSendMesg(OSMesgQueue *mq, UNUSED OSMesg msg, UNUSED s32 flag)
+{
+	mq->validCount++;
+	return 0;
+}
+
+void osCreateMesgQueue(OSMesgQueue *mq, OSMesg *msg, s32 count)
+{
+	bzero(mq, sizeof(*mq));
+	mq->msg = msg;
+	mq->msgCount = count;
+}
+
+void osInvalDCache(UNUSED void *vaddr, UNUSED s32 nbytes) {}
+void osInvalICache(UNUSED void *vaddr, UNUSED s32 nbytes) {}
+void osWritebackDCacheAll(void) {}
+void osMapTLB(UNUSED s32 index, UNUSED OSPageMask pm, UNUSED void *vaddr, UNUSED u32 evenpaddr, UNUSED u32 oddpaddr,
+              UNUSED s32 asid) {}
+void osSyncPrintf(UNUSED const char *fmt, ...) {}
+
+// Builds the DMA table at the start of the ROM, in the host's layout, followed by the animations.
+static struct DmaTable *build_rom(s32 numAnims)
+{
+	struct DmaTable *table = (struct DmaTable *) sRom;
+	u32 offset = ALIGN16(sizeof(struct DmaTable) + (numAnims * sizeof(struct OffsetSizePair)));
+
+	table->count = numAnims;
+	for (s32 i = 0; i < numAnims; i++)
+	{
+		u32 size = (i % 7 == 0) ? 1500 : 200 + (rand() % (MAX_ANIM_SIZE - 200));
+
+		table->anim[i].offset = offset;
+		table->anim[i].size = size;
+		for (u32 j = 0; j < ALIGN16(size); j++)
+			sRom[offset + j] = rand();
+		offset += ALIGN16(size);
+	}
+	return table;
+}
+
+// Patching flips the first word, so an animation patched twice, or not at all, no longer matches.
+static void patch_anim(u8 *anim)
+{
+	*(u32 *) anim ^= 0xFFFFFFFF;
+}
+
+static s32 anim_matches(const struct DmaTable *table, s32 index, const u8 *anim)
+{
+	const u8 *rom = sRom + table->anim[index].offset;
+
+	return (*(const u32 *) anim == (*(const u32 *) rom ^ 0xFFFFFFFF))
+	    && memcmp(anim + sizeof(u32), rom + sizeof(u32), table->anim[index].size - sizeof(u32)) == 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct DmaTableCache cache;
+	s32 numFrames = 20000;
+	s32 numAnims = 209;
+	u32 cacheSize = MARIO_ANIM_CACHE;
+	s32 seed = 1;
+	s32 current = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+			numFrames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			numAnims = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+			cacheSize = strtoul(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+			seed = atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "animcachetest [-f frames] [-n animations] [-c cache size] [-s seed]\n");
+			return 1;
+		}
+	}
+	if (numAnims < NUM_COMMON_ANIMS || numAnims > MAX_ANIMS)
+	{
+		fprintf(stderr, "the number of animations must be between %d and %d\n", NUM_COMMON_ANIMS, MAX_ANIMS);
+		return 1;
+	}
+	if (cacheSize < ALIGN16(MAX_ANIM_SIZE) * 2 || cacheSize > MARIO_ANIM_CACHE)
+	{
+		fprintf(stderr, "the cache size must be between 0x%X and 0x%X\n", ALIGN16(MAX_ANIM_SIZE) * 2, MARIO_ANIM_CACHE);
+		return 1;
+	}
+
+	srand(seed);
+	struct DmaTable *table = build_rom(numAnims);
+	main_pool_init(sPool, sPool + sizeof(sPool));
+	osCreateMesgQueue(&gDmaMesgQueue, &gMainReceivedMesg, 1);
+	setup_dma_table_cache(&cache, table, sCacheBuffer, cacheSize);
+
+	for (s32 frame = 0; frame < numFrames; frame++)
+	{
+		void *anim;
+
+		// Mostly the animations of a few common actions, sometimes any of them.
+		if (rand() % 10 == 0)
+			current = (rand() % 3 == 0) ? rand() % numAnims : rand() % NUM_COMMON_ANIMS;
+
+		if (load_cached_patchable_table(&cache, current, &anim))
+			patch_anim(anim);
+		if (anim == NULL)
+		{
+			printf("frame %d: animation %d did not fit in the cache\n", frame, current);
+			return 1;
+		}
+		if (!anim_matches(table, current, anim))
+		{
+			printf("frame %d: animation %d does not match the ROM\n", frame, current);
+			return 1;
+		}
+
+		for (s32 i = 0; i < PREFETCHES_PER_FRAME; i++)
+			prefetch_patchable_table(&cache, (current + 1 + (i * 3)) % NUM_COMMON_ANIMS);
+		if (!anim_matches(table, current, anim))
+		{
+			printf("frame %d: a prefetch overwrote animation %d\n", frame, current);
+			return 1;
+		}
+	}
+
+	printf("%d frames: %u hits, %u misses, %u prefetches, %u prefetch hits, %u bytes read\n", numFrames, cache.hits,
+	       cache.misses, cache.prefetches, cache.prefetchHits, cache.dmaBytes);
+	printf("every animation matched the ROM\n");
+	return 0;
+}
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ultra64.h>
+
+// Host tests for the one-pass animation decoder in src/engine/graph_node.c
+//
+// Decodes every frame of every actor, level and Mario animation in the tree with
+// geo_decode_animation_frame and checks each channel against the value the old per-channel reads
+// give: retrieve_animation_index on each (length, offset) pair in turn, indexing into the values.
+// Frames run a few past the loop end, so channels that stop short of it are checked at their clamp.
+// The animations come from tools/anim_report.py --c.
+//
+//   animposetest [-v]
+
+#include "engine/graph_node.c"
+
+#define MAX_POSE_CHANNELS 1024
+#define EXTRA_FRAMES 4
+
+extern const struct Animation gAnimPoseTestAnims[];
+extern const char *gAnimPoseTestAnimNames[];
+extern const s32 gAnimPoseTestNumAnims;
+
+// What graph_node.c needs from the rest of the game.
+struct GraphNodeRoot *gCurGraphNodeRoot;
+struct GraphNodeMasterList *gCurGraphNodeMasterList;
+struct GraphNodePerspective *gCurGraphNodeCamFrustum;
+struct GraphNodeCamera *gCurGraphNodeCamera;
+struct GraphNodeObject *gCurGraphNodeObject;
+struct GraphNode gObjParentGraphNode;
+u16 gAreaUpdateCounter;
+Vec3f gVec3fZero;
+Vec3f gVec3fOne = { 1.0f, 1.0f, 1.0f };
+Vec3s gVec3sZero;
+
+void *alloc_only_pool_alloc(UNUSED struct AllocOnlyPool *pool, s32 size)
+{
+	return calloc(1, size);
+}
+
+void *segmented_to_virtual(const void *addr)
+{
+	return (void *) addr;
+}
+
+static s32 sNumFailures;
+
+// Checks every channel of one frame, returning the number checked.
+static s32 check_frame(s32 animIndex, s32 frame)
+{
+	const struct Animation *anim = &gAnimPoseTestAnims[animIndex];
+	s32 numChannels = (anim->numParts + 1) * 3;
+	u16 *attribute = (u16 *) anim->index;
+	s16 pose[MAX_POSE_CHANNELS];
+
+	geo_decode_animation_frame(pose, anim->values, anim->index, frame, numChannels);
+	for (s32 i = 0; i < numChannels; i++)
+	{
+		s16 expected = anim->values[retrieve_animation_index(frame, &attribute)];
+
+		if (pose[i] != expected)
+		{
+			if (sNumFailures++ < 10)
+			{
+				printf("%s: frame %d channel %d decoded as %d, expected %d\n", gAnimPoseTestAnimNames[animIndex], frame,
+				       i, pose[i], expected);
+			}
+		}
+	}
+	return numChannels;
+}
+
+int main(int argc, char **argv)
+{
+	long numChannels = 0;
+	long numFrames = 0;
+	s32 verbose = FALSE;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-v") == 0)
+			verbose = TRUE;
+		else
+		{
+			fprintf(stderr, "animposetest [-v]\n");
+			return 1;
+		}
+	}
+
+	for (s32 i = 0; i < gAnimPoseTestNumAnims; i++)
+	{
+		const struct Animation *anim = &gAnimPoseTestAnims[i];
+		long animChannels = 0;
+
+		if ((anim->numParts + 1) * 3 > MAX_POSE_CHANNELS)
+		{
+			printf("%s: %d parts is more than this test can decode\n", gAnimPoseTestAnimNames[i], anim->numParts);
+			sNumFailures++;
+			continue;
+		}
+		for (s32 frame = 0; frame < anim->loopEnd + EXTRA_FRAMES; frame++)
+		{
+			animChannels += check_frame(i, frame);
+			numFrames++;
+		}
+		numChannels += animChannels;
+		if (verbose)
+			printf("%-44s %3d parts %5d frames %8ld channels\n", gAnimPoseTestAnimNames[i], anim->numParts,
+			       anim->loopEnd + EXTRA_FRAMES, animChannels);
+	}
+
+	if (sNumFailures != 0)
+	{
+		printf("%d channels failed\n", sNumFailures);
+		return 1;
+	}
+	printf("%d animations, %ld frames, %ld channels, every channel matches retrieve_animation_index\n",
+	       gAnimPoseTestNumAnims, numFrames, numChannels);
+	return 0;
+}
@@ -741,6 +741,8 @@ def serialize_seqfile(
         with open(out_filename, "wb") as f:
             f.write(ser.finish())
 
+        return [offset + data_start for offset in entry_offsets]
+
 
 def validate_and_normalize_sequence_json(json, bank_names, defines):
     validate(isinstance(json, dict), "must have a top-level object")
@@ -877,6 +879,98 @@ def write_sequences(
         f.write(ser.finish())
 
 
+def read_level_music(seq_ids_h, levels_dir, seq_json):
+    # Maps each level folder in level_defines.h to the sequences.json names of the music its scripts set.
+    with open(seq_ids_h, "r") as f:
+        enum = re.search(r"enum\s+SeqId\s*{(.*?)}", strip_comments(f.read()), re.DOTALL)
+    validate(enum is not None, "no enum SeqId in " + seq_ids_h)
+    seq_ids = {}
+    for name in re.findall(r"\b(SEQ_\w+)", enum.group(1)):
+        if name != "SEQ_COUNT":
+            seq_ids[name] = len(seq_ids)
+
+    index_to_seq = {}
+    for key in seq_json:
+        index_to_seq[int(key.split("_")[0], 16)] = key
+
+    with open(os.path.join(levels_dir, "level_defines.h"), "r") as f:
+        level_defines = strip_comments(f.read())
+
+    level_music = OrderedDict()
+    for folder in re.findall(r"^\s*DEFINE_LEVEL\([^,]*,[^,]*,[^,]*,\s*(\w+)", level_defines, re.MULTILINE):
+        seqs = []
+        for root, dirs, files in sorted(os.walk(os.path.join(levels_dir, folder))):
+            for fname in sorted(files):
+                if not fname.endswith(".c"):
+                    continue
+                with open(os.path.join(root, fname), "r") as f:
+                    script = strip_comments(f.read())
+                for args in re.findall(r"SET_(?:BACKGROUND|MENU)_MUSIC\w*\s*\(([^)]*)\)", script):
+                    for name in re.findall(r"\b(SEQ_\w+)", args):
+                        # Sequence 0 is the sound player, whose banks every level gets anyway.
+                        if seq_ids.get(name, 0) != 0 and seq_ids[name] in index_to_seq:
+                            seq = index_to_seq[seq_ids[name]]
+                            if seq not in seqs:
+                                seqs.append(seq)
+        level_music[folder] = seqs
+    return level_music
+
+
+def write_residency_manifest(
+    out_filename, banks, tbl_offsets, seq_json_filename, seq_ids_h, levels_dir, defines
+):
+    bank_names = [bank.name for bank in banks]
+    with open(seq_json_filename, "r") as f:
+        seq_json = orderedJsonDecoder.decode(strip_comments(f.read()))
+    validate_and_normalize_sequence_json(seq_json, bank_names, defines)
+    name_to_bank = {bank.name: bank for bank in banks}
+
+    def bank_samples(bank_name):
+        bank = name_to_bank[bank_name]
+        samples = []
+        for inst in bank.json["instruments"].values():
+            sounds = [drum["sound"] for drum in inst] if isinstance(inst, list) else [
+                inst.get("sound_lo"), inst["sound"], inst.get("sound_hi")
+            ]
+            for sound in sounds:
+                if sound is not None and sound["sample"] is not None:
+                    samples.append(bank.sample_bank.name_to_entry[sound["sample"]])
+        offset = tbl_offsets[bank.sample_bank.index]
+        return [(offset + aifc.offset, aifc) for aifc in samples]
+
+    def samples_for(seqs):
+        # Looped samples first, as they are streamed for as long as a note plays, then the rest in bank order.
+        seen = set()
+        looped = []
+        unlooped = []
+        for seq in seqs:
+            for bank_name in seq_json.get(seq) or []:
+                for (offset, aifc) in bank_samples(bank_name):
+                    if offset in seen:
+                        continue
+                    seen.add(offset)
+                    if aifc.loop is not None and aifc.loop.count != 0:
+                        looped.append((offset, aifc))
+                    else:
+                        unlooped.append((offset, aifc))
+        return looped + unlooped
+
+    sfx_seqs = [seq for seq in seq_json if int(seq.split("_")[0], 16) == 0]
+    sfx_samples = samples_for(sfx_seqs)
+
+    with open(out_filename, "w") as f:
+        f.write("// Generated by tools/assemble_sound.py from the music each level's scripts set.\n")
+        f.write("// Samples to keep in RAM for each level, as offsets into sound_data.tbl, most useful first:\n")
+        f.write("// the music's samples, then the sound effects'.\n\n")
+        for folder, seqs in read_level_music(seq_ids_h, levels_dir, seq_json).items():
+            music_samples = [x for x in samples_for(seqs) if x not in sfx_samples]
+            f.write("// " + (", ".join(seqs) or "no music") + "\n")
+            f.write("static const struct SampleResidencyEntry sSampleResidency_" + folder + "[] = {\n")
+            for (offset, aifc) in music_samples + sfx_samples:
+                f.write("    {{ 0x{:08X}, 0x{:06X} }}, // {}\n".format(offset, len(aifc.data), aifc.name))
+            f.write("    { 0, 0 },\n};\n\n")
+
+
 def main():
     global STACK_TRACES
     global DUMP_INDIVIDUAL_BINS
@@ -888,6 +982,7 @@ def main():
     print_samples = False
     sequences_out_file = None
     sequences_header_out_file = None
+    residency_out_file = None
     defines = []
     args = []
     for i, a in enumerate(sys.argv[1:], 1):
@@ -937,6 +1032,12 @@ def main():
             sound_bank_dir = sys.argv[i + 4]
             sequence_json = sys.argv[i + 5]
             skip_next = 5
+        elif a == "--residency":
+            residency_out_file = sys.argv[i + 1]
+            residency_seq_json = sys.argv[i + 2]
+            residency_seq_ids_h = sys.argv[i + 3]
+            residency_levels_dir = sys.argv[i + 4]
+            skip_next = 4
         elif a.startswith("-"):
             print("Unrecognized option " + a)
             sys.exit(1)
@@ -967,6 +1068,7 @@ def main():
             " [--cpp <preprocessor>]"
             " [-D <symbol>]"
             " [--stack-trace]"
+            " [--residency <out manifest .inc.c> <sequences.json> <seq_ids.h> <levels dir>]"
             " | --sequences <out sequence .bin> <out Shindou sequence header .bin> "
             "<out bank sets .bin> <sound bank dir> <sequences.json> <inputs...>".format(
                 sys.argv[0]
@@ -1053,7 +1155,7 @@ def main():
         sample_bank.index = sample_bank_index
         sample_bank_index += 1
 
-    serialize_seqfile(
+    tbl_offsets = serialize_seqfile(
         tbl_data_out,
         tbl_data_header_out,
         sample_banks,
@@ -1083,6 +1185,21 @@ def main():
         is_shindou,
     )
 
+    if residency_out_file is not None:
+        validate(not is_shindou, "--residency is not supported for Shindou")
+        try:
+            write_residency_manifest(
+                residency_out_file,
+                banks,
+                tbl_offsets,
+                residency_seq_json,
+                residency_seq_ids_h,
+                residency_levels_dir,
+                defines_set,
+            )
+        except Exception as e:
+            fail("failed to write residency manifest " + residency_out_file + ": " + str(e))
+
     if print_samples:
         for sample_bank in sample_banks:
             for entry in sample_bank.entries:
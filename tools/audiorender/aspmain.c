@@ -0,0 +1,475 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <PR/ultratypes.h>
+#include <PR/abi.h>
+
+#include "aspmain.h"
+
+// Follows rsp/audio.s closely enough for listening and profiling, but the vector unit's rounding
+// isn't reproduced bit for bit.
+//
+// DMEM is laid out like the microcode's: the addresses in the commands are relative to DMEM_BASE,
+// and the ADPCM codebook lives in its own table. Data is kept in host byte order on both sides,
+// since everything the commands load was written by the host build of the audio driver or by
+// assemble_sound.py with --endian little.
+
+#define DMEM_SIZE 0x1000
+#define DMEM_BASE 0x5C0
+
+#define ROUND_UP_8(x) (((x) + 7) & ~7)
+#define ROUND_UP_16(x) (((x) + 15) & ~15)
+
+static u8 sDmem[DMEM_SIZE + 0x400]; // extra room for the last buffer running past the end
+static s16 sAdpcmTable[8][2][8];
+static u32 sSegments[16];
+
+static u16 sInBuf;
+static u16 sOutBuf;
+static u16 sCount;
+static u16 sAuxBuf[3]; // dry right, wet left and wet right for the envelope mixer
+static s16 sVol[2];
+static s16 sVolTarget[2];
+static s32 sVolRate[2];
+static s16 sDryGain;
+static s16 sWetGain;
+static s16 *sLoopState;
+
+// Data the resampler interpolates with, from the microcode's data section.
+static const s16 sResampleTable[64][4] = {
+	{   3129,  26285,   3398,    -33 },
+	{   2873,  26262,   3679,    -40 },
+	{   2628,  26217,   3971,    -48 },
+	{   2394,  26150,   4276,    -56 },
+	{   2173,  26061,   4592,    -65 },
+	{   1963,  25950,   4920,    -74 },
+	{   1764,  25817,   5260,    -84 },
+	{   1576,  25663,   5611,    -95 },
+	{   1399,  25487,   5974,   -106 },
+	{   1233,  25291,   6347,   -118 },
+	{   1077,  25075,   6732,   -130 },
+	{    932,  24838,   7127,   -143 },
+	{    796,  24583,   7532,   -156 },
+	{    671,  24309,   7947,   -170 },
+	{    554,  24016,   8371,   -184 },
+	{    446,  23706,   8804,   -198 },
+	{    347,  23379,   9246,   -212 },
+	{    257,  23036,   9696,   -226 },
+	{    174,  22678,  10153,   -240 },
+	{     99,  22304,  10618,   -254 },
+	{     31,  21917,  11088,   -268 },
+	{    -30,  21517,  11564,   -280 },
+	{    -84,  21104,  12045,   -293 },
+	{   -132,  20679,  12531,   -304 },
+	{   -173,  20244,  13020,   -314 },
+	{   -210,  19799,  13512,   -323 },
+	{   -241,  19345,  14006,   -330 },
+	{   -267,  18882,  14501,   -336 },
+	{   -289,  18413,  14997,   -340 },
+	{   -306,  17937,  15493,   -341 },
+	{   -320,  17456,  15988,   -340 },
+	{   -330,  16970,  16480,   -337 },
+	{   -337,  16480,  16970,   -330 },
+	{   -340,  15988,  17456,   -320 },
+	{   -341,  15493,  17937,   -306 },
+	{   -340,  14997,  18413,   -289 },
+	{   -336,  14501,  18882,   -267 },
+	{   -330,  14006,  19345,   -241 },
+	{   -323,  13512,  19799,   -210 },
+	{   -314,  13020,  20244,   -173 },
+	{   -304,  12531,  20679,   -132 },
+	{   -293,  12045,  21104,    -84 },
+	{   -280,  11564,  21517,    -30 },
+	{   -268,  11088,  21917,     31 },
+	{   -254,  10618,  22304,     99 },
+	{   -240,  10153,  22678,    174 },
+	{   -226,   9696,  23036,    257 },
+	{   -212,   9246,  23379,    347 },
+	{   -198,   8804,  23706,    446 },
+	{   -184,   8371,  24016,    554 },
+	{   -170,   7947,  24309,    671 },
+	{   -156,   7532,  24583,    796 },
+	{   -143,   7127,  24838,    932 },
+	{   -130,   6732,  25075,   1077 },
+	{   -118,   6347,  25291,   1233 },
+	{   -106,   5974,  25487,   1399 },
+	{    -95,   5611,  25663,   1576 },
+	{    -84,   5260,  25817,   1764 },
+	{    -74,   4920,  25950,   1963 },
+	{    -65,   4592,  26061,   2173 },
+	{    -56,   4276,  26150,   2394 },
+	{    -48,   3971,  26217,   2628 },
+	{    -40,   3679,  26262,   2873 },
+	{    -33,   3398,  26285,   3129 },
+};
+
+static s16 clamp16(s32 x)
+{
+	if (x < -0x8000)
+		return -0x8000;
+	if (x > 0x7FFF)
+		return 0x7FFF;
+	return x;
+}
+
+static s32 clamp32(s64 x)
+{
+	if (x < -0x7FFFFFFFLL - 1)
+		return -0x7FFFFFFF - 1;
+	if (x > 0x7FFFFFFF)
+		return 0x7FFFFFFF;
+	return x;
+}
+
+static u8 *dmem(u32 addr)
+{
+	return &sDmem[(DMEM_BASE + addr) & (DMEM_SIZE - 1)];
+}
+
+static s16 *dmem16(u32 addr)
+{
+	return (s16 *) dmem(addr & ~1);
+}
+
+// On the RSP the top byte of an address picks a segment. The audio driver only sets segment 0 to 0,
+// and host pointers use all 32 bits, so an address is only split up if its segment has a base.
+static void *dram(u32 addr)
+{
+	u32 base = sSegments[(addr >> 24) & 0xF];
+
+	if (base != 0)
+		addr = base + (addr & 0xFFFFFF);
+	return (void *) (uintptr_t) addr;
+}
+
+// DMA transfers ignore the low three bits of both addresses and round the length up to 8 bytes.
+static void *dram_dma(u32 addr)
+{
+	return (void *) ((uintptr_t) dram(addr) & ~(uintptr_t) 7);
+}
+
+static void cmd_adpcm(u8 flags, s16 *state)
+{
+	u8 *in = dmem(sInBuf);
+	s16 *out = dmem16(sOutBuf);
+	s32 count = sCount;
+
+	if (flags & A_INIT)
+		memset(out, 0, 16 * sizeof(s16));
+	else if (flags & A_LOOP)
+		memcpy(out, sLoopState, 16 * sizeof(s16));
+	else
+		memcpy(out, state, 16 * sizeof(s16));
+	out += 16;
+
+	// Every 9 byte frame holds 16 samples, predicted two groups of 8 at a time.
+	while (count > 0)
+	{
+		s32 shift = *in >> 4;
+		s16 (*book)[8] = sAdpcmTable[*in & 7];
+
+		in++;
+		if (shift > 12)
+			shift = 12;
+		for (s32 half = 0; half < 2; half++)
+		{
+			s32 residuals[8];
+			s32 prev2 = out[-2];
+			s32 prev1 = out[-1];
+
+			for (s32 i = 0; i < 4; i++, in++)
+			{
+				residuals[i * 2] = ((s8) (*in & 0xF0) >> 4) * (1 << shift);
+				residuals[i * 2 + 1] = ((s8) (*in << 4) >> 4) * (1 << shift);
+			}
+			for (s32 i = 0; i < 8; i++)
+			{
+				s32 acc = book[0][i] * prev2 + book[1][i] * prev1 + residuals[i] * (1 << 11);
+
+				for (s32 j = 0; j < i; j++)
+					acc += book[1][i - j - 1] * residuals[j];
+				out[i] = clamp16(acc >> 11);
+			}
+			out += 8;
+		}
+		count -= 32;
+	}
+	memcpy(state, out - 16, 16 * sizeof(s16));
+}
+
+static void cmd_resample(u8 flags, u16 pitch, s16 *state)
+{
+	s16 *inStart = dmem16(sInBuf);
+	s16 *in = inStart;
+	s16 *out = dmem16(sOutBuf);
+	s32 count = ROUND_UP_16(sCount);
+	s16 saved[16];
+	u32 pitchAcc;
+	s32 remainder;
+
+	if (flags & A_INIT)
+		memset(saved, 0, sizeof(saved));
+	else
+		memcpy(saved, state, sizeof(saved));
+
+	// With bit 1 set, the input continues from samples the last call couldn't finish.
+	if (flags & 2)
+	{
+		memcpy(in - 8, &saved[8], 8 * sizeof(s16));
+		in -= saved[5] / (s32) sizeof(s16);
+	}
+	in -= 4;
+	memcpy(in, saved, 4 * sizeof(s16));
+	pitchAcc = (u16) saved[4];
+
+	do
+	{
+		for (s32 i = 0; i < 8; i++)
+		{
+			const s16 *filter = sResampleTable[pitchAcc >> 10];
+			s32 acc = in[0] * filter[0] + in[1] * filter[1] + in[2] * filter[2] + in[3] * filter[3];
+
+			*out++ = clamp16((acc + 0x4000) >> 15);
+			pitchAcc += pitch << 1;
+			in += pitchAcc >> 16;
+			pitchAcc &= 0xFFFF;
+		}
+		count -= 16;
+	} while (count > 0);
+
+	state[4] = pitchAcc;
+	memcpy(state, in, 4 * sizeof(s16));
+	remainder = (in - inStart + 4) & 7;
+	in -= remainder;
+	if (remainder != 0)
+		remainder = -8 - remainder;
+	state[5] = remainder;
+	memcpy(&state[8], in, 8 * sizeof(s16));
+}
+
+static void cmd_envmixer(u8 flags, s16 *state)
+{
+	s16 *in = dmem16(sInBuf);
+	s16 *dry[2] = { dmem16(sOutBuf), dmem16(sAuxBuf[0]) };
+	s16 *wet[2] = { dmem16(sAuxBuf[1]), dmem16(sAuxBuf[2]) };
+	s32 count = ROUND_UP_16(sCount);
+	s32 vols[2][8];
+	s16 target[2];
+	s32 rate[2];
+	s16 dryGain, wetGain;
+
+	// The state keeps a volume for every lane, so the ramp carries on smoothly across calls.
+	if (flags & A_INIT)
+	{
+		for (s32 c = 0; c < 2; c++)
+		{
+			s32 step = sVol[c] * (s64) (sVolRate[c] - 0x10000) / 8;
+
+			target[c] = sVolTarget[c];
+			rate[c] = sVolRate[c];
+			for (s32 i = 0; i < 8; i++)
+				vols[c][i] = clamp32(((s64) sVol[c] << 16) + (s64) step * (i + 1));
+		}
+		dryGain = sDryGain;
+		wetGain = sWetGain;
+	}
+	else
+	{
+		memcpy(vols, state, sizeof(vols));
+		target[0] = state[32];
+		rate[0] = (s32) (((u32) (u16) state[33] << 16) | (u16) state[34]);
+		target[1] = state[35];
+		rate[1] = (s32) (((u32) (u16) state[36] << 16) | (u16) state[37]);
+		dryGain = state[38];
+		wetGain = state[39];
+	}
+
+	do
+	{
+		for (s32 c = 0; c < 2; c++)
+		{
+			for (s32 i = 0; i < 8; i++)
+			{
+				s32 vol;
+
+				if ((rate[c] >> 16) > 0)
+				{
+					if ((vols[c][i] >> 16) > target[c])
+						vols[c][i] = target[c] << 16;
+				}
+				else if ((vols[c][i] >> 16) < target[c])
+				{
+					vols[c][i] = target[c] << 16;
+				}
+
+				vol = vols[c][i] >> 16;
+				dry[c][i] = clamp16((dry[c][i] * 0x7FFF + in[i] * ((vol * dryGain + 0x4000) >> 15) + 0x4000) >> 15);
+				if (flags & A_AUX)
+					wet[c][i] = clamp16((wet[c][i] * 0x7FFF + in[i] * ((vol * wetGain + 0x4000) >> 15) + 0x4000) >> 15);
+				vols[c][i] = clamp32((s64) vols[c][i] * rate[c] >> 16);
+			}
+			dry[c] += 8;
+			if (flags & A_AUX)
+				wet[c] += 8;
+		}
+		in += 8;
+		count -= 16;
+	} while (count > 0);
+
+	memcpy(state, vols, sizeof(vols));
+	state[32] = target[0];
+	state[33] = rate[0] >> 16;
+	state[34] = rate[0];
+	state[35] = target[1];
+	state[36] = rate[1] >> 16;
+	state[37] = rate[1];
+	state[38] = dryGain;
+	state[39] = wetGain;
+}
+
+static void cmd_mixer(s16 gain, u16 inAddr, u16 outAddr)
+{
+	s16 *in = dmem16(inAddr);
+	s16 *out = dmem16(outAddr);
+
+	// Unlike the other commands, this one works through 16 samples at a time.
+	for (s32 count = sCount; count > 0; count -= 32)
+	{
+		for (s32 i = 0; i < 16; i++, in++, out++)
+			*out = clamp16((*out * 0x7FFF + *in * gain + 0x4000) >> 15);
+	}
+}
+
+static void cmd_interleave(u16 left, u16 right)
+{
+	s16 *l = dmem16(left);
+	s16 *r = dmem16(right);
+	s16 *out = dmem16(sOutBuf);
+
+	for (s32 count = sCount; count > 0; count -= 16)
+	{
+		for (s32 i = 0; i < 8; i++)
+		{
+			*out++ = *l++;
+			*out++ = *r++;
+		}
+	}
+}
+
+static void cmd_dmemmove(u16 inAddr, u16 outAddr, u16 count)
+{
+	u8 *in = dmem(inAddr);
+	u8 *out = dmem(outAddr);
+
+	// Copied 16 bytes at a time, which matters when the buffers overlap.
+	for (s32 remaining = count; remaining > 0; remaining -= 16, in += 16, out += 16)
+	{
+		u8 chunk[16];
+
+		memcpy(chunk, in, 16);
+		memcpy(out, chunk, 16);
+	}
+}
+
+void aspmain_reset(void)
+{
+	memset(sDmem, 0, sizeof(sDmem));
+	memset(sAdpcmTable, 0, sizeof(sAdpcmTable));
+	memset(sSegments, 0, sizeof(sSegments));
+	sLoopState = NULL;
+}
+
+void aspmain_run(const u64 *cmds, s32 count)
+{
+	const Acmd *cmd = (const Acmd *) cmds;
+
+	// The segment table is cleared at the start of every task.
+	memset(sSegments, 0, sizeof(sSegments));
+
+	for (; count > 0; count--, cmd++)
+	{
+		u32 w0 = cmd->words.w0;
+		u32 w1 = cmd->words.w1;
+		u8 flags = w0 >> 16;
+
+		switch (w0 >> 24)
+		{
+		case A_SPNOOP:
+		case A_POLEF: // not used by the game
+			break;
+		case A_ADPCM:
+			cmd_adpcm(flags, dram(w1));
+			break;
+		case A_CLEARBUFF:
+			memset(dmem(w0 & 0xFFFF), 0, ROUND_UP_16(w1 & 0xFFFF));
+			break;
+		case A_ENVMIXER:
+			cmd_envmixer(flags, dram(w1));
+			break;
+		case A_LOADBUFF:
+			if (sCount != 0)
+				memcpy(dmem(sInBuf & ~7), dram_dma(w1), ROUND_UP_8(sCount));
+			break;
+		case A_RESAMPLE:
+			cmd_resample(flags, w0 & 0xFFFF, dram(w1));
+			break;
+		case A_SAVEBUFF:
+			if (sCount != 0)
+				memcpy(dram_dma(w1), dmem(sOutBuf & ~7), ROUND_UP_8(sCount));
+			break;
+		case A_SEGMENT:
+			sSegments[(w1 >> 24) & 0xF] = w1 & 0xFFFFFF;
+			break;
+		case A_SETBUFF:
+			if (flags & A_AUX)
+			{
+				sAuxBuf[0] = w0;
+				sAuxBuf[1] = w1 >> 16;
+				sAuxBuf[2] = w1;
+			}
+			else
+			{
+				sInBuf = w0;
+				sOutBuf = w1 >> 16;
+				sCount = w1;
+			}
+			break;
+		case A_SETVOL:
+			if (flags & A_AUX)
+			{
+				sDryGain = w0;
+				sWetGain = w1;
+			}
+			else if (flags & A_VOL)
+			{
+				sVol[(flags & A_LEFT) ? 0 : 1] = w0;
+			}
+			else
+			{
+				sVolTarget[(flags & A_LEFT) ? 0 : 1] = w0;
+				sVolRate[(flags & A_LEFT) ? 0 : 1] = w1;
+			}
+			break;
+		case A_DMEMMOVE:
+			cmd_dmemmove(w0, w1 >> 16, w1);
+			break;
+		case A_LOADADPCM:
+			memcpy(sAdpcmTable, dram_dma(w1), ROUND_UP_8(w0 & 0xFFFF) < sizeof(sAdpcmTable)
+			       ? ROUND_UP_8(w0 & 0xFFFF) : sizeof(sAdpcmTable));
+			break;
+		case A_MIXER:
+			cmd_mixer(w0, w1 >> 16, w1);
+			break;
+		case A_INTERLEAVE:
+			cmd_interleave(w1 >> 16, w1);
+			break;
+		case A_SETLOOP:
+			sLoopState = dram(w1);
+			break;
+		default:
+			fprintf(stderr, "aspmain: unknown command %02X (%08X %08X)\n", w0 >> 24, w0, w1);
+			abort();
+		}
+	}
+}
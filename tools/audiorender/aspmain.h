@@ -0,0 +1,12 @@
+#ifndef ASPMAIN_H
+#define ASPMAIN_H
+
+#include <PR/ultratypes.h>
+
+// Software version of the audio microcode (rsp/audio.s, the US/JP command set), for running the
+// command lists synthesis.c generates on the host.
+
+void aspmain_reset(void);
+void aspmain_run(const u64 *cmds, s32 count);
+
+#endif // ASPMAIN_H
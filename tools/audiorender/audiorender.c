@@ -0,0 +1,401 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ultra64.h>
+
+#include "audio/data.h"
+#include "audio/external.h"
+#include "audio/internal.h"
+#include "audio/load.h"
+#include "audio/seqplayer.h"
+#include "audio/synthesis.h"
+#include "aspmain.h"
+#include "host_os.h"
+#include "level_table.h"
+
+// Offline renderer for the audio driver
+//
+// Runs the game's own sequence player and synthesis code (src/audio) on the host, executes the
+// command lists they generate with a software version of the audio microcode, and writes the
+// result to a WAV file. The sound data comes from assemble_sound.py built for the host
+// (--endian little --bitwidth 64), which `make audiorender` puts in AUDIORENDER_DATA_DIR.
+//
+// Every frame is timed in three parts: process_sequences, the rest of synthesis_execute (building
+// the command list), and running the command list. The first two are CPU work on the console; the
+// last stands in for the RSP, so it only shows how the work is spread between frames.
+//
+// The sequence is its number in hex, or its name from sound/sequences.json, which starts with the
+// number. It plays on the background music player until it ends, or for at most -s seconds.
+//
+// Bytes read from the cartridge while playing are reported per second of audio. With -l, the
+// samples assemble_sound.py lists for that level (its folder name) are loaded first, as
+// sound_reset does in game with SAMPLE_RESIDENCY_POOL_SIZE set, and the sequence is played once
+// without them for comparison, to show how much PI bandwidth keeping them in RAM saves.
+//
+//   audiorender [-s seconds] [-o out.wav] [-c frames.csv] [-d data dir] [-l level] [-v] sequence
+//     -c  write the timings of every frame as CSV
+//     -v  print the audio driver's debug output
+
+#ifndef AUDIORENDER_DATA_DIR
+#define AUDIORENDER_DATA_DIR "."
+#endif
+
+// How the game sizes each frame's buffer, see create_next_audio_frame_task.
+#define SAMPLES_TO_OVERPRODUCE 0x10
+#define EXTRA_BUFFERED_AI_SAMPLES_TARGET 0x40
+
+// Frames to keep rendering after the sequence ends, so released notes can fade out.
+#define TAIL_FRAMES 60
+
+typedef struct
+{
+	double total;
+	double max;
+} Timing;
+
+typedef struct
+{
+	Timing sequences, commands, abi;
+	u32 maxCmds, totalCmds, totalSamples;
+	u64 piBytes;
+	s32 frames;
+} RenderStats;
+
+#ifdef SAMPLE_RESIDENCY_POOL_SIZE
+#define STUB_LEVEL(_0, _1, _2, _3, _4, _5, _6, _7, _8) NULL,
+#define DEFINE_LEVEL(_0, _1, _2, folder, _4, _5, _6, _7, _8, _9, _10) #folder,
+
+static const char *sLevelNames[LEVEL_COUNT] = { NULL, // LEVEL_NONE
+#include "levels/level_defines.h"
+};
+
+#undef STUB_LEVEL
+#undef DEFINE_LEVEL
+#endif
+
+extern u16 gSequenceCount;
+
+static u64 sSequenceTime;
+
+static u64 now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// synthesis.c is built with its process_sequences call renamed to this, so that the time spent
+// running the sequences can be told apart from the time spent generating commands.
+void timed_process_sequences(s32 iterationsRemaining)
+{
+	u64 start = now_ns();
+
+	process_sequences(iterationsRemaining);
+	sSequenceTime += now_ns() - start;
+}
+
+static void add_timing(Timing *timing, double us)
+{
+	timing->total += us;
+	if (us > timing->max)
+		timing->max = us;
+}
+
+static int load_file(const char *dir, const char *name, u8 *buffer, size_t size)
+{
+	char path[1024];
+	FILE *f;
+	size_t length;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	f = fopen(path, "rb");
+	if (f == NULL)
+	{
+		fprintf(stderr, "%s: can't open\n", path);
+		return 0;
+	}
+	length = fread(buffer, 1, size, f);
+	if (length == size && fgetc(f) != EOF)
+	{
+		fprintf(stderr, "%s: more than %zu bytes\n", path, size);
+		fclose(f);
+		return 0;
+	}
+	fclose(f);
+	return 1;
+}
+
+static void write_u16(FILE *f, u32 value)
+{
+	fputc(value & 0xFF, f);
+	fputc((value >> 8) & 0xFF, f);
+}
+
+static void write_u32(FILE *f, u32 value)
+{
+	write_u16(f, value & 0xFFFF);
+	write_u16(f, value >> 16);
+}
+
+static void write_wav_header(FILE *f, u32 frequency, u32 frames)
+{
+	fwrite("RIFF", 1, 4, f);
+	write_u32(f, 36 + frames * 4);
+	fwrite("WAVEfmt ", 1, 8, f);
+	write_u32(f, 16);
+	write_u16(f, 1); // PCM
+	write_u16(f, 2);
+	write_u32(f, frequency);
+	write_u32(f, frequency * 4);
+	write_u16(f, 4);
+	write_u16(f, 16);
+	fwrite("data", 1, 4, f);
+	write_u32(f, frames * 4);
+}
+
+// Picks the length of the next buffer the way the game does, against a simulated AI that plays
+// exactly one frame's worth of samples between frames, so the output comes out at gAiFrequency.
+static s32 next_buffer_length(double *aiQueued)
+{
+	s32 length;
+
+	*aiQueued -= gAiFrequency / 60.0;
+	if (*aiQueued < 0)
+		*aiQueued = 0;
+
+	length = ((gSamplesPerFrameTarget - (s32) *aiQueued + EXTRA_BUFFERED_AI_SAMPLES_TARGET) & ~0xF)
+	         + SAMPLES_TO_OVERPRODUCE;
+	if (length < gMinAiBufferLength)
+		length = gMinAiBufferLength;
+	if (length > gSamplesPerFrameTarget + SAMPLES_TO_OVERPRODUCE)
+		length = gSamplesPerFrameTarget + SAMPLES_TO_OVERPRODUCE;
+
+	*aiQueued += length;
+	return length;
+}
+
+// Starts the driver from scratch, as at boot, and the sequence on the background music player, with
+// the samples of a level resident if there is one.
+static int start_audio(u32 seqId, s32 levelNum)
+{
+	aspmain_reset();
+	sAudioIsInitialized = FALSE;
+	audio_init();
+	if (seqId >= gSequenceCount)
+	{
+		fprintf(stderr, "sequence %02X doesn't exist, there are %d\n", seqId, gSequenceCount);
+		return 0;
+	}
+#ifdef SAMPLE_RESIDENCY_POOL_SIZE
+	if (levelNum != LEVEL_NONE)
+		preload_level_samples(levelNum);
+#else
+	(void) levelNum;
+#endif
+	load_sequence(SEQ_PLAYER_LEVEL, seqId, FALSE);
+	if (!gSequencePlayers[SEQ_PLAYER_LEVEL].enabled)
+	{
+		fprintf(stderr, "sequence %02X couldn't be loaded\n", seqId);
+		return 0;
+	}
+	return 1;
+}
+
+// Plays the started sequence until it ends or for maxFrames, writing the samples to out and the
+// timings of each frame to csv if they aren't NULL.
+static void render(s32 maxFrames, FILE *out, FILE *csv, RenderStats *stats)
+{
+	double aiQueued = 0;
+	s32 tail = TAIL_FRAMES;
+
+	memset(stats, 0, sizeof(*stats));
+	gHostOsPiBytesRead = 0;
+	for (stats->frames = 0; stats->frames < maxFrames && tail > 0; stats->frames++)
+	{
+		s32 frame = stats->frames;
+		u64 *cmdBuf = gAudioCmdBuffers[frame & 1];
+		s16 *aiBuf = gAiBuffers[frame % NUMAIBUFFERS];
+		s32 length = next_buffer_length(&aiQueued);
+		s32 writtenCmds;
+		u64 start, generated, executed;
+		double sequenceUs, commandUs, abiUs;
+
+		gAudioFrameCount++;
+		gCurrAudioFrameDmaCount = 0;
+		sSequenceTime = 0;
+
+		start = now_ns();
+		synthesis_execute(cmdBuf, &writtenCmds, aiBuf, length);
+		generated = now_ns();
+		aspmain_run(cmdBuf, writtenCmds);
+		executed = now_ns();
+
+		gAudioRandom = (gAudioRandom + gAudioFrameCount) * gAudioFrameCount;
+		decrease_sample_dma_ttls();
+
+		if (out != NULL)
+		{
+			for (s32 i = 0; i < length * 2; i++)
+				write_u16(out, (u16) aiBuf[i]);
+		}
+		stats->totalSamples += length;
+
+		sequenceUs = sSequenceTime / 1000.0;
+		commandUs = (generated - start - sSequenceTime) / 1000.0;
+		abiUs = (executed - generated) / 1000.0;
+		add_timing(&stats->sequences, sequenceUs);
+		add_timing(&stats->commands, commandUs);
+		add_timing(&stats->abi, abiUs);
+		stats->totalCmds += writtenCmds;
+		if ((u32) writtenCmds > stats->maxCmds)
+			stats->maxCmds = writtenCmds;
+		if (csv != NULL)
+			fprintf(csv, "%d,%d,%d,%.1f,%.1f,%.1f\n", frame, length, writtenCmds, sequenceUs, commandUs, abiUs);
+
+		if (!gSequencePlayers[SEQ_PLAYER_LEVEL].enabled)
+			tail--;
+	}
+	stats->piBytes = gHostOsPiBytesRead;
+}
+
+static double pi_bytes_per_second(const RenderStats *stats)
+{
+	return stats->piBytes / ((double) stats->totalSamples / gAiFrequency);
+}
+
+int main(int argc, char **argv)
+{
+	const char *dataDir = AUDIORENDER_DATA_DIR;
+	const char *outPath = "out.wav";
+	const char *csvPath = NULL;
+	const char *levelName = NULL;
+	double seconds = 120;
+	FILE *out, *csv = NULL;
+	RenderStats stats, streamed;
+	s32 levelNum = LEVEL_NONE;
+	u32 seqId;
+	char *end;
+	int arg = 1;
+
+	for (; arg < argc && argv[arg][0] == '-'; arg++)
+	{
+		if (strcmp(argv[arg], "-s") == 0 && arg + 1 < argc)
+			seconds = atof(argv[++arg]);
+		else if (strcmp(argv[arg], "-o") == 0 && arg + 1 < argc)
+			outPath = argv[++arg];
+		else if (strcmp(argv[arg], "-c") == 0 && arg + 1 < argc)
+			csvPath = argv[++arg];
+		else if (strcmp(argv[arg], "-d") == 0 && arg + 1 < argc)
+			dataDir = argv[++arg];
+		else if (strcmp(argv[arg], "-l") == 0 && arg + 1 < argc)
+			levelName = argv[++arg];
+		else if (strcmp(argv[arg], "-v") == 0)
+			gHostOsVerbose = TRUE;
+		else
+			break;
+	}
+
+	if (arg + 1 != argc || seconds <= 0)
+	{
+		fprintf(stderr, "audiorender [-s seconds] [-o out.wav] [-c frames.csv] [-d data dir] [-l level] [-v] sequence\n");
+		return 1;
+	}
+
+	seqId = strtoul(argv[arg], &end, 16);
+	if (end == argv[arg])
+	{
+		fprintf(stderr, "%s: not a sequence number or name\n", argv[arg]);
+		return 1;
+	}
+
+	if (levelName != NULL)
+	{
+#ifdef SAMPLE_RESIDENCY_POOL_SIZE
+		for (levelNum = LEVEL_MIN; levelNum < LEVEL_COUNT; levelNum++)
+		{
+			if (sLevelNames[levelNum] != NULL && strcmp(sLevelNames[levelNum], levelName) == 0)
+				break;
+		}
+		if (levelNum == LEVEL_COUNT)
+		{
+			fprintf(stderr, "%s: not a level folder in levels/level_defines.h\n", levelName);
+			return 1;
+		}
+#else
+		fprintf(stderr, "-l needs a build with the SAMPLE_RESIDENCY_POOL_SIZE Makefile option set\n");
+		return 1;
+#endif
+	}
+
+	if (!host_os_check_addresses())
+	{
+		fprintf(stderr, "the audio buffers aren't in the low 4 GB, build without -pie\n");
+		return 1;
+	}
+	if (!load_file(dataDir, "sound_data.ctl", gSoundDataADSR, sizeof(gSoundDataADSR))
+	    || !load_file(dataDir, "sound_data.tbl", gSoundDataRaw, sizeof(gSoundDataRaw))
+	    || !load_file(dataDir, "sequences.bin", gMusicData, sizeof(gMusicData))
+	    || !load_file(dataDir, "bank_sets", gBankSetsData, sizeof(gBankSetsData)))
+	{
+		return 1;
+	}
+
+	// The pass that streams every sample is only for comparison, so it isn't written out.
+	if (levelNum != LEVEL_NONE)
+	{
+		if (!start_audio(seqId, LEVEL_NONE))
+			return 1;
+		render((s32) (seconds * 60), NULL, NULL, &streamed);
+	}
+	if (!start_audio(seqId, levelNum))
+		return 1;
+
+	out = fopen(outPath, "wb");
+	if (out == NULL)
+	{
+		fprintf(stderr, "%s: can't create\n", outPath);
+		return 1;
+	}
+	write_wav_header(out, gAiFrequency, 0);
+	if (csvPath != NULL)
+	{
+		csv = fopen(csvPath, "w");
+		if (csv == NULL)
+		{
+			fprintf(stderr, "%s: can't create\n", csvPath);
+			return 1;
+		}
+		fprintf(csv, "frame,samples,commands,sequences_us,commands_us,abi_us\n");
+	}
+
+	render((s32) (seconds * 60), out, csv, &stats);
+
+	fseek(out, 0, SEEK_SET);
+	write_wav_header(out, gAiFrequency, stats.totalSamples);
+	fclose(out);
+	if (csv != NULL)
+		fclose(csv);
+
+	printf("sequence %02X: %d frames, %.1f s at %d Hz, written to %s\n", seqId, stats.frames,
+	       (double) stats.totalSamples / gAiFrequency, gAiFrequency, outPath);
+	printf("%-20s %10s %10s\n", "per frame", "avg us", "max us");
+	printf("%-20s %10.1f %10.1f\n", "process_sequences", stats.sequences.total / stats.frames, stats.sequences.max);
+	printf("%-20s %10.1f %10.1f\n", "command generation", stats.commands.total / stats.frames, stats.commands.max);
+	printf("%-20s %10.1f %10.1f\n", "ABI execution", stats.abi.total / stats.frames, stats.abi.max);
+	printf("%-20s %10.1f %10u\n", "commands", (double) stats.totalCmds / stats.frames, stats.maxCmds);
+	if (levelNum == LEVEL_NONE)
+	{
+		printf("PI reads: %.0f bytes/s\n", pi_bytes_per_second(&stats));
+	}
+	else
+	{
+		printf("PI reads: %.0f bytes/s streaming every sample, %.0f bytes/s with %s's samples resident, "
+		       "%.0f bytes/s saved\n",
+		       pi_bytes_per_second(&streamed), pi_bytes_per_second(&stats), levelName,
+		       pi_bytes_per_second(&streamed) - pi_bytes_per_second(&stats));
+	}
+	return 0;
+}
@@ -0,0 +1,151 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ultra64.h>
+#include <PR/libaudio.h>
+
+#include "types.h"
+#include "audio/data.h"
+#include "game/emutest.h"
+#include "host_os.h"
+
+// Stand-ins for the libultra calls and game globals the audio driver uses, for running it on the
+// host without threads. The "cartridge" is host memory: DMAs are plain copies that complete before
+// osPiStartDma returns.
+
+#define OS_VI_CLOCK_NTSC 48681812
+
+ALIGNED16 u8 gAudioHeap[DOUBLE_SIZE_ON_64_BIT(AUDIO_HEAP_SIZE)];
+s32 gAudioErrorFlags;
+struct Config gConfig = { .audioFrequency = 1.0f };
+enum Emulator gEmulator = EMU_CONSOLE;
+
+// assemble_sound.py output, loaded by audiorender.c.
+ALIGNED16 u8 gSoundDataADSR[SOUND_CTL_MAX_SIZE];
+ALIGNED16 u8 gSoundDataRaw[SOUND_TBL_MAX_SIZE];
+ALIGNED16 u8 gMusicData[SOUND_SEQUENCES_MAX_SIZE];
+ALIGNED16 u8 gBankSetsData[SOUND_BANK_SETS_MAX_SIZE];
+
+s32 gHostOsVerbose = FALSE;
+
+// Bytes read from the cartridge, which is the PI bandwidth the driver would use on console.
+u64 gHostOsPiBytesRead = 0;
+
+void osCreateMesgQueue(OSMesgQueue *mq, OSMesg *msg, s32 count)
+{
+	mq->mtqueue = NULL;
+	mq->fullqueue = NULL;
+	mq->validCount = 0;
+	mq->first = 0;
+	mq->msgCount = count;
+	mq->msg = msg;
+}
+
+s32 osSendMesg(OSMesgQueue *mq, OSMesg msg, s32 flag)
+{
+	(void) flag;
+	if (mq->validCount >= mq->msgCount)
+		return -1;
+	mq->msg[(mq->first + mq->validCount) % mq->msgCount] = msg;
+	mq->validCount++;
+	return 0;
+}
+
+s32 osRecvMesg(OSMesgQueue *mq, OSMesg *msg, s32 flag)
+{
+	if (mq->validCount == 0)
+	{
+		// Nothing else runs, so a blocking wait would never end.
+		if (flag == OS_MESG_BLOCK)
+		{
+			fprintf(stderr, "osRecvMesg: blocking on an empty queue\n");
+			exit(1);
+		}
+		return -1;
+	}
+	if (msg != NULL)
+		*msg = mq->msg[mq->first];
+	mq->first = (mq->first + 1) % mq->msgCount;
+	mq->validCount--;
+	return 0;
+}
+
+s32 osPiStartDma(OSIoMesg *mb, s32 priority, s32 direction, u32 devAddr, void *vAddr, u32 nbytes, OSMesgQueue *mq)
+{
+	(void) priority;
+	if (direction == OS_READ)
+	{
+		memcpy(vAddr, (void *) (uintptr_t) devAddr, nbytes);
+		gHostOsPiBytesRead += nbytes;
+	}
+	else
+		memcpy((void *) (uintptr_t) devAddr, vAddr, nbytes);
+	mb->dramAddr = vAddr;
+	mb->devAddr = devAddr;
+	mb->size = nbytes;
+	// Like the PI manager, drop the message if nobody is reading the queue.
+	osSendMesg(mq, (OSMesg) mb, OS_MESG_NOBLOCK);
+	return 0;
+}
+
+void osInvalDCache(void *vaddr, s32 nbytes)
+{
+	(void) vaddr;
+	(void) nbytes;
+}
+
+void osWritebackDCache(void *vaddr, s32 nbytes)
+{
+	(void) vaddr;
+	(void) nbytes;
+}
+
+void osWritebackDCacheAll(void)
+{
+}
+
+s32 osAiSetFrequency(u32 frequency)
+{
+	u32 dacRate = (u32) ((f32) OS_VI_CLOCK_NTSC / frequency + 0.5f);
+
+	return OS_VI_CLOCK_NTSC / (s32) dacRate;
+}
+
+void osSyncPrintf(const char *fmt, ...)
+{
+	va_list args;
+
+	if (!gHostOsVerbose)
+		return;
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+}
+
+void alSeqFileNew(ALSeqFile *f, u8 *base)
+{
+	for (s32 i = 0; i < f->seqCount; i++)
+		f->seqArray[i].offset = base + (uintptr_t) f->seqArray[i].offset;
+}
+
+// Commands hold 32-bit addresses, so everything they can point at has to be in the low 4 GB.
+// Being static keeps it there as long as the binary isn't position independent.
+s32 host_os_check_addresses(void)
+{
+	const u8 *ends[] = {
+		gAudioHeap + sizeof(gAudioHeap),
+		gSoundDataADSR + sizeof(gSoundDataADSR),
+		gSoundDataRaw + sizeof(gSoundDataRaw),
+		gMusicData + sizeof(gMusicData),
+		gBankSetsData + sizeof(gBankSetsData),
+	};
+
+	for (u32 i = 0; i < ARRAY_COUNT(ends); i++)
+	{
+		if ((uintptr_t) ends[i] > 0xFFFFFFFFu)
+			return FALSE;
+	}
+	return TRUE;
+}
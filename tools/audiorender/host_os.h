@@ -0,0 +1,21 @@
+#ifndef HOST_OS_H
+#define HOST_OS_H
+
+#include <PR/ultratypes.h>
+
+#define SOUND_CTL_MAX_SIZE       0x400000
+#define SOUND_TBL_MAX_SIZE       0x1000000
+#define SOUND_SEQUENCES_MAX_SIZE 0x400000
+#define SOUND_BANK_SETS_MAX_SIZE 0x10000
+
+extern u8 gSoundDataADSR[SOUND_CTL_MAX_SIZE];
+extern u8 gSoundDataRaw[SOUND_TBL_MAX_SIZE];
+extern u8 gMusicData[SOUND_SEQUENCES_MAX_SIZE];
+extern u8 gBankSetsData[SOUND_BANK_SETS_MAX_SIZE];
+
+extern s32 gHostOsVerbose;
+extern u64 gHostOsPiBytesRead;
+
+s32 host_os_check_addresses(void);
+
+#endif // HOST_OS_H
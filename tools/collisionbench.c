@@ -0,0 +1,1011 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include <ultra64.h>
+
+#include "sm64.h"
+#include "engine/math_util.h"
+#include "engine/surface_collision.h"
+#include "engine/surface_load.h"
+#include "game/area.h"
+#include "game/camera.h"
+#include "game/object_list_processor.h"
+#include "game/puppyprint.h"
+#include "special_presets.h"
+
+// Host benchmark for the static collision lookups in src/engine/surface_load.c and surface_collision.c
+//
+// Each level area's collision is loaded with load_area_terrain, then a set of query positions is
+// replayed against it with find_floor, find_ceil and find_wall_collisions, the way Mario checks
+// his surroundings every frame. The positions are read from a file of "x y z" lines when one is
+// given (e.g. logged from the game), otherwise they are random points just above the level's floors.
+// For each kind of query it reports the surface nodes visited per query, from the same counter the
+// puppyprint profiler page shows, and checks that two ways of storing the level find the same surfaces.
+// The mode picks which two:
+//
+//   split    dense cells subdivided as the game does it, against only the uniform grid
+//   compact  lists compacted by COMPACT_STATIC_SURFACES, against the linked lists add_surface_to_cell
+//            builds. Every static surface in the level gets a query just off its middle, and the share
+//            of list steps that go to the adjacent node in memory is reported for both.
+//   objects  collision objects reusing their surfaces with CACHE_DYNAMIC_SURFACES, against rebuilding
+//            them every frame. A few hundred frames of platforms, some of them turning, are loaded both
+//            ways, reporting the dynamic surfaces transformed per frame and checking the dynamic pool
+//            and cell lists come out the same.
+//   column   object_step's floor, wall and water queries done with one find_collision_column call,
+//            against the separate find_wall_collisions, find_floor and find_water_level calls. It reports
+//            the bounds checks and cell lookups per position along with the surface nodes visited.
+//
+//   collisionbench [-m mode] [-l level/area] [-q query file] [-n queries] [-o objects] [-s seed]
+
+#define MAIN_POOL_SIZE (8 * 1024 * 1024)
+#define MAX_QUERIES 100000
+#define MAX_SURFACES 0x4000
+#define WALL_RADIUS 50.0f
+#define WALL_OFFSET_Y 60.0f
+#define CEIL_OFFSET_Y 80.0f
+
+// The game state the collision code reads. None of it belongs to anything during a static query.
+struct Object *gCurrentObject;
+struct Object *gMarioObject;
+struct MarioState *gMarioState;
+struct LakituState gLakituState;
+struct Area *gCurrentArea;
+s16 gCollisionFlags;
+s32 gNumFindFloorMisses;
+u32 gTimeStopState;
+s16 gCCMEnteredSlide;
+TerrainData *gEnvironmentRegions;
+s32 gEnvironmentLevels[20];
+s32 gSurfaceNodesAllocated;
+s32 gSurfacesAllocated;
+s32 gNumStaticSurfaceNodes;
+s32 gNumStaticSurfaces;
+Mat4 gCameraTransform;
+struct CallCounter gPuppyCallCounter;
+
+static struct MarioState sMarioState;
+
+// The main pool only ever holds the surface pools here, so it's a single block that is handed out from the left.
+static u8 sPool[MAIN_POOL_SIZE];
+static u32 sPoolUsed;
+// When set, main_pool_available reports no free space. The pool itself is still all there, so terrain
+// loading works as normal, but load_area_terrain thinks it has no room for compact_static_surfaces.
+static s32 sPoolReportFull;
+
+void *main_pool_alloc(u32 size, UNUSED u32 side)
+{
+	void *addr = &sPool[sPoolUsed];
+
+	if (size > MAIN_POOL_SIZE - sPoolUsed)
+	{
+		fprintf(stderr, "main pool is full\n");
+		exit(1);
+	}
+	sPoolUsed += ALIGN16(size);
+	return addr;
+}
+
+void *main_pool_realloc(void *addr, u32 size)
+{
+	sPoolUsed = (u8 *) addr - sPool;
+	return main_pool_alloc(size, MEMORY_POOL_LEFT);
+}
+
+u32 main_pool_available(void)
+{
+	return sPoolReportFull ? 0x10 : MAIN_POOL_SIZE - sPoolUsed;
+}
+
+void *segmented_to_virtual(const void *addr)
+{
+	return (void *) addr;
+}
+
+u32 osGetCount(void)
+{
+	return 0;
+}
+
+void profiler_collision_update(UNUSED u32 time)
+{
+}
+
+void clear_dynamic_surface_references(void)
+{
+}
+
+void reset_red_coins_collected(void)
+{
+}
+
+void spawn_macro_objects(UNUSED s32 areaIndex, UNUSED MacroObject *macroObjList)
+{
+}
+
+void spawn_macro_objects_hardcoded(UNUSED s32 areaIndex, UNUSED MacroObject *macroObjList)
+{
+}
+
+// Steps over the special objects in the terrain data without spawning them.
+void spawn_special_objects(UNUSED s32 areaIndex, TerrainData **specialObjList)
+{
+	s32 numOfSpecialObjects = *(*specialObjList)++;
+
+	for (s32 i = 0; i < numOfSpecialObjects; i++)
+	{
+		u8 presetID = *(*specialObjList);
+		s32 offset = 0;
+
+		*specialObjList += 4;
+		while (SpecialObjectPresets[offset].preset_id != presetID)
+			offset++;
+
+		switch (SpecialObjectPresets[offset].type)
+		{
+			case SPTYPE_YROT_NO_PARAMS:
+			case SPTYPE_DEF_PARAM_AND_YROT:
+				*specialObjList += 1;
+				break;
+			case SPTYPE_PARAMS_AND_YROT:
+				*specialObjList += 2;
+				break;
+			case SPTYPE_UNKNOWN:
+				*specialObjList += 3;
+				break;
+		}
+	}
+}
+
+u32 get_special_objects_size(s16 *data)
+{
+	s16 *startPos = data;
+
+	spawn_special_objects(0, &data);
+	return data - startPos;
+}
+
+f32 dist_between_objects(struct Object *obj1, struct Object *obj2)
+{
+	Vec3f diff;
+
+	vec3_diff(diff, &obj1->oPosVec, &obj2->oPosVec);
+	return vec3_mag(diff);
+}
+
+void obj_build_transform_from_pos_and_angle(struct Object *obj, s16 posIndex, s16 angleIndex)
+{
+	Vec3f translate;
+	Vec3s rotation;
+
+	vec3f_copy(translate, &obj->rawData.asF32[posIndex]);
+	vec3i_to_vec3s(rotation, &obj->rawData.asS32[angleIndex]);
+	mtxf_rotate_zxy_and_translate(obj->transform, translate, rotation);
+}
+
+// Surfaces and surface nodes hold pointers, which are twice as large on a 64-bit host, so the dynamic pool is too.
+#undef DYNAMIC_SURFACE_POOL_SIZE
+#define DYNAMIC_SURFACE_POOL_SIZE (0x8000 * 2)
+
+#include "engine/math_util.c"
+#include "engine/surface_load.c"
+#include "engine/surface_collision.c"
+
+// Every level area's collision, from collisionbench_levels.c.
+extern const char *gCollisionBenchLevelNames[];
+extern const Collision *const gCollisionBenchLevels[];
+
+typedef struct
+{
+	f32 x, y, z;
+} Query;
+
+// What each kind of query found, for comparing the two ways of finding it.
+typedef struct
+{
+	struct Surface *floor;
+	struct Surface *ceil;
+	f32 floorHeight;
+	f32 ceilHeight;
+	f32 wallX, wallZ;
+	s32 numWalls;
+	struct Surface *walls[MAX_REFERENCED_WALLS];
+} QueryResult;
+
+enum QueryType
+{
+	QUERY_FLOOR,
+	QUERY_CEIL,
+	QUERY_WALL,
+	QUERY_TYPE_COUNT
+};
+
+static const char *sQueryNames[QUERY_TYPE_COUNT] = { "floor", "ceil", "wall" };
+
+static const char *sQueryPath;
+static s32 sNumQueries = 2000;
+static unsigned int sSeed = 1;
+
+static Query sQueries[MAX_QUERIES];
+static QueryResult sResults[MAX_QUERIES];
+
+static f32 random_fraction(void)
+{
+	return rand() / (f32) RAND_MAX;
+}
+
+// Collects every static surface of one kind (or every kind with NUM_SPATIAL_PARTITIONS) once, from the cell lists.
+static s32 collect_static_surfaces(struct Surface **surfaces, s32 maxSurfaces, s32 listIndex)
+{
+	s32 numSurfaces = 0;
+
+	for (s32 cellZ = 0; cellZ < NUM_CELLS; cellZ++)
+	{
+		for (s32 cellX = 0; cellX < NUM_CELLS; cellX++)
+		{
+			for (s32 list = 0; list < NUM_SPATIAL_PARTITIONS; list++)
+			{
+				if (listIndex != NUM_SPATIAL_PARTITIONS && list != listIndex)
+					continue;
+				for (struct SurfaceNode *node = gStaticSurfacePartition[cellZ][cellX][list]; node != NULL; node = node->next)
+				{
+					s32 i;
+
+					for (i = 0; i < numSurfaces; i++)
+					{
+						if (surfaces[i] == node->surface)
+							break;
+					}
+					if (i == numSurfaces && numSurfaces < maxSurfaces)
+						surfaces[numSurfaces++] = node->surface;
+				}
+			}
+		}
+	}
+	return numSurfaces;
+}
+
+// Random points on random floors, up to a few hundred units above them.
+static s32 generate_queries(s32 numQueries)
+{
+	static struct Surface *floors[MAX_SURFACES];
+	s32 numFloors = collect_static_surfaces(floors, ARRAY_COUNT(floors), SPATIAL_PARTITION_FLOORS);
+
+	if (numFloors == 0)
+		return 0;
+	for (s32 i = 0; i < numQueries; i++)
+	{
+		struct Surface *floor = floors[rand() % numFloors];
+		f32 a = random_fraction(), b = random_fraction();
+
+		if (a + b > 1.0f)
+		{
+			a = 1.0f - a;
+			b = 1.0f - b;
+		}
+		sQueries[i].x = floor->vertex1[0] + a * (floor->vertex2[0] - floor->vertex1[0]) + b * (floor->vertex3[0] - floor->vertex1[0]);
+		sQueries[i].z = floor->vertex1[2] + a * (floor->vertex2[2] - floor->vertex1[2]) + b * (floor->vertex3[2] - floor->vertex1[2]);
+		sQueries[i].y = get_surface_height_at_location(sQueries[i].x, sQueries[i].z, floor) + random_fraction() * 300.0f;
+	}
+	return numQueries;
+}
+
+static s32 read_queries(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	s32 numQueries = 0;
+
+	if (file == NULL)
+	{
+		perror(path);
+		exit(1);
+	}
+	while (numQueries < MAX_QUERIES
+	       && fscanf(file, "%f %f %f", &sQueries[numQueries].x, &sQueries[numQueries].y, &sQueries[numQueries].z) == 3)
+		numQueries++;
+	fclose(file);
+	return numQueries;
+}
+
+// Runs one kind of query over every position and returns the surface nodes visited per query.
+static double run_queries(enum QueryType type, QueryResult *results, s32 numQueries)
+{
+	gPuppyCallCounter.collision_nodes = 0;
+	for (s32 i = 0; i < numQueries; i++)
+	{
+		Query *query = &sQueries[i];
+		QueryResult *result = &results[i];
+		struct WallCollisionData wallData;
+
+		switch (type)
+		{
+			case QUERY_FLOOR:
+				result->floorHeight = find_floor(query->x, query->y, query->z, &result->floor);
+				break;
+			case QUERY_CEIL:
+				result->ceilHeight = find_ceil(query->x, query->y + CEIL_OFFSET_Y, query->z, &result->ceil);
+				break;
+			case QUERY_WALL:
+				wallData.x = query->x;
+				wallData.y = query->y;
+				wallData.z = query->z;
+				wallData.offsetY = WALL_OFFSET_Y;
+				wallData.radius = WALL_RADIUS;
+				find_wall_collisions(&wallData);
+				result->wallX = wallData.x;
+				result->wallZ = wallData.z;
+				result->numWalls = wallData.numWalls;
+				memcpy(result->walls, wallData.walls, sizeof(result->walls));
+				break;
+			default:
+				break;
+		}
+	}
+	return numQueries > 0 ? (double) gPuppyCallCounter.collision_nodes / numQueries : 0.0;
+}
+
+// Whether two surfaces are the same triangle, which may be stored at different addresses.
+static s32 same_surface(const struct Surface *a, const struct Surface *b)
+{
+	if (a == NULL || b == NULL)
+		return a == b;
+	// Everything up to the object pointer, leaving out the padding 64-bit hosts put before it.
+	return memcmp(a, b, offsetof(struct Surface, originOffset) + sizeof(a->originOffset)) == 0;
+}
+
+static s32 compare_results(enum QueryType type, const QueryResult *a, const QueryResult *b, s32 numQueries)
+{
+	s32 mismatches = 0;
+
+	for (s32 i = 0; i < numQueries; i++)
+	{
+		switch (type)
+		{
+			case QUERY_FLOOR:
+				mismatches += (!same_surface(a[i].floor, b[i].floor) || a[i].floorHeight != b[i].floorHeight);
+				break;
+			case QUERY_CEIL:
+				mismatches += (!same_surface(a[i].ceil, b[i].ceil) || a[i].ceilHeight != b[i].ceilHeight);
+				break;
+			case QUERY_WALL:
+			{
+				s32 differs = (a[i].wallX != b[i].wallX || a[i].wallZ != b[i].wallZ || a[i].numWalls != b[i].numWalls);
+
+				for (s32 j = 0; !differs && j < a[i].numWalls; j++)
+					differs = !same_surface(a[i].walls[j], b[i].walls[j]);
+				mismatches += differs;
+				break;
+			}
+			default:
+				break;
+		}
+	}
+	return mismatches;
+}
+
+// Loads a level's collision into the main pool, from poolStart up.
+static void load_level(const Collision *collision, u32 poolStart)
+{
+	sPoolUsed = poolStart;
+	alloc_surface_pools();
+	load_area_terrain(0, (TerrainData *) collision, NULL, NULL);
+	clear_dynamic_surfaces();
+}
+
+static s32 load_queries(void)
+{
+	srand(sSeed);
+	return (sQueryPath != NULL) ? read_queries(sQueryPath) : generate_queries(sNumQueries);
+}
+
+static void print_query_columns(void)
+{
+	for (s32 type = 0; type < QUERY_TYPE_COUNT; type++)
+		printf(" %17s", sQueryNames[type]);
+	printf("  results\n");
+}
+
+static void print_query_averages(double totals[2][QUERY_TYPE_COUNT], s32 numLevels)
+{
+	if (numLevels > 1)
+	{
+		printf("%-22s %8s %6s", "average", "", "");
+		for (s32 type = 0; type < QUERY_TYPE_COUNT; type++)
+			printf("  %6.1f -> %6.1f", totals[0][type] / numLevels, totals[1][type] / numLevels);
+		printf("\n");
+	}
+}
+
+// Subdivided cells against the uniform grid they were split from.
+
+static double sSplitTotals[2][QUERY_TYPE_COUNT];
+
+static void split_header(void)
+{
+	printf("surface nodes visited per query, with dense cells subdivided -> with the uniform grid only\n");
+	printf("%-22s %8s %6s", "level", "surfaces", "split");
+	print_query_columns();
+}
+
+static s32 split_level(s32 level)
+{
+	static QueryResult uniformResults[MAX_QUERIES];
+	s32 mismatches = 0;
+	s32 numSplit = 0;
+	s32 count;
+
+	load_level(gCollisionBenchLevels[level], 0);
+	count = load_queries();
+	if (count == 0)
+		return -1;
+#ifdef STATIC_SURFACE_SUBDIVISION_THRESHOLD
+	numSplit = gNumSubdividedCells;
+#endif
+
+	printf("%-22s %8d %6d", gCollisionBenchLevelNames[level], gNumStaticSurfaces, numSplit);
+	for (s32 type = 0; type < QUERY_TYPE_COUNT; type++)
+	{
+		double split = run_queries(type, sResults, count);
+		double uniform;
+
+#ifdef STATIC_SURFACE_SUBDIVISION_THRESHOLD
+		// The parent cells keep their full lists, so hiding the subcells goes back to the uniform grid.
+		static SpatialPartitionCell *subcells[NUM_CELLS][NUM_CELLS];
+
+		memcpy(subcells, gStaticSurfaceSubcells, sizeof(subcells));
+		bzero(gStaticSurfaceSubcells, sizeof(gStaticSurfaceSubcells));
+		uniform = run_queries(type, uniformResults, count);
+		memcpy(gStaticSurfaceSubcells, subcells, sizeof(subcells));
+#else
+		uniform = run_queries(type, uniformResults, count);
+#endif
+		mismatches += compare_results(type, sResults, uniformResults, count);
+		sSplitTotals[0][type] += split;
+		sSplitTotals[1][type] += uniform;
+		printf("  %6.1f -> %6.1f", split, uniform);
+	}
+	printf("  %s\n", mismatches == 0 ? "identical" : "DIFFERENT");
+	return mismatches;
+}
+
+static void split_footer(s32 numLevels)
+{
+	print_query_averages(sSplitTotals, numLevels);
+}
+
+// Compacted static lists against the linked lists add_surface_to_cell builds.
+
+#ifdef COMPACT_STATIC_SURFACES
+static double sCompactTotals[2][QUERY_TYPE_COUNT];
+
+// One query per static surface, just off its middle, so every surface in the level gets looked up.
+static s32 generate_surface_queries(void)
+{
+	static struct Surface *surfaces[MAX_SURFACES];
+	s32 numSurfaces = collect_static_surfaces(surfaces, ARRAY_COUNT(surfaces), NUM_SPATIAL_PARTITIONS);
+
+	for (s32 i = 0; i < numSurfaces; i++)
+	{
+		struct Surface *surf = surfaces[i];
+
+		sQueries[i].x = (surf->vertex1[0] + surf->vertex2[0] + surf->vertex3[0]) / 3.0f;
+		sQueries[i].y = (surf->vertex1[1] + surf->vertex2[1] + surf->vertex3[1]) / 3.0f;
+		sQueries[i].z = (surf->vertex1[2] + surf->vertex2[2] + surf->vertex3[2]) / 3.0f;
+		if (surf->normal.y > NORMAL_FLOOR_THRESHOLD)
+			sQueries[i].y += 10.0f;
+		else if (surf->normal.y < NORMAL_CEIL_THRESHOLD)
+			sQueries[i].y -= CEIL_OFFSET_Y + 10.0f;
+		else
+			sQueries[i].y -= WALL_OFFSET_Y;
+	}
+	return numSurfaces;
+}
+
+// The share of steps along the static lists that go to the very next node in memory.
+static double contiguous_list_steps(void)
+{
+	s32 steps = 0, contiguous = 0;
+
+	for (s32 cellZ = 0; cellZ < NUM_CELLS; cellZ++)
+	{
+		for (s32 cellX = 0; cellX < NUM_CELLS; cellX++)
+		{
+			s32 numCells = 1;
+
+#ifdef STATIC_SURFACE_SUBDIVISION_THRESHOLD
+			if (gStaticSurfaceSubcells[cellZ][cellX] != NULL)
+				numCells += NUM_SUBCELLS;
+#endif
+			for (s32 i = 0; i < numCells; i++)
+			{
+				SpatialPartitionCell *cell = &gStaticSurfacePartition[cellZ][cellX];
+
+#ifdef STATIC_SURFACE_SUBDIVISION_THRESHOLD
+				if (i > 0)
+					cell = &gStaticSurfaceSubcells[cellZ][cellX][i - 1];
+#endif
+				for (s32 list = 0; list < NUM_SPATIAL_PARTITIONS; list++)
+				{
+					for (struct SurfaceNode *node = (*cell)[list]; node != NULL && node->next != NULL; node = node->next)
+					{
+						steps++;
+						contiguous += (node->next == node + 1);
+					}
+				}
+			}
+		}
+	}
+	return steps > 0 ? 100.0 * contiguous / steps : 100.0;
+}
+
+static void compact_header(void)
+{
+	printf("surface nodes visited per query and %% of list steps to the adjacent node, compacted -> linked lists\n");
+	printf("%-22s %8s %17s %17s", "level", "queries", "adjacent", "pool bytes");
+	print_query_columns();
+}
+
+static s32 compact_level(s32 level)
+{
+	static QueryResult linkedResults[MAX_QUERIES];
+	s32 mismatches = 0;
+	s32 count;
+	u32 linkedSize, compactSize;
+	double linkedAdjacent, compactAdjacent;
+	double linked[QUERY_TYPE_COUNT];
+
+	sPoolReportFull = TRUE;
+	load_level(gCollisionBenchLevels[level], 0);
+	sPoolReportFull = FALSE;
+	count = generate_surface_queries();
+	if (count == 0)
+		return -1;
+	linkedSize = (uintptr_t) gCurrStaticSurfacePoolEnd - (uintptr_t) gCurrStaticSurfacePool;
+	linkedAdjacent = contiguous_list_steps();
+	for (s32 type = 0; type < QUERY_TYPE_COUNT; type++)
+		linked[type] = run_queries(type, linkedResults, count);
+
+	// Loaded past the linked lists, so the surfaces their results point to are left alone.
+	load_level(gCollisionBenchLevels[level], sPoolUsed);
+	compactSize = (uintptr_t) gCurrStaticSurfacePoolEnd - (uintptr_t) gCurrStaticSurfacePool;
+	compactAdjacent = contiguous_list_steps();
+
+	printf("%-22s %8d  %6.1f -> %6.1f  %6u -> %6u", gCollisionBenchLevelNames[level], count, compactAdjacent, linkedAdjacent,
+	       compactSize, linkedSize);
+	for (s32 type = 0; type < QUERY_TYPE_COUNT; type++)
+	{
+		double compact = run_queries(type, sResults, count);
+
+		mismatches += compare_results(type, sResults, linkedResults, count);
+		sCompactTotals[0][type] += compact;
+		sCompactTotals[1][type] += linked[type];
+		printf("  %6.1f -> %6.1f", compact, linked[type]);
+	}
+	printf("  %s\n", mismatches == 0 ? "identical" : "DIFFERENT");
+	return mismatches;
+}
+
+static void compact_footer(s32 numLevels)
+{
+	if (numLevels > 1)
+	{
+		printf("%-22s %8s %17s %17s", "average", "", "", "");
+		for (s32 type = 0; type < QUERY_TYPE_COUNT; type++)
+			printf("  %6.1f -> %6.1f", sCompactTotals[0][type] / numLevels, sCompactTotals[1][type] / numLevels);
+		printf("\n");
+	}
+}
+#endif
+
+// Collision objects with their surfaces reused by CACHE_DYNAMIC_SURFACES, against rebuilding them every frame.
+
+#ifdef CACHE_DYNAMIC_SURFACES
+#define MAX_OBJECTS 40
+#define NUM_FRAMES 300
+// Every MOVING_OBJECT_INTERVAL'th object turns every frame, like a rotating platform does.
+#define MOVING_OBJECT_INTERVAL 4
+
+// A 400 x 100 x 400 platform, the size of a typical moving platform.
+static const Collision sPlatformCollision[] = {
+	COL_INIT(),
+	COL_VERTEX_INIT(8),
+	COL_VERTEX(-200, 0, -200),
+	COL_VERTEX(200, 0, -200),
+	COL_VERTEX(200, 0, 200),
+	COL_VERTEX(-200, 0, 200),
+	COL_VERTEX(-200, 100, -200),
+	COL_VERTEX(200, 100, -200),
+	COL_VERTEX(200, 100, 200),
+	COL_VERTEX(-200, 100, 200),
+	COL_TRI_INIT(SURFACE_DEFAULT, 12),
+	COL_TRI(4, 7, 6),
+	COL_TRI(4, 6, 5),
+	COL_TRI(0, 1, 2),
+	COL_TRI(0, 2, 3),
+	COL_TRI(0, 4, 5),
+	COL_TRI(0, 5, 1),
+	COL_TRI(1, 5, 6),
+	COL_TRI(1, 6, 2),
+	COL_TRI(2, 6, 7),
+	COL_TRI(2, 7, 3),
+	COL_TRI(3, 7, 4),
+	COL_TRI(3, 4, 0),
+	COL_TRI_STOP(),
+	COL_END(),
+};
+
+static s32 sNumObjects = 30;
+static struct Object sObjects[MAX_OBJECTS];
+static struct Object sMarioObject;
+static double sObjectTotals[2];
+
+// A frame's dynamic surfaces and cell lists, to check reusing them left the same collision as rebuilding it.
+typedef struct
+{
+	s32 numSurfaces;
+	struct Surface surfaces[MAX_OBJECTS * 12];
+	s32 numLinks;
+	// The index of each surface in the pool, list by list, with -1 ending each list.
+	s16 links[NUM_CELLS * NUM_CELLS * NUM_SPATIAL_PARTITIONS + MAX_OBJECTS * 12 * 16];
+} DynamicSnapshot;
+
+static DynamicSnapshot sCachedSnapshot;
+static DynamicSnapshot sRebuiltSnapshot;
+
+static void take_dynamic_snapshot(DynamicSnapshot *snapshot)
+{
+	struct Surface *surfaces = gDynamicSurfacePool;
+
+	snapshot->numSurfaces = (struct Surface *) gDynamicSurfacePoolEnd - surfaces;
+	memcpy(snapshot->surfaces, surfaces, snapshot->numSurfaces * sizeof(struct Surface));
+	snapshot->numLinks = 0;
+	for (s32 cellZ = 0; cellZ < NUM_CELLS; cellZ++)
+	{
+		for (s32 cellX = 0; cellX < NUM_CELLS; cellX++)
+		{
+			for (s32 list = 0; list < NUM_SPATIAL_PARTITIONS; list++)
+			{
+				for (struct SurfaceNode *node = gDynamicSurfacePartition[cellZ][cellX][list]; node != NULL; node = node->next)
+					snapshot->links[snapshot->numLinks++] = node->surface - surfaces;
+				snapshot->links[snapshot->numLinks++] = -1;
+			}
+		}
+	}
+}
+
+static s32 same_dynamic_snapshot(const DynamicSnapshot *a, const DynamicSnapshot *b)
+{
+	if (a->numSurfaces != b->numSurfaces || a->numLinks != b->numLinks
+	    || memcmp(a->links, b->links, a->numLinks * sizeof(a->links[0])) != 0)
+		return FALSE;
+	for (s32 i = 0; i < a->numSurfaces; i++)
+	{
+		if (!same_surface(&a->surfaces[i], &b->surfaces[i]) || a->surfaces[i].object != b->surfaces[i].object)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+// Loads every object's collision the way update_terrain_objects does and returns how many surfaces were transformed.
+static s32 load_dynamic_surfaces(void)
+{
+	clear_dynamic_surfaces();
+	for (s32 i = 0; i < sNumObjects; i++)
+	{
+		gCurrentObject = &sObjects[i];
+		load_object_collision_model();
+	}
+	gCurrentObject = NULL;
+	if (get_dynamic_surface_pool_used() > DYNAMIC_SURFACE_POOL_SIZE)
+	{
+		fprintf(stderr, "dynamic surface pool size exceeded\n");
+		exit(1);
+	}
+	return gNumDynamicSurfacesTransformed;
+}
+
+static void objects_header(void)
+{
+	printf("%d collision objects for %d frames, every %d%s turning. Dynamic surfaces transformed per frame, reused -> rebuilt\n",
+	       sNumObjects, NUM_FRAMES, MOVING_OBJECT_INTERVAL, MOVING_OBJECT_INTERVAL == 2 ? "nd" : "th");
+	printf("%-22s %17s  results\n", "level", "transformed");
+}
+
+static s32 objects_level(s32 level)
+{
+	s32 mismatches = 0;
+	s32 transformed[2] = { 0, 0 };
+	s32 count;
+
+	load_level(gCollisionBenchLevels[level], 0);
+	srand(sSeed);
+	count = generate_queries(sNumObjects);
+	if (count == 0)
+		return -1;
+
+	// Mario is somewhere out of the way, with every object close enough to load its collision.
+	bzero(&sMarioObject, sizeof(sMarioObject));
+	gMarioObject = &sMarioObject;
+	bzero(sObjects, sizeof(sObjects));
+	for (s32 i = 0; i < sNumObjects; i++)
+	{
+		struct Object *obj = &sObjects[i];
+
+		obj->collisionData = (void *) sPlatformCollision;
+		vec3f_set(&obj->oPosVec, sQueries[i].x, sQueries[i].y, sQueries[i].z);
+		obj->oFaceAngleYaw = rand();
+		vec3f_set(obj->header.gfx.scale, 1.0f, 1.0f, 1.0f);
+		obj->oFlags = OBJ_FLAG_DONT_CALC_COLL_DIST;
+		obj->oCollisionDistance = 50000.0f;
+		obj->oDrawingDistance = 50000.0f;
+		obj->oDistanceToMario = 0.0f;
+		obj->activeFlags = ACTIVE_FLAG_ACTIVE;
+	}
+
+	for (s32 frame = 0; frame < NUM_FRAMES; frame++)
+	{
+		for (s32 i = 0; i < sNumObjects; i++)
+		{
+			// Rendering clears throwMatrix, so the collision transform is rebuilt from the position and angle.
+			sObjects[i].header.gfx.throwMatrix = NULL;
+			if (i % MOVING_OBJECT_INTERVAL == 0)
+				sObjects[i].oFaceAngleYaw += 0x100;
+		}
+
+		transformed[0] += load_dynamic_surfaces();
+		take_dynamic_snapshot(&sCachedSnapshot);
+
+		// Forgetting last frame's surfaces makes every object rebuild them, like the game did before the cache.
+		bzero(sDynamicSurfaceCache, sizeof(sDynamicSurfaceCache));
+		transformed[1] += load_dynamic_surfaces();
+		take_dynamic_snapshot(&sRebuiltSnapshot);
+		mismatches += !same_dynamic_snapshot(&sCachedSnapshot, &sRebuiltSnapshot);
+	}
+
+	printf("%-22s  %6.1f -> %6.1f  %s\n", gCollisionBenchLevelNames[level], (double) transformed[0] / NUM_FRAMES,
+	       (double) transformed[1] / NUM_FRAMES, mismatches == 0 ? "identical" : "DIFFERENT");
+	sObjectTotals[0] += (double) transformed[0] / NUM_FRAMES;
+	sObjectTotals[1] += (double) transformed[1] / NUM_FRAMES;
+	gMarioObject = NULL;
+	return mismatches;
+}
+
+static void objects_footer(s32 numLevels)
+{
+	if (numLevels > 1)
+		printf("%-22s  %6.1f -> %6.1f\n", "average", sObjectTotals[0] / numLevels, sObjectTotals[1] / numLevels);
+}
+#endif
+
+// The floor, walls and water of an object step found with find_collision_column, against the separate queries it replaced.
+
+typedef struct
+{
+	struct Surface *floor;
+	f32 floorHeight;
+	s32 waterLevel;
+	f32 wallX, wallY, wallZ;
+	s32 numWalls;
+	struct Surface *walls[MAX_REFERENCED_WALLS];
+} StepResult;
+
+static double sColumnTotals[2][2];
+
+// Runs object_step's collision queries over every position, one column query or three separate ones,
+// and returns the surface nodes visited per query. lookups receives the bounds checks and cell lookups per query.
+static double run_step_queries(s32 useColumn, StepResult *results, s32 numQueries, double *lookups)
+{
+	bzero(&gPuppyCallCounter, sizeof(gPuppyCallCounter));
+	for (s32 i = 0; i < numQueries; i++)
+	{
+		Query *query = &sQueries[i];
+		StepResult *result = &results[i];
+		struct WallCollisionData wallData;
+
+		// Water floors are looked for at Mario's height.
+		sMarioState.pos[1] = query->y;
+		wallData.offsetY = WALL_OFFSET_Y;
+		wallData.radius = WALL_RADIUS;
+		if (useColumn)
+		{
+			struct CollisionColumn column;
+
+			find_collision_column(query->x, query->y, query->z, (RAYCAST_FIND_FLOOR | RAYCAST_FIND_WALL | RAYCAST_FIND_WATER),
+			                      &column, &wallData);
+			result->floor = column.floor;
+			result->floorHeight = column.floorHeight;
+			result->waterLevel = column.waterLevel;
+		}
+		else
+		{
+			wallData.x = query->x;
+			wallData.y = query->y;
+			wallData.z = query->z;
+			find_wall_collisions(&wallData);
+			result->floorHeight = find_floor(query->x, query->y, query->z, &result->floor);
+			result->waterLevel = find_water_level(query->x, query->z);
+		}
+		result->wallX = wallData.x;
+		result->wallY = wallData.y;
+		result->wallZ = wallData.z;
+		result->numWalls = wallData.numWalls;
+		memcpy(result->walls, wallData.walls, sizeof(result->walls));
+	}
+
+	// Walls do their own lookup either way, counted once even when they span several cells.
+	// The column does one lookup for everything else.
+	*lookups = (double) (gPuppyCallCounter.collision_wall
+	                     + (useColumn ? gPuppyCallCounter.collision_column
+	                                  : gPuppyCallCounter.collision_floor + gPuppyCallCounter.collision_water))
+	           / numQueries;
+	return (double) gPuppyCallCounter.collision_nodes / numQueries;
+}
+
+static s32 compare_step_results(const StepResult *a, const StepResult *b, s32 numQueries)
+{
+	s32 mismatches = 0;
+
+	for (s32 i = 0; i < numQueries; i++)
+	{
+		s32 differs = (a[i].floor != b[i].floor || a[i].floorHeight != b[i].floorHeight || a[i].waterLevel != b[i].waterLevel
+		               || a[i].wallX != b[i].wallX || a[i].wallY != b[i].wallY || a[i].wallZ != b[i].wallZ
+		               || a[i].numWalls != b[i].numWalls);
+
+		for (s32 j = 0; !differs && j < a[i].numWalls; j++)
+			differs = (a[i].walls[j] != b[i].walls[j]);
+		mismatches += differs;
+	}
+	return mismatches;
+}
+
+static void column_header(void)
+{
+	printf("object_step's floor, wall and water queries per position, one column query -> separate queries\n");
+	printf("%-22s %8s %17s %17s  results\n", "level", "queries", "cell lookups", "surface nodes");
+}
+
+static s32 column_level(s32 level)
+{
+	static StepResult columnResults[MAX_QUERIES];
+	static StepResult separateResults[MAX_QUERIES];
+	double lookups[2], nodes[2];
+	s32 mismatches;
+	s32 count;
+
+	load_level(gCollisionBenchLevels[level], 0);
+	count = load_queries();
+	if (count == 0)
+		return -1;
+
+	nodes[0] = run_step_queries(TRUE, columnResults, count, &lookups[0]);
+	nodes[1] = run_step_queries(FALSE, separateResults, count, &lookups[1]);
+	mismatches = compare_step_results(columnResults, separateResults, count);
+	printf("%-22s %8d  %6.2f -> %6.2f  %6.1f -> %6.1f  %s\n", gCollisionBenchLevelNames[level], count, lookups[0],
+	       lookups[1], nodes[0], nodes[1], mismatches == 0 ? "identical" : "DIFFERENT");
+	for (s32 i = 0; i < 2; i++)
+	{
+		sColumnTotals[0][i] += lookups[i];
+		sColumnTotals[1][i] += nodes[i];
+	}
+	return mismatches;
+}
+
+static void column_footer(s32 numLevels)
+{
+	if (numLevels > 1)
+	{
+		printf("%-22s %8s  %6.2f -> %6.2f  %6.1f -> %6.1f\n", "average", "", sColumnTotals[0][0] / numLevels,
+		       sColumnTotals[0][1] / numLevels, sColumnTotals[1][0] / numLevels, sColumnTotals[1][1] / numLevels);
+	}
+}
+
+typedef struct
+{
+	const char *name;
+	void (*header)(void);
+	// Benchmarks one level and returns how many results differed, or -1 if there was nothing to run.
+	s32 (*level)(s32 level);
+	void (*footer)(s32 numLevels);
+} BenchMode;
+
+static const BenchMode sModes[] = {
+	{ "split", split_header, split_level, split_footer },
+#ifdef COMPACT_STATIC_SURFACES
+	{ "compact", compact_header, compact_level, compact_footer },
+#endif
+#ifdef CACHE_DYNAMIC_SURFACES
+	{ "objects", objects_header, objects_level, objects_footer },
+#endif
+	{ "column", column_header, column_level, column_footer },
+};
+
+int main(int argc, char **argv)
+{
+	const BenchMode *mode = &sModes[0];
+	const char *levelName = NULL;
+	s32 totalMismatches = 0;
+	s32 numLevels = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+		{
+			const char *modeName = argv[++i];
+
+			mode = NULL;
+			for (u32 j = 0; j < ARRAY_COUNT(sModes); j++)
+			{
+				if (strcmp(modeName, sModes[j].name) == 0)
+					mode = &sModes[j];
+			}
+			if (mode == NULL)
+			{
+				fprintf(stderr, "unknown mode %s\n", modeName);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+			levelName = argv[++i];
+		else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc)
+			sQueryPath = argv[++i];
+		else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			sNumQueries = atoi(argv[++i]);
+#ifdef CACHE_DYNAMIC_SURFACES
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			sNumObjects = atoi(argv[++i]);
+#endif
+		else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+			sSeed = strtoul(argv[++i], NULL, 0);
+		else
+		{
+			fprintf(stderr, "collisionbench [-m mode] [-l level/area] [-q query file] [-n queries] [-o objects] [-s seed]\n");
+			return 1;
+		}
+	}
+#ifdef CACHE_DYNAMIC_SURFACES
+	if (sNumObjects <= 0 || sNumObjects > MAX_OBJECTS)
+	{
+		fprintf(stderr, "the number of objects must be from 1 to %d\n", MAX_OBJECTS);
+		return 1;
+	}
+#endif
+	if (sNumQueries <= 0 || sNumQueries > MAX_QUERIES)
+	{
+		fprintf(stderr, "the number of queries must be from 1 to %d\n", MAX_QUERIES);
+		return 1;
+	}
+
+	gMarioState = &sMarioState;
+	gMarioObject = NULL;
+	gCurrentObject = NULL;
+
+	mode->header();
+	for (s32 level = 0; gCollisionBenchLevelNames[level] != NULL; level++)
+	{
+		s32 mismatches;
+
+		if (levelName != NULL && strcmp(levelName, gCollisionBenchLevelNames[level]) != 0)
+			continue;
+
+		mismatches = mode->level(level);
+		if (mismatches < 0)
+			continue;
+		totalMismatches += mismatches;
+		numLevels++;
+	}
+
+	if (numLevels == 0)
+	{
+		fprintf(stderr, "no level matches %s\n", levelName);
+		return 1;
+	}
+	mode->footer(numLevels);
+	if (totalMismatches != 0)
+	{
+		printf("%d queries found different surfaces\n", totalMismatches);
+		return 1;
+	}
+	return 0;
+}
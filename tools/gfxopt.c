@@ -0,0 +1,1579 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+
+// Display list optimizer for the asset .inc.c files
+//
+// Walks every static Gfx array, keeping track of the RDP and RSP state that the list itself sets,
+// and drops commands that cannot change anything:
+//  - state commands that set exactly what is already set (combine mode, render mode, colors,
+//    texture image, tiles, geometry mode bits, light colors, ...)
+//  - texture loads that would load the same data again
+//  - pipe, load and tile syncs with nothing left for them to wait on
+// Adjacent gsSP1Triangle commands are merged into gsSP2Triangles.
+//
+// With -b, each run of vertex loads and triangles is also packed into as few loads as fit in the
+// microcode's vertex buffer (32 for F3DEX2 and F3DZEX, 16 for Fast3D). Every vertex is loaded once
+// per batch, which removes both loads and repeated transforms. The new vertex arrays are written in
+// front of the list, and vertex arrays nothing uses any more are removed. Triangles keep their
+// order, which can matter for decals and translucent layers, unless -r is given.
+// Loads and triangles that use entries past the end of the buffer, like ones an earlier run wrote
+// for a bigger buffer, are always split up. If that isn't possible the file is left as it is and
+// gfxopt fails.
+//
+// Nothing is assumed about the state a list is called with, and every gsSPDisplayList call or
+// unknown command forgets everything that was tracked. Lists containing preprocessor directives,
+// commands split over several lines, or that are referenced somewhere other than their start are
+// left alone.
+//
+//   gfxopt [-n] [-v] [-b size [-r]] file...
+//     -n  only print the report, don't rewrite the files
+//     -v  report every display list, not just every file
+//     -b  rebatch vertex loads for a vertex buffer of this many entries
+//     -r  allow triangles to be reordered when rebatching
+
+#define MAX_NAME  64
+#define MAX_ARGS  512
+#define MAX_STATE 128
+#define MAX_BUFFER 64
+
+enum CmdType
+{
+	CMD_NONE,     // blank or comment line
+	CMD_PRIM,     // draws something
+	CMD_RSP,      // only changes RSP state
+	CMD_RDP,      // changes RDP state
+	CMD_LOAD,     // loads TMEM
+	CMD_PIPESYNC,
+	CMD_LOADSYNC,
+	CMD_TILESYNC,
+	CMD_BARRIER,  // ends the list, calls another one or isn't understood
+};
+
+typedef struct
+{
+	char *text;     // the whole line, including its newline
+	char *replace;  // replacement line, or NULL
+	char *prefix;   // text to insert before the line, or NULL
+	char name[MAX_NAME];
+	char args[MAX_ARGS]; // arguments without whitespace
+	char rawArgs[MAX_ARGS];
+	int type;
+	int hasComment;
+	int removed;
+} Line;
+
+typedef struct
+{
+	char key[MAX_ARGS + 16];
+	char value[MAX_ARGS];
+} StateEntry;
+
+typedef struct
+{
+	StateEntry entries[MAX_STATE];
+	int count;
+} State;
+
+typedef struct
+{
+	int lists;
+	int removed;
+	int merged;
+	int bytes;
+	int rebatched;
+	int loadsBefore;
+	int loadsAfter;
+	int verticesBefore;
+	int verticesAfter;
+} Stats;
+
+static int verbose = 0;
+static int bufferSize = 0; // vertex buffer size to rebatch for, or 0 to leave vertex loads alone
+static int reorder = 0;
+
+static const char *primCmds[] = {
+	"gsSP1Triangle", "gsSP2Triangles", "gsSP1Quadrangle", "gsSPLine3D", "gsSPLineW3D",
+	"gsSPTextureRectangle", "gsSPTextureRectangleFlip", "gsSPScisTextureRectangle", "gsDPFillRectangle",
+	NULL
+};
+
+static const char *rspCmds[] = {
+	"gsSPVertex", "gsSPLightColor", "gsSPTexture", "gsSPSetGeometryMode", "gsSPClearGeometryMode",
+	"gsSPGeometryMode", "gsSPLoadGeometryMode", "gsSPGeometryModeSetFirst", "gsSPFogPosition",
+	"gsSPFogFactor", "gsSPNumLights", "gsSPClipRatio", "gsSPPerspNormalize",
+	NULL
+};
+
+static const char *rdpCmds[] = {
+	"gsDPSetCombineMode", "gsDPSetCombineLERP", "gsDPSetRenderMode", "gsDPSetCycleType",
+	"gsDPSetTextureFilter", "gsDPSetTexturePersp", "gsDPSetTextureLOD", "gsDPSetTextureLUT",
+	"gsDPSetTextureDetail", "gsDPSetTextureConvert", "gsDPSetCombineKey", "gsDPSetColorDither",
+	"gsDPSetAlphaDither", "gsDPSetAlphaCompare", "gsDPSetDepthSource", "gsDPSetFogColor",
+	"gsDPSetEnvColor", "gsDPSetBlendColor", "gsDPSetPrimColor", "gsDPSetFillColor", "gsDPSetPrimDepth",
+	"gsDPSetTextureImage", "gsDPSetTile", "gsDPSetTileSize",
+	NULL
+};
+
+// loads that only touch TMEM and the tile they load through
+static const char *loadCmds[] = {
+	"gsDPLoadBlock", "gsDPLoadTile", "gsDPLoadTLUTCmd",
+	NULL
+};
+
+// macros that set the texture image and several tiles as well as loading TMEM
+static const char *compoundLoadPrefixes[] = {
+	"gsDPLoadTextureBlock", "gsDPLoadTextureTile", "gsDPLoadMultiBlock", "gsDPLoadMultiTile", "gsDPLoadTLUT_",
+	NULL
+};
+
+static int in_list(const char *name, const char **list)
+{
+	for (int i = 0; list[i] != NULL; i++)
+	{
+		if (strcmp(name, list[i]) == 0)
+			return 1;
+	}
+	return 0;
+}
+
+static int is_compound_load(const char *name)
+{
+	for (int i = 0; compoundLoadPrefixes[i] != NULL; i++)
+	{
+		if (strncmp(name, compoundLoadPrefixes[i], strlen(compoundLoadPrefixes[i])) == 0)
+			return 1;
+	}
+	return 0;
+}
+
+static int classify(const char *name)
+{
+	if (strcmp(name, "gsDPPipeSync") == 0)
+		return CMD_PIPESYNC;
+	if (strcmp(name, "gsDPLoadSync") == 0)
+		return CMD_LOADSYNC;
+	if (strcmp(name, "gsDPTileSync") == 0)
+		return CMD_TILESYNC;
+	if (in_list(name, primCmds))
+		return CMD_PRIM;
+	if (in_list(name, rspCmds))
+		return CMD_RSP;
+	if (in_list(name, rdpCmds))
+		return CMD_RDP;
+	if (in_list(name, loadCmds) || is_compound_load(name))
+		return CMD_LOAD;
+	return CMD_BARRIER;
+}
+
+// size of a command in the final display list
+static int command_words(const char *name)
+{
+	if (strcmp(name, "gsSPLightColor") == 0)
+		return 2;
+	if (strcmp(name, "gsSPClipRatio") == 0)
+		return 4;
+	return 1;
+}
+
+// Splits the arguments at top level commas. Returns the number of arguments, copying argument
+// number `which` into `out` when it exists.
+static int get_arg(const char *args, int which, char *out, size_t outSize)
+{
+	int depth = 0;
+	int num = 0;
+	size_t len = 0;
+
+	if (out != NULL)
+		out[0] = '\0';
+	if (args[0] == '\0')
+		return 0;
+
+	for (const char *p = args; ; p++)
+	{
+		if (*p == '\0' || (*p == ',' && depth == 0))
+		{
+			if (num == which && out != NULL)
+				out[len] = '\0';
+			num++;
+			if (*p == '\0')
+				break;
+			continue;
+		}
+		if (*p == '(')
+			depth++;
+		else if (*p == ')')
+			depth--;
+		if (num == which && out != NULL && len + 1 < outSize)
+			out[len++] = *p;
+	}
+	return num;
+}
+
+/* State tracking */
+
+static const char *state_get(State *state, const char *key)
+{
+	for (int i = 0; i < state->count; i++)
+	{
+		if (strcmp(state->entries[i].key, key) == 0)
+			return state->entries[i].value;
+	}
+	return NULL;
+}
+
+static void state_set(State *state, const char *key, const char *value)
+{
+	for (int i = 0; i < state->count; i++)
+	{
+		if (strcmp(state->entries[i].key, key) == 0)
+		{
+			snprintf(state->entries[i].value, sizeof(state->entries[i].value), "%s", value);
+			return;
+		}
+	}
+	if (state->count < MAX_STATE)
+	{
+		snprintf(state->entries[state->count].key, sizeof(state->entries[0].key), "%s", key);
+		snprintf(state->entries[state->count].value, sizeof(state->entries[0].value), "%s", value);
+		state->count++;
+	}
+}
+
+// Forgets every key starting with prefix.
+static void state_forget(State *state, const char *prefix)
+{
+	size_t len = strlen(prefix);
+
+	for (int i = 0; i < state->count; )
+	{
+		if (strncmp(state->entries[i].key, prefix, len) == 0)
+			state->entries[i] = state->entries[--state->count];
+		else
+			i++;
+	}
+}
+
+// Composite geometry mode flags, so that each tracked key is a single bit.
+static int expand_geometry_flag(const char *flag, const char **bits)
+{
+	if (strcmp(flag, "G_CULL_BOTH") == 0)
+	{
+		bits[0] = "G_CULL_FRONT";
+		bits[1] = "G_CULL_BACK";
+		return 2;
+	}
+	bits[0] = flag;
+	return 1;
+}
+
+// Handles gsSPSetGeometryMode and gsSPClearGeometryMode. Returns 1 if every bit it changes is
+// already known to be in that state.
+static int update_geometry_mode(State *state, const char *args, const char *value)
+{
+	char flags[MAX_ARGS];
+	char *flag;
+	int redundant = 1;
+
+	snprintf(flags, sizeof(flags), "%s", args);
+	for (const char *p = flags; *p != '\0'; p++)
+	{
+		// anything but a plain list of flag names can't be tracked
+		if (!isalnum((unsigned char) *p) && *p != '_' && *p != '|')
+		{
+			state_forget(state, "geo:");
+			return 0;
+		}
+	}
+
+	for (flag = strtok(flags, "|"); flag != NULL; flag = strtok(NULL, "|"))
+	{
+		const char *bits[2];
+		int numBits;
+
+		if (isdigit((unsigned char) flag[0]))
+		{
+			state_forget(state, "geo:");
+			return 0;
+		}
+
+		numBits = expand_geometry_flag(flag, bits);
+		for (int i = 0; i < numBits; i++)
+		{
+			char key[MAX_ARGS + 16];
+			const char *cur;
+
+			snprintf(key, sizeof(key), "geo:%s", bits[i]);
+			cur = state_get(state, key);
+			if (cur == NULL || strcmp(cur, value) != 0)
+				redundant = 0;
+			state_set(state, key, value);
+		}
+	}
+	return redundant;
+}
+
+// Returns 1 if the command can be dropped because it sets state that is already set.
+static int update_state(State *state, Line *line)
+{
+	char key[MAX_ARGS + 16];
+	char arg[MAX_ARGS];
+	const char *name = line->name;
+	const char *cur;
+
+	if (line->type == CMD_BARRIER)
+	{
+		state->count = 0;
+		return 0;
+	}
+
+	if (strcmp(name, "gsSPSetGeometryMode") == 0)
+		return update_geometry_mode(state, line->args, "1");
+	if (strcmp(name, "gsSPClearGeometryMode") == 0)
+		return update_geometry_mode(state, line->args, "0");
+	if (strncmp(name, "gsSPGeometryMode", 16) == 0 || strcmp(name, "gsSPLoadGeometryMode") == 0)
+	{
+		state_forget(state, "geo:");
+		return 0;
+	}
+
+	if (line->type == CMD_LOAD)
+	{
+		if (is_compound_load(name))
+		{
+			state_forget(state, "timg");
+			state_forget(state, "tile");
+			state_forget(state, "load");
+			return 0;
+		}
+
+		// loading the same thing again through an unchanged tile leaves TMEM as it was
+		snprintf(arg, sizeof(arg), "%s(%s)", name, line->args);
+		cur = state_get(state, "load");
+		if (cur != NULL && strcmp(cur, arg) == 0)
+			return 1;
+		state_set(state, "load", arg);
+
+		// the load also sets the size of the tile it goes through
+		get_arg(line->args, 0, arg, sizeof(arg));
+		snprintf(key, sizeof(key), "tilesize:%s", arg);
+		state_forget(state, key);
+		return 0;
+	}
+
+	if (line->type != CMD_RSP && line->type != CMD_RDP)
+		return 0;
+
+	// work out which piece of state the command overwrites as a whole
+	if (strcmp(name, "gsDPSetCombineMode") == 0 || strcmp(name, "gsDPSetCombineLERP") == 0)
+	{
+		snprintf(key, sizeof(key), "combine");
+		snprintf(arg, sizeof(arg), "%s(%s)", name, line->args);
+	}
+	else if (strcmp(name, "gsSPFogPosition") == 0 || strcmp(name, "gsSPFogFactor") == 0)
+	{
+		snprintf(key, sizeof(key), "fog");
+		snprintf(arg, sizeof(arg), "%s(%s)", name, line->args);
+	}
+	else if (strcmp(name, "gsDPSetTextureImage") == 0)
+	{
+		snprintf(key, sizeof(key), "timg");
+		snprintf(arg, sizeof(arg), "%s", line->args);
+	}
+	else if (strcmp(name, "gsDPSetTile") == 0)
+	{
+		get_arg(line->args, 4, arg, sizeof(arg));
+		snprintf(key, sizeof(key), "tile:%s", arg);
+		snprintf(arg, sizeof(arg), "%s", line->args);
+	}
+	else if (strcmp(name, "gsDPSetTileSize") == 0)
+	{
+		get_arg(line->args, 0, arg, sizeof(arg));
+		snprintf(key, sizeof(key), "tilesize:%s", arg);
+		snprintf(arg, sizeof(arg), "%s", line->args);
+	}
+	else if (strcmp(name, "gsSPLightColor") == 0)
+	{
+		get_arg(line->args, 0, arg, sizeof(arg));
+		snprintf(key, sizeof(key), "light:%s", arg);
+		get_arg(line->args, 1, arg, sizeof(arg));
+	}
+	else if (strcmp(name, "gsSPVertex") == 0 || strcmp(name, "gsSPPerspNormalize") == 0)
+	{
+		return 0;
+	}
+	else
+	{
+		snprintf(key, sizeof(key), "%s", name);
+		snprintf(arg, sizeof(arg), "%s", line->args);
+	}
+
+	cur = state_get(state, key);
+	if (cur != NULL && strcmp(cur, arg) == 0)
+		return 1;
+
+	state_set(state, key, arg);
+	// a new texture image or load tile means the next load reads something else
+	if (strcmp(key, "timg") == 0 || strncmp(key, "tile:", 5) == 0)
+		state_forget(state, "load");
+	return 0;
+}
+
+/* Sync removal */
+
+// Returns the type of the first command after index that isn't a sync, RSP command or comment.
+static int next_significant(Line *lines, int index, int end, int stopAt)
+{
+	for (int i = index + 1; i < end; i++)
+	{
+		if (lines[i].removed)
+			continue;
+		if (lines[i].type == stopAt)
+			return stopAt;
+		switch (lines[i].type)
+		{
+			case CMD_NONE:
+			case CMD_RSP:
+			case CMD_PIPESYNC:
+			case CMD_LOADSYNC:
+			case CMD_TILESYNC:
+				continue;
+		}
+		return lines[i].type;
+	}
+	return CMD_BARRIER;
+}
+
+static void remove_syncs(Line *lines, int start, int end)
+{
+	int synced = 0;
+
+	for (int i = start; i < end; i++)
+	{
+		Line *line = &lines[i];
+
+		if (line->removed)
+			continue;
+
+		switch (line->type)
+		{
+			case CMD_PIPESYNC:
+				// nothing was drawn since the last sync, or nothing is changed before the next draw
+				if (synced || next_significant(lines, i, end, -1) == CMD_PRIM)
+					line->removed = 1;
+				else
+					synced = 1;
+				break;
+			case CMD_LOADSYNC:
+			case CMD_TILESYNC:
+			{
+				// only needed ahead of a load or tile change; a later sync of the same kind covers it
+				int next = next_significant(lines, i, end, line->type);
+				if (next == CMD_PRIM || next == line->type)
+					line->removed = 1;
+				break;
+			}
+			case CMD_PRIM:
+			case CMD_LOAD:
+			case CMD_BARRIER:
+				synced = 0;
+				break;
+		}
+	}
+}
+
+/* Triangle merging */
+
+static int merge_triangles(Line *lines, int start, int end)
+{
+	int merged = 0;
+	Line *prev = NULL;
+
+	for (int i = start; i < end; i++)
+	{
+		Line *line = &lines[i];
+
+		if (line->removed)
+			continue;
+
+		if (strcmp(line->name, "gsSP1Triangle") != 0 || line->hasComment || line->replace != NULL)
+		{
+			prev = NULL;
+			continue;
+		}
+
+		if (prev == NULL)
+		{
+			prev = line;
+			continue;
+		}
+
+		{
+			const char *indent = prev->text;
+			size_t indentLen = 0;
+			size_t size;
+
+			while (indent[indentLen] == ' ' || indent[indentLen] == '\t')
+				indentLen++;
+
+			size = indentLen + strlen(prev->rawArgs) + strlen(line->rawArgs) + 32;
+			prev->replace = malloc(size);
+			snprintf(prev->replace, size, "%.*sgsSP2Triangles(%s, %s),\n", (int) indentLen, indent, prev->rawArgs, line->rawArgs);
+			line->removed = 1;
+			merged++;
+			prev = NULL;
+		}
+	}
+	return merged;
+}
+
+/* Parsing */
+
+static char *read_file(const char *filename, long *size)
+{
+	FILE *fp = fopen(filename, "rb");
+	char *data;
+
+	if (fp == NULL)
+	{
+		perror(filename);
+		return NULL;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	*size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	data = malloc(*size + 1);
+	if (fread(data, 1, *size, fp) != (size_t) *size)
+	{
+		fprintf(stderr, "%s: read error\n", filename);
+		fclose(fp);
+		free(data);
+		return NULL;
+	}
+	data[*size] = '\0';
+	fclose(fp);
+	return data;
+}
+
+// Parses one line of a display list. Returns 0 if it isn't a single complete command.
+static int parse_command(Line *line)
+{
+	const char *p = line->text;
+	const char *argStart;
+	int depth = 1;
+	size_t len = 0;
+	size_t rawLen = 0;
+
+	line->name[0] = '\0';
+	line->type = CMD_NONE;
+
+	while (*p == ' ' || *p == '\t')
+		p++;
+	if (*p == '\n' || *p == '\r' || *p == '\0' || strncmp(p, "//", 2) == 0)
+		return 1;
+	if (strncmp(p, "/*", 2) == 0)
+		return strstr(p, "*/") != NULL;
+
+	if (!isalpha((unsigned char) *p) && *p != '_')
+		return 0;
+	while ((isalnum((unsigned char) *p) || *p == '_') && len + 1 < MAX_NAME)
+		line->name[len++] = *p++;
+	line->name[len] = '\0';
+
+	while (*p == ' ' || *p == '\t')
+		p++;
+	if (*p != '(')
+		return 0;
+
+	argStart = ++p;
+	len = 0;
+	for (; *p != '\0' && *p != '\n'; p++)
+	{
+		if (*p == '(')
+			depth++;
+		else if (*p == ')' && --depth == 0)
+			break;
+		if (len + 1 >= MAX_ARGS)
+			return 0;
+		if (!isspace((unsigned char) *p))
+			line->args[len++] = *p;
+	}
+	if (depth != 0)
+		return 0;
+	line->args[len] = '\0';
+
+	// keep the original spacing for merged triangles
+	rawLen = p - argStart;
+	while (rawLen > 0 && isspace((unsigned char) argStart[rawLen - 1]))
+		rawLen--;
+	memcpy(line->rawArgs, argStart, rawLen);
+	line->rawArgs[rawLen] = '\0';
+
+	p++;
+	while (*p == ' ' || *p == '\t')
+		p++;
+	if (*p == ',')
+		p++;
+	while (*p == ' ' || *p == '\t')
+		p++;
+	if (strncmp(p, "//", 2) == 0 || strncmp(p, "/*", 2) == 0)
+		line->hasComment = 1;
+	else if (*p != '\n' && *p != '\r' && *p != '\0')
+		return 0;
+
+	line->type = classify(line->name);
+	return 1;
+}
+
+// Returns the offset of the name if the line starts a `type name[] = {` array, or 0.
+static int parse_array_start(const char *text, const char *type, char *name, size_t nameSize)
+{
+	const char *p = strstr(text, type);
+	const char *nameStart;
+	size_t len;
+
+	if (p == NULL || strchr(text, ';') != NULL || strchr(text, '{') == NULL)
+		return 0;
+	// only storage class and qualifiers may come before the type
+	for (const char *q = text; q < p; q++)
+	{
+		if (!isalpha((unsigned char) *q) && !isspace((unsigned char) *q))
+			return 0;
+	}
+
+	p += strlen(type);
+	while (*p == ' ')
+		p++;
+	nameStart = p;
+	while (isalnum((unsigned char) *p) || *p == '_')
+		p++;
+	len = p - nameStart;
+	if (len == 0 || len >= nameSize || *p != '[')
+		return 0;
+
+	memcpy(name, nameStart, len);
+	name[len] = '\0';
+	return nameStart - text;
+}
+
+// Whether name appears in text as a whole identifier.
+static int references(const char *text, const char *name)
+{
+	size_t len = strlen(name);
+
+	for (const char *p = strstr(text, name); p != NULL; p = strstr(p + 1, name))
+	{
+		if ((p > text && (isalnum((unsigned char) p[-1]) || p[-1] == '_')) || isalnum((unsigned char) p[len]) || p[len] == '_')
+			continue;
+		return 1;
+	}
+	return 0;
+}
+
+// Lists that are used from an offset into them can't assume anything at their start either.
+static int referenced_inside(const char *data, const char *name)
+{
+	size_t len = strlen(name);
+
+	for (const char *p = strstr(data, name); p != NULL; p = strstr(p + 1, name))
+	{
+		const char *q = p + len;
+
+		if ((p > data && (isalnum((unsigned char) p[-1]) || p[-1] == '_')) || isalnum((unsigned char) *q) || *q == '_')
+			continue;
+		while (*q == ' ')
+			q++;
+		if (*q == '+' || (*q == '[' && q[1] != ']'))
+			return 1;
+	}
+	return 0;
+}
+
+static int parse_int(const char *text, int *value)
+{
+	char *end;
+
+	*value = strtol(text, &end, 0);
+	return end != text && *end == '\0';
+}
+
+static char *copy_string(const char *text, size_t len)
+{
+	char *copy = malloc(len + 1);
+
+	memcpy(copy, text, len);
+	copy[len] = '\0';
+	return copy;
+}
+
+/* Vertex re-batching */
+
+typedef struct
+{
+	char *key;  // the vertex without whitespace
+	char *text; // the vertex as written
+} Vertex;
+
+typedef struct
+{
+	char name[MAX_NAME];
+	char decl[MAX_NAME];  // everything in front of the name
+	int firstLine;
+	int lastLine;         // the closing brace
+	Vertex *vertices;
+	int count;            // -1 if the array couldn't be read
+	int rebatched;        // a group that was rebatched loaded from it
+} VtxArray;
+
+typedef struct
+{
+	const Vertex *v[3];
+	char flag[MAX_NAME];
+	int done;
+} Triangle;
+
+// a run of vertex loads and triangles, with nothing else in between
+typedef struct
+{
+	int start;     // first line
+	int end;       // one past the last line
+	int valid;
+	int loads;
+	int vertices;
+	int commands;
+	Triangle *tris;
+	int numTris;
+} Group;
+
+typedef struct
+{
+	const Vertex *vertices[MAX_BUFFER];
+	int numVertices;
+	int firstTri;  // in the order the triangles were placed
+	int numTris;
+} Batch;
+
+typedef struct
+{
+	char *text;
+	size_t len;
+	size_t cap;
+} String;
+
+static void string_add(String *str, const char *fmt, ...)
+{
+	va_list args;
+	int needed;
+
+	va_start(args, fmt);
+	needed = vsnprintf(NULL, 0, fmt, args);
+	va_end(args);
+
+	if (str->len + needed + 1 > str->cap)
+	{
+		str->cap = (str->len + needed + 1) * 2;
+		str->text = realloc(str->text, str->cap);
+	}
+
+	va_start(args, fmt);
+	vsnprintf(str->text + str->len, needed + 1, fmt, args);
+	va_end(args);
+	str->len += needed;
+}
+
+static int is_geometry(const Line *line)
+{
+	return strcmp(line->name, "gsSPVertex") == 0
+	    || strcmp(line->name, "gsSP1Triangle") == 0
+	    || strcmp(line->name, "gsSP2Triangles") == 0;
+}
+
+static int same_vertex(const Vertex *a, const Vertex *b)
+{
+	return a == b || strcmp(a->key, b->key) == 0;
+}
+
+// Reads every Vtx array in the file. Each vertex has to be on a line of its own.
+static VtxArray *parse_vtx_arrays(Line *lines, int numLines, int *numArrays)
+{
+	VtxArray *arrays = NULL;
+
+	*numArrays = 0;
+	for (int i = 0; i < numLines; i++)
+	{
+		VtxArray *arr;
+		char name[MAX_NAME];
+		int nameOffset = parse_array_start(lines[i].text, "Vtx ", name, sizeof(name));
+		int j;
+
+		if (nameOffset == 0 || nameOffset >= MAX_NAME)
+			continue;
+
+		arrays = realloc(arrays, (*numArrays + 1) * sizeof(*arrays));
+		arr = &arrays[(*numArrays)++];
+		memset(arr, 0, sizeof(*arr));
+		snprintf(arr->name, sizeof(arr->name), "%s", name);
+		snprintf(arr->decl, sizeof(arr->decl), "%.*s", nameOffset, lines[i].text);
+		arr->firstLine = i;
+		arr->vertices = malloc((numLines - i) * sizeof(*arr->vertices));
+
+		for (j = i + 1; j < numLines; j++)
+		{
+			const char *t = lines[j].text;
+			size_t len;
+			size_t keyLen = 0;
+			char *key;
+
+			while (isspace((unsigned char) *t))
+				t++;
+			if (strncmp(t, "};", 2) == 0)
+				break;
+			if (arr->count < 0)
+				continue;
+
+			len = strlen(t);
+			while (len > 0 && isspace((unsigned char) t[len - 1]))
+				len--;
+			if (len > 0 && t[len - 1] == ',')
+				len--;
+			if (len == 0 || t[0] != '{' || t[len - 1] != '}' || strstr(t, "//") != NULL || strstr(t, "/*") != NULL)
+			{
+				arr->count = -1;
+				continue;
+			}
+
+			key = malloc(len + 1);
+			for (size_t k = 0; k < len; k++)
+			{
+				if (!isspace((unsigned char) t[k]))
+					key[keyLen++] = t[k];
+			}
+			key[keyLen] = '\0';
+
+			arr->vertices[arr->count].key = key;
+			arr->vertices[arr->count].text = copy_string(t, len);
+			arr->count++;
+		}
+
+		if (j >= numLines)
+			arr->count = -1;
+		arr->lastLine = j;
+		i = j;
+	}
+	return arrays;
+}
+
+static void free_vtx_arrays(VtxArray *arrays, int numArrays)
+{
+	for (int i = 0; i < numArrays; i++)
+	{
+		for (int j = 0; j < arrays[i].count; j++)
+		{
+			free(arrays[i].vertices[j].key);
+			free(arrays[i].vertices[j].text);
+		}
+		free(arrays[i].vertices);
+	}
+	free(arrays);
+}
+
+// Finds the array and offset a gsSPVertex pointer refers to: `name`, `&name[n]` or `name + n`.
+static VtxArray *resolve_vertices(const char *ptr, VtxArray *arrays, int numArrays, int *offset)
+{
+	char name[MAX_NAME];
+	const char *p = ptr;
+	size_t len = 0;
+	char *end;
+
+	*offset = 0;
+	if (*p == '&')
+		p++;
+	while ((isalnum((unsigned char) *p) || *p == '_') && len + 1 < MAX_NAME)
+		name[len++] = *p++;
+	name[len] = '\0';
+
+	if (ptr[0] == '&')
+	{
+		if (*p != '[')
+			return NULL;
+		*offset = strtol(p + 1, &end, 0);
+		if (end == p + 1 || strcmp(end, "]") != 0)
+			return NULL;
+	}
+	else if (*p == '+')
+	{
+		*offset = strtol(p + 1, &end, 0);
+		if (end == p + 1 || *end != '\0')
+			return NULL;
+	}
+	else if (*p != '\0')
+	{
+		return NULL;
+	}
+
+	for (int i = 0; i < numArrays; i++)
+	{
+		if (arrays[i].count >= 0 && strcmp(arrays[i].name, name) == 0)
+			return &arrays[i];
+	}
+	return NULL;
+}
+
+// Follows the vertex buffer through a list and splits it into groups. A group can only be
+// rebatched if it starts with a load, every vertex it draws is known, and no later group draws
+// with vertices it left in the buffer. Returns -1 if the list draws with vertices loaded by
+// whatever called it, or with loads or triangles that can't be followed.
+static int find_groups(Line *lines, int start, int end, VtxArray *arrays, int numArrays, Group *groups, int *numGroups)
+{
+	const Vertex *slots[MAX_BUFFER];
+	int owner[MAX_BUFFER];
+	Group *cur = NULL;
+
+	*numGroups = 0;
+	for (int i = 0; i < MAX_BUFFER; i++)
+	{
+		slots[i] = NULL;
+		owner[i] = -1;
+	}
+
+	for (int i = start; i < end; i++)
+	{
+		Line *line = &lines[i];
+		char arg[MAX_ARGS];
+		int numArgs;
+		int g;
+
+		if (!is_geometry(line))
+		{
+			// commands removed by the other passes are gone, anything else splits the group
+			if (!line->removed)
+				cur = NULL;
+			continue;
+		}
+
+		if (cur == NULL)
+		{
+			cur = &groups[(*numGroups)++];
+			memset(cur, 0, sizeof(*cur));
+			cur->start = i;
+			cur->valid = strcmp(line->name, "gsSPVertex") == 0;
+			cur->tris = malloc((end - i) * 2 * sizeof(*cur->tris));
+		}
+		g = cur - groups;
+		cur->end = i + 1;
+		if (!line->removed)
+			cur->commands++;
+
+		numArgs = get_arg(line->args, 0, arg, sizeof(arg));
+		if (strcmp(line->name, "gsSPVertex") == 0)
+		{
+			int offset, n, v0;
+			VtxArray *arr = resolve_vertices(arg, arrays, numArrays, &offset);
+
+			get_arg(line->args, 1, arg, sizeof(arg));
+			if (numArgs != 3 || !parse_int(arg, &n))
+				return -1;
+			get_arg(line->args, 2, arg, sizeof(arg));
+			if (!parse_int(arg, &v0) || n <= 0 || v0 < 0 || v0 + n > MAX_BUFFER)
+				return -1;
+			if (arr == NULL || offset < 0 || offset + n > arr->count)
+			{
+				arr = NULL;
+				cur->valid = 0;
+			}
+
+			for (int k = 0; k < n; k++)
+			{
+				slots[v0 + k] = arr != NULL ? &arr->vertices[offset + k] : NULL;
+				owner[v0 + k] = g;
+			}
+			cur->loads++;
+			cur->vertices += n;
+		}
+		else
+		{
+			if (numArgs != 4 && numArgs != 8)
+				return -1;
+
+			for (int t = 0; t < numArgs / 4; t++)
+			{
+				Triangle *tri = &cur->tris[cur->numTris++];
+
+				for (int k = 0; k < 3; k++)
+				{
+					int index;
+
+					get_arg(line->args, t * 4 + k, arg, sizeof(arg));
+					if (!parse_int(arg, &index) || index < 0 || index >= MAX_BUFFER || owner[index] < 0)
+						return -1;
+					// the group that loaded this vertex has to leave the buffer as it is
+					if (owner[index] != g)
+						groups[owner[index]].valid = 0;
+					if (slots[index] == NULL)
+						cur->valid = 0;
+					tri->v[k] = slots[index];
+				}
+				get_arg(line->args, t * 4 + 3, tri->flag, sizeof(tri->flag));
+				tri->done = 0;
+			}
+		}
+	}
+	return 0;
+}
+
+static int find_in_batch(const Batch *batch, const Vertex *v)
+{
+	for (int i = 0; i < batch->numVertices; i++)
+	{
+		if (same_vertex(batch->vertices[i], v))
+			return i;
+	}
+	return -1;
+}
+
+// Number of vertices a triangle would add to a batch.
+static int new_vertices(const Batch *batch, const Triangle *tri)
+{
+	int count = 0;
+
+	for (int k = 0; k < 3; k++)
+	{
+		if (find_in_batch(batch, tri->v[k]) >= 0)
+			continue;
+		if ((k > 0 && same_vertex(tri->v[k], tri->v[0])) || (k > 1 && same_vertex(tri->v[k], tri->v[1])))
+			continue;
+		count++;
+	}
+	return count;
+}
+
+// Packs the triangles of a group into as few loads as fit in the vertex buffer, each vertex loaded
+// once per batch. The triangles keep their order, unless reordering is allowed, in which case each
+// batch takes the triangle that adds the fewest vertices next. order receives the triangles in
+// the order they were placed.
+static Batch *make_batches(Group *group, int *order, int *numBatches)
+{
+	Batch *batches = malloc(group->numTris * sizeof(*batches));
+	int placed = 0;
+
+	*numBatches = 0;
+	while (placed < group->numTris)
+	{
+		Batch *batch = &batches[(*numBatches)++];
+
+		batch->numVertices = 0;
+		batch->firstTri = placed;
+		batch->numTris = 0;
+
+		while (placed < group->numTris)
+		{
+			int best = -1;
+			int bestNew = 4;
+
+			for (int i = 0; i < group->numTris; i++)
+			{
+				int count;
+
+				if (group->tris[i].done)
+					continue;
+
+				count = new_vertices(batch, &group->tris[i]);
+				if (batch->numVertices + count <= bufferSize && count < bestNew)
+				{
+					best = i;
+					bestNew = count;
+				}
+				// without reordering only the next triangle can go in
+				if (!reorder || bestNew == 0)
+					break;
+			}
+			if (best < 0)
+				break;
+
+			for (int k = 0; k < 3; k++)
+			{
+				if (find_in_batch(batch, group->tris[best].v[k]) < 0)
+					batch->vertices[batch->numVertices++] = group->tris[best].v[k];
+			}
+			group->tris[best].done = 1;
+			order[placed++] = best;
+			batch->numTris++;
+		}
+	}
+	return batches;
+}
+
+// Whether a vertex load or triangle uses vertex buffer entries past the end of the buffer being
+// rebatched for, like loads written for a larger buffer by an earlier run.
+static int overflows_buffer(const Line *line)
+{
+	char arg[MAX_ARGS];
+	int numArgs = get_arg(line->args, 0, arg, sizeof(arg));
+	int n, v0, index;
+
+	if (strcmp(line->name, "gsSPVertex") == 0)
+	{
+		if (numArgs != 3)
+			return 0;
+		get_arg(line->args, 1, arg, sizeof(arg));
+		if (!parse_int(arg, &n))
+			return 0;
+		get_arg(line->args, 2, arg, sizeof(arg));
+		return parse_int(arg, &v0) && v0 + n > bufferSize;
+	}
+	if (strcmp(line->name, "gsSP1Triangle") == 0 || strcmp(line->name, "gsSP2Triangles") == 0)
+	{
+		for (int i = 0; i < numArgs; i++)
+		{
+			// every fourth argument is a flag
+			get_arg(line->args, i, arg, sizeof(arg));
+			if (i % 4 != 3 && parse_int(arg, &index) && index >= bufferSize)
+				return 1;
+		}
+	}
+	return 0;
+}
+
+// Rebatches the groups of one list. The new vertex arrays go in front of the list.
+static void rebatch_list(Line *lines, int declLine, int start, int end, const char *listName, const char *data,
+                         VtxArray *arrays, int numArrays, Stats *stats)
+{
+	Group *groups = malloc((end - start) * sizeof(*groups));
+	String vtxText = { NULL, 0, 0 };
+	int numGroups;
+	int arrayIndex = 0;
+
+	if (find_groups(lines, start, end, arrays, numArrays, groups, &numGroups) < 0)
+		numGroups = 0;
+
+	for (int g = 0; g < numGroups; g++)
+	{
+		Group *group = &groups[g];
+		String dlText = { NULL, 0, 0 };
+		const char *indent = lines[group->start].text;
+		int indentLen = strspn(indent, " \t");
+		int *order;
+		Batch *batches;
+		char (*names)[MAX_NAME * 2];
+		int numBatches;
+		int vertices = 0;
+		int commands = 0;
+		int nextIndex = arrayIndex;
+		int overflow = 0;
+		VtxArray *first = NULL;
+		int offset;
+		char arg[MAX_ARGS];
+
+		stats->loadsBefore += group->loads;
+		stats->verticesBefore += group->vertices;
+
+		if (!group->valid || group->numTris == 0)
+		{
+			stats->loadsAfter += group->loads;
+			stats->verticesAfter += group->vertices;
+			continue;
+		}
+
+		order = malloc(group->numTris * sizeof(*order));
+		batches = make_batches(group, order, &numBatches);
+		names = malloc(numBatches * sizeof(*names));
+		for (int b = 0; b < numBatches; b++)
+		{
+			// skip names already in the file, like the arrays an earlier run wrote
+			do
+				snprintf(names[b], sizeof(names[b]), "%s_vtx_%d", listName, nextIndex++);
+			while (references(data, names[b]));
+			vertices += batches[b].numVertices;
+			commands += 1 + (batches[b].numTris + 1) / 2;
+		}
+
+		get_arg(lines[group->start].args, 0, arg, sizeof(arg));
+		first = resolve_vertices(arg, arrays, numArrays, &offset);
+
+		for (int i = group->start; i < group->end; i++)
+		{
+			if (!lines[i].removed && overflows_buffer(&lines[i]))
+				overflow = 1;
+		}
+
+		// only take it if it's no worse in any way, unless the old loads don't fit in the buffer
+		if (!overflow && (numBatches > group->loads || vertices > group->vertices || commands > group->commands
+		                  || (numBatches == group->loads && vertices == group->vertices)))
+		{
+			stats->loadsAfter += group->loads;
+			stats->verticesAfter += group->vertices;
+			free(order);
+			free(batches);
+			free(names);
+			continue;
+		}
+		arrayIndex = nextIndex;
+
+		for (int b = 0; b < numBatches; b++)
+		{
+			Batch *batch = &batches[b];
+			const char *name = names[b];
+
+			string_add(&vtxText, "%s%s[] = {\n", first->decl, name);
+			for (int v = 0; v < batch->numVertices; v++)
+				string_add(&vtxText, "    %s,\n", batch->vertices[v]->text);
+			string_add(&vtxText, "};\n\n");
+
+			string_add(&dlText, "%.*sgsSPVertex(%s, %d, 0),\n", indentLen, indent, name, batch->numVertices);
+			for (int t = 0; t < batch->numTris; t += 2)
+			{
+				const Triangle *a = &group->tris[order[batch->firstTri + t]];
+
+				if (t + 1 < batch->numTris)
+				{
+					const Triangle *b = &group->tris[order[batch->firstTri + t + 1]];
+
+					string_add(&dlText, "%.*sgsSP2Triangles(%2d, %2d, %2d, %s, %2d, %2d, %2d, %s),\n", indentLen, indent,
+					           find_in_batch(batch, a->v[0]), find_in_batch(batch, a->v[1]), find_in_batch(batch, a->v[2]), a->flag,
+					           find_in_batch(batch, b->v[0]), find_in_batch(batch, b->v[1]), find_in_batch(batch, b->v[2]), b->flag);
+				}
+				else
+				{
+					string_add(&dlText, "%.*sgsSP1Triangle(%2d, %2d, %2d, %s),\n", indentLen, indent,
+					           find_in_batch(batch, a->v[0]), find_in_batch(batch, a->v[1]), find_in_batch(batch, a->v[2]), a->flag);
+				}
+			}
+		}
+
+		// mark every array the old loads read from, so unused ones can be dropped
+		for (int i = group->start; i < group->end; i++)
+		{
+			if (strcmp(lines[i].name, "gsSPVertex") == 0)
+			{
+				VtxArray *arr;
+
+				get_arg(lines[i].args, 0, arg, sizeof(arg));
+				arr = resolve_vertices(arg, arrays, numArrays, &offset);
+				arr->rebatched = 1;
+			}
+			if (i > group->start)
+				lines[i].removed = 1;
+		}
+		free(lines[group->start].replace);
+		lines[group->start].replace = dlText.text;
+		lines[group->start].removed = 0;
+
+		stats->loadsAfter += numBatches;
+		stats->verticesAfter += vertices;
+		stats->bytes += (group->commands - commands) * 8;
+		stats->rebatched++;
+
+		free(order);
+		free(batches);
+		free(names);
+	}
+
+	// keep the address comment above the list next to it
+	if (declLine > 0 && strncmp(lines[declLine - 1].text, "//", 2) == 0)
+		declLine--;
+	if (vtxText.text != NULL)
+		lines[declLine].prefix = vtxText.text;
+
+	for (int g = 0; g < numGroups; g++)
+		free(groups[g].tris);
+	free(groups);
+}
+
+// Drops static vertex arrays that nothing refers to any more, with the address comment above them.
+static void remove_unused_arrays(Line *lines, int numLines, VtxArray *arrays, int numArrays)
+{
+	for (int a = 0; a < numArrays; a++)
+	{
+		VtxArray *arr = &arrays[a];
+		int used = 0;
+
+		if (!arr->rebatched || strstr(arr->decl, "static") == NULL)
+			continue;
+
+		for (int i = 0; i < numLines && !used; i++)
+		{
+			if (i >= arr->firstLine && i <= arr->lastLine)
+				continue;
+			if (lines[i].prefix != NULL && references(lines[i].prefix, arr->name))
+				used = 1;
+			if (!lines[i].removed && references(lines[i].replace != NULL ? lines[i].replace : lines[i].text, arr->name))
+				used = 1;
+		}
+		if (used)
+			continue;
+
+		for (int i = arr->firstLine; i <= arr->lastLine; i++)
+			lines[i].removed = 1;
+		if (arr->firstLine > 0 && strncmp(lines[arr->firstLine - 1].text, "//", 2) == 0)
+			lines[arr->firstLine - 1].removed = 1;
+		if (arr->lastLine + 1 < numLines && strspn(lines[arr->lastLine + 1].text, " \t\r\n") == strlen(lines[arr->lastLine + 1].text))
+			lines[arr->lastLine + 1].removed = 1;
+	}
+}
+
+/* Files */
+
+typedef struct
+{
+	char name[MAX_NAME];
+	int declLine;
+	int start;
+	int end;
+} ListRange;
+
+static int optimize_file(const char *filename, int write, Stats *total)
+{
+	Stats fileStats;
+	Line *lines;
+	ListRange *lists;
+	VtxArray *arrays = NULL;
+	int numLines = 0;
+	int numLists = 0;
+	int numArrays = 0;
+	int rebatch = bufferSize > 0;
+	int failed = 0;
+	long size;
+	char *data = read_file(filename, &size);
+	char *copy;
+	char *p;
+
+	if (data == NULL)
+		return 1;
+
+	memset(&fileStats, 0, sizeof(fileStats));
+	copy = malloc(size + 1);
+	memcpy(copy, data, size + 1);
+
+	for (long i = 0; i < size; i++)
+	{
+		if (data[i] == '\n')
+			numLines++;
+	}
+	lines = calloc(numLines + 1, sizeof(*lines));
+	lists = malloc((numLines + 1) * sizeof(*lists));
+
+	numLines = 0;
+	p = copy;
+	while (*p != '\0')
+	{
+		char *eol = strchr(p, '\n');
+		char *next = eol ? eol + 1 : p + strlen(p);
+
+		lines[numLines++].text = copy_string(p, next - p);
+		p = next;
+	}
+
+	// find every list that is safe to change
+	for (int i = 0; i < numLines; i++)
+	{
+		ListRange *list = &lists[numLists];
+		int safe = 1;
+
+		if (!parse_array_start(lines[i].text, "Gfx ", list->name, sizeof(list->name)))
+			continue;
+
+		list->declLine = i;
+		list->start = i + 1;
+		for (list->end = list->start; list->end < numLines; list->end++)
+		{
+			const char *t = lines[list->end].text;
+
+			while (*t == ' ' || *t == '\t')
+				t++;
+			if (*t == '}')
+				break;
+			if (*t == '#' || !parse_command(&lines[list->end]))
+				safe = 0;
+		}
+		i = list->end;
+
+		if (list->end < numLines && safe && !referenced_inside(data, list->name))
+			numLists++;
+	}
+
+	if (rebatch)
+	{
+		Group *groups = malloc(numLines * sizeof(*groups));
+
+		arrays = parse_vtx_arrays(lines, numLines, &numArrays);
+
+		// if any list draws with vertices its caller loaded, the buffer has to be left alone
+		for (int l = 0; l < numLists && rebatch; l++)
+		{
+			int numGroups;
+
+			if (find_groups(lines, lists[l].start, lists[l].end, arrays, numArrays, groups, &numGroups) < 0)
+				rebatch = 0;
+			for (int g = 0; g < numGroups; g++)
+				free(groups[g].tris);
+		}
+		free(groups);
+	}
+
+	for (int l = 0; l < numLists; l++)
+	{
+		ListRange *list = &lists[l];
+		Stats listStats;
+		State state;
+
+		memset(&listStats, 0, sizeof(listStats));
+		listStats.lists = 1;
+
+		state.count = 0;
+		for (int j = list->start; j < list->end; j++)
+		{
+			if (lines[j].type != CMD_NONE && update_state(&state, &lines[j]))
+				lines[j].removed = 1;
+		}
+		remove_syncs(lines, list->start, list->end);
+		listStats.merged = merge_triangles(lines, list->start, list->end);
+
+		for (int j = list->start; j < list->end; j++)
+		{
+			if (lines[j].removed)
+			{
+				listStats.bytes += command_words(lines[j].name) * 8;
+				listStats.removed++;
+			}
+		}
+		// merged triangles are counted above as removed commands, but not as optimized state
+		listStats.removed -= listStats.merged;
+
+		if (rebatch)
+			rebatch_list(lines, list->declLine, list->start, list->end, list->name, data, arrays, numArrays, &listStats);
+
+		if (verbose && (listStats.bytes != 0 || listStats.rebatched > 0))
+		{
+			printf("  %-48s %4d commands removed, %4d triangle pairs merged, %5d bytes saved",
+			       list->name, listStats.removed, listStats.merged, listStats.bytes);
+			if (bufferSize > 0)
+				printf(", %d -> %d vertex loads", listStats.loadsBefore, listStats.loadsAfter);
+			printf("\n");
+		}
+
+		fileStats.lists++;
+		fileStats.removed += listStats.removed;
+		fileStats.merged += listStats.merged;
+		fileStats.bytes += listStats.bytes;
+		fileStats.rebatched += listStats.rebatched;
+		fileStats.loadsBefore += listStats.loadsBefore;
+		fileStats.loadsAfter += listStats.loadsAfter;
+		fileStats.verticesBefore += listStats.verticesBefore;
+		fileStats.verticesAfter += listStats.verticesAfter;
+	}
+
+	if (fileStats.rebatched > 0)
+		remove_unused_arrays(lines, numLines, arrays, numArrays);
+
+	// anything still too big for the buffer couldn't be rebatched, and would break the microcode
+	for (int i = 0; i < numLines && bufferSize > 0; i++)
+	{
+		if (!lines[i].removed && lines[i].replace == NULL && overflows_buffer(&lines[i]))
+		{
+			fprintf(stderr, "%s:%d: %s uses vertex buffer entries past %d and can't be rebatched\n", filename, i + 1,
+			        lines[i].name, bufferSize);
+			failed = 1;
+		}
+	}
+
+	if (fileStats.bytes != 0 || fileStats.rebatched > 0)
+	{
+		printf("%s: %d display lists, %d commands removed, %d triangle pairs merged, %d bytes saved",
+		       filename, fileStats.lists, fileStats.removed, fileStats.merged, fileStats.bytes);
+		if (bufferSize > 0)
+		{
+			printf(", %d -> %d vertex loads, %d -> %d vertices", fileStats.loadsBefore, fileStats.loadsAfter,
+			       fileStats.verticesBefore, fileStats.verticesAfter);
+		}
+		printf("\n");
+
+		if (write && !failed)
+		{
+			FILE *fp = fopen(filename, "wb");
+
+			if (fp == NULL)
+			{
+				perror(filename);
+				return 1;
+			}
+			for (int i = 0; i < numLines; i++)
+			{
+				if (lines[i].prefix != NULL)
+					fputs(lines[i].prefix, fp);
+				if (lines[i].removed)
+					continue;
+				fputs(lines[i].replace != NULL ? lines[i].replace : lines[i].text, fp);
+			}
+			fclose(fp);
+		}
+	}
+
+	total->lists += fileStats.lists;
+	total->removed += fileStats.removed;
+	total->merged += fileStats.merged;
+	total->bytes += fileStats.bytes;
+	total->loadsBefore += fileStats.loadsBefore;
+	total->loadsAfter += fileStats.loadsAfter;
+	total->verticesBefore += fileStats.verticesBefore;
+	total->verticesAfter += fileStats.verticesAfter;
+
+	for (int i = 0; i < numLines; i++)
+	{
+		free(lines[i].text);
+		free(lines[i].replace);
+		free(lines[i].prefix);
+	}
+	free_vtx_arrays(arrays, numArrays);
+	free(lines);
+	free(lists);
+	free(copy);
+	free(data);
+	return failed;
+}
+
+int main(int argc, const char **argv)
+{
+	Stats total;
+	int write = 1;
+	int failed = 0;
+	int arg = 1;
+
+	for (; arg < argc && argv[arg][0] == '-'; arg++)
+	{
+		if (strcmp(argv[arg], "-n") == 0)
+			write = 0;
+		else if (strcmp(argv[arg], "-v") == 0)
+			verbose = 1;
+		else if (strcmp(argv[arg], "-r") == 0)
+			reorder = 1;
+		else if (strcmp(argv[arg], "-b") == 0 && arg + 1 < argc)
+			bufferSize = atoi(argv[++arg]);
+		else
+			break;
+	}
+
+	if (arg >= argc || (bufferSize != 0 && (bufferSize < 3 || bufferSize > MAX_BUFFER)))
+	{
+		fprintf(stderr, "gfxopt [-n] [-v] [-b vertex buffer size [-r]] file...\n");
+		return 1;
+	}
+
+	memset(&total, 0, sizeof(total));
+	for (; arg < argc; arg++)
+		failed |= optimize_file(argv[arg], write, &total);
+
+	printf("total: %d display lists, %d commands removed, %d triangle pairs merged, %d bytes saved",
+	       total.lists, total.removed, total.merged, total.bytes);
+	if (bufferSize > 0)
+	{
+		printf(", %d -> %d vertex loads, %d -> %d vertices", total.loadsBefore, total.loadsAfter,
+		       total.verticesBefore, total.verticesAfter);
+	}
+	printf("\n");
+
+	return failed;
+}
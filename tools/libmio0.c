@@ -9,6 +9,11 @@
 #include "libmio0.h"
 #include "utils.h"
 
+#ifdef MIO0_STANDALONE
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 // defines
 
 #define MIO0_VERSION "0.1"
@@ -18,43 +23,54 @@
 // types
 typedef struct
 {
-   int *indexes;
-   int allocated;
-   int count;
-   int start;
-} lookback;
+   const unsigned char *buf;
+   int length;
+   int *head; // most recent position of each hash of 3 bytes, or -1
+   int *prev; // previous position with the same hash, indexed by position % WINDOW_SIZE
+   int inserted; // every position before this has been inserted
+} match_finder;
 
 // functions
-#define LOOKBACK_COUNT 256
-#define LOOKBACK_INIT_SIZE 128
-static lookback *lookback_init(void)
+#define WINDOW_SIZE 4096
+#define MIN_MATCH 3
+#define HASH_BITS 13
+#define HASH_SIZE (1 << HASH_BITS)
+
+static inline unsigned int hash3(const unsigned char *p)
 {
-   lookback *lb = malloc(LOOKBACK_COUNT * sizeof(*lb));
-   for (int i = 0; i < LOOKBACK_COUNT; i++) {
-      lb[i].allocated = LOOKBACK_INIT_SIZE;
-      lb[i].indexes = malloc(lb[i].allocated * sizeof(*lb[i].indexes));
-      lb[i].count = 0;
-      lb[i].start = 0;
-   }
-   return lb;
+   unsigned int val = (p[0] << 16) | (p[1] << 8) | p[2];
+   return (val * 2654435761U) >> (32 - HASH_BITS);
 }
 
-static void lookback_free(lookback *lb)
+static void match_finder_init(match_finder *mf, const unsigned char *buf, int length)
 {
-   for (int i = 0; i < LOOKBACK_COUNT; i++) {
-      free(lb[i].indexes);
+   mf->buf = buf;
+   mf->length = length;
+   mf->head = malloc(HASH_SIZE * sizeof(*mf->head));
+   mf->prev = malloc(WINDOW_SIZE * sizeof(*mf->prev));
+   mf->inserted = 0;
+   for (int i = 0; i < HASH_SIZE; i++) {
+      mf->head[i] = -1;
    }
-   free(lb);
 }
 
-static inline void lookback_push(lookback *lkbk, unsigned char val, int index)
+static void match_finder_free(match_finder *mf)
 {
-   lookback *lb = &lkbk[val];
-   if (lb->count == lb->allocated) {
-      lb->allocated *= 4;
-      lb->indexes = realloc(lb->indexes, lb->allocated * sizeof(*lb->indexes));
-   }
-   lb->indexes[lb->count++] = index;
+   free(mf->head);
+   free(mf->prev);
+}
+
+// insert every position up to (not including) end into the hash chains
+static inline void match_finder_insert(match_finder *mf, int end)
+{
+   // only positions with a full 3 bytes after them can start a match
+   int last = MIN(end, mf->length - (MIN_MATCH - 1));
+   for (int pos = mf->inserted; pos < last; pos++) {
+      unsigned int h = hash3(&mf->buf[pos]);
+      mf->prev[pos % WINDOW_SIZE] = mf->head[h];
+      mf->head[h] = pos;
+   }
+   mf->inserted = MAX(mf->inserted, end);
 }
 
 static void PUT_BIT(unsigned char *buf, int bit, int val)
@@ -70,16 +86,11 @@ static void PUT_BIT(unsigned char *buf, int bit, int val)
 // max_search: max number of bytes to find
 // found_offset: returned offset found (0 if none found)
 // returns max length of matching stream (0 if none found)
-static int find_longest(const unsigned char *buf, int start_offset, int max_search, int *found_offset, lookback *lkbk)
+static int find_longest(const unsigned char *buf, int start_offset, int max_search, int *found_offset, match_finder *mf)
 {
    int best_length = 0;
    int best_offset = 0;
-   int cur_length;
-   int search_len;
    int farthest, off, i;
-   int lb_idx;
-   const unsigned char first = buf[start_offset];
-   lookback *lb = &lkbk[first];
 
    // buf
    //  |    off        start                  max
@@ -87,39 +98,39 @@ static int find_longest(const unsigned char *buf, int start_offset, int max_sear
    //  |--------------raw-data-----------------|
    //        |+i->       |      |+i->
    //                       +cur_length
+   // matches may run past start, which the decoder handles by copying one byte at a time
+
+   match_finder_insert(mf, start_offset);
+   *found_offset = 0;
+   if (max_search < MIN_MATCH) {
+      return 0;
+   }
 
-   // check at most the past 4096 values
-   farthest = MAX(start_offset - 4096, 0);
-   // find starting index
-   for (lb_idx = lb->start; lb_idx < lb->count && lb->indexes[lb_idx] < farthest; lb_idx++) {}
-   lb->start = lb_idx;
-   for ( ; lb_idx < lb->count && lb->indexes[lb_idx] < start_offset; lb_idx++) {
-      off = lb->indexes[lb_idx];
-      // check at most requested max or up until start
-      search_len = MIN(max_search, start_offset - off);
-      for (i = 0; i < search_len; i++) {
+   // check at most the past 4096 values, walking the chain of positions that share the next 3 bytes' hash
+   farthest = MAX(start_offset - WINDOW_SIZE, 0);
+   for (off = mf->head[hash3(&buf[start_offset])]; off >= farthest && off < start_offset; off = mf->prev[off % WINDOW_SIZE]) {
+      // can't beat the best match unless the byte after it matches too
+      if (buf[off + best_length] != buf[start_offset + best_length]) {
+         continue;
+      }
+      for (i = 0; i < max_search; i++) {
          if (buf[start_offset + i] != buf[off + i]) {
             break;
          }
       }
-      cur_length = i;
-      // if matched up until start, continue matching in already matched parts
-      if (cur_length == search_len) {
-         // check at most requested max less current length
-         search_len = max_search - cur_length;
-         for (i = 0; i < search_len; i++) {
-            if (buf[start_offset + cur_length + i] != buf[off + i]) {
-               break;
-            }
-         }
-         cur_length += i;
-      }
-      if (cur_length > best_length) {
+      if (i > best_length) {
          best_offset = start_offset - off;
-         best_length = cur_length;
+         best_length = i;
+         if (best_length == max_search) {
+            break;
+         }
       }
    }
 
+   if (best_length < MIN_MATCH) {
+      return 0;
+   }
+
    // return best reverse offset and length (may be 0)
    *found_offset = best_offset;
    return best_length;
@@ -206,10 +217,10 @@ int mio0_encode(const unsigned char *in, unsigned int length, unsigned char *out
    int bit_idx = 0;
    int comp_idx = 0;
    int uncomp_idx = 0;
-   lookback *lookbacks;
+   match_finder mf;
 
-   // initialize lookback buffer
-   lookbacks = lookback_init();
+   // initialize hash chains
+   match_finder_init(&mf, in, length);
 
    // allocate some temporary buffers worst case size
    bit_buf = malloc((length + 7) / 8); // 1-bit/byte
@@ -219,7 +230,6 @@ int mio0_encode(const unsigned char *in, unsigned int length, unsigned char *out
 
    // encode data
    // special case for first byte
-   lookback_push(lookbacks, in[0], 0);
    uncomp_buf[uncomp_idx] = in[0];
    uncomp_idx += 1;
    bytes_proc += 1;
@@ -227,14 +237,12 @@ int mio0_encode(const unsigned char *in, unsigned int length, unsigned char *out
    while (bytes_proc < length) {
       int offset;
       int max_length = MIN(length - bytes_proc, 18);
-      int longest_match = find_longest(in, bytes_proc, max_length, &offset, lookbacks);
-      // push current byte before checking next longer match
-      lookback_push(lookbacks, in[bytes_proc], bytes_proc);
+      int longest_match = find_longest(in, bytes_proc, max_length, &offset, &mf);
       if (longest_match > 2) {
          int lookahead_offset;
          // lookahead to next byte to see if longer match
          int lookahead_length = MIN(length - bytes_proc - 1, 18);
-         int lookahead_match = find_longest(in, bytes_proc + 1, lookahead_length, &lookahead_offset, lookbacks);
+         int lookahead_match = find_longest(in, bytes_proc + 1, lookahead_length, &lookahead_offset, &mf);
          // better match found, use uncompressed + lookahead compressed
          if ((longest_match + 1) < lookahead_match) {
             // uncompressed byte
@@ -245,11 +253,6 @@ int mio0_encode(const unsigned char *in, unsigned int length, unsigned char *out
             longest_match = lookahead_match;
             offset = lookahead_offset;
             bit_idx++;
-            lookback_push(lookbacks, in[bytes_proc], bytes_proc);
-         }
-         // first byte already pushed above
-         for (int i = 1; i < longest_match; i++) {
-            lookback_push(lookbacks, in[bytes_proc + i], bytes_proc + i);
          }
          // compressed block
          comp_buf[comp_idx] = (((longest_match - 3) & 0x0F) << 4) |
@@ -283,6 +286,8 @@ int mio0_encode(const unsigned char *in, unsigned int length, unsigned char *out
    write_u32_be(&out[12], uncomp_offset);
    // output data
    memcpy(&out[MIO0_HEADER_LENGTH], bit_buf, bit_length);
+   // zero the alignment padding, so the output doesn't depend on what was in the buffer
+   memset(&out[MIO0_HEADER_LENGTH + bit_length], 0, comp_offset - (MIO0_HEADER_LENGTH + bit_length));
    memcpy(&out[comp_offset], comp_buf, comp_idx);
    memcpy(&out[uncomp_offset], uncomp_buf, uncomp_idx);
 
@@ -290,7 +295,7 @@ int mio0_encode(const unsigned char *in, unsigned int length, unsigned char *out
    free(bit_buf);
    free(comp_buf);
    free(uncomp_buf);
-   lookback_free(lookbacks);
+   match_finder_free(&mf);
 
    return bytes_written;
 }
@@ -455,6 +460,10 @@ typedef struct
    char *out_filename;
    unsigned int offset;
    int compress;
+   int batch;
+   int jobs;
+   char **batch_files;
+   int batch_count;
 } arg_config;
 
 static arg_config default_config =
@@ -462,12 +471,23 @@ static arg_config default_config =
    NULL,
    NULL,
    0,
-   1
+   1,
+   0,
+   0,
+   NULL,
+   0
 };
 
+// state shared by the batch compression threads
+static arg_config *batch_config;
+static int batch_next;
+static int batch_failed;
+static pthread_mutex_t batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 static void print_usage(void)
 {
    ERROR("Usage: mio0 [-c / -d] [-o OFFSET] FILE [OUTPUT]\n"
+         "       mio0 -b [-j JOBS] FILE OUTPUT [FILE OUTPUT ...]\n"
          "\n"
          "mio0 v" MIO0_VERSION ": MIO0 compression and decompression tool\n"
          "\n"
@@ -475,6 +495,8 @@ static void print_usage(void)
          " -c           compress raw data into MIO0 (default: compress)\n"
          " -d           decompress MIO0 into raw data\n"
          " -o OFFSET    starting offset in FILE (default: 0)\n"
+         " -b           compress every FILE OUTPUT pair, in parallel\n"
+         " -j JOBS      number of threads for -b (default: number of CPUs)\n"
          "\n"
          "File arguments:\n"
          " FILE        input file\n"
@@ -506,10 +528,25 @@ static void parse_arguments(int argc, char *argv[], arg_config *config)
                }
                config->offset = strtoul(argv[i], NULL, 0);
                break;
+            case 'b':
+               config->batch = 1;
+               break;
+            case 'j':
+               if (++i >= argc) {
+                  print_usage();
+               }
+               config->jobs = strtol(argv[i], NULL, 0);
+               break;
             default:
                print_usage();
                break;
          }
+      } else if (config->batch) {
+         // everything after the first file is an IN OUT pair
+         config->batch_files = &argv[i];
+         config->batch_count = argc - i;
+         file_count = config->batch_count;
+         break;
       } else {
          switch (file_count) {
             case 0:
@@ -525,11 +562,77 @@ static void parse_arguments(int argc, char *argv[], arg_config *config)
          file_count++;
       }
    }
-   if (file_count < 1) {
+   if (file_count < 1 || (config->batch && (file_count % 2) != 0)) {
       print_usage();
    }
 }
 
+static void *batch_worker(void *arg)
+{
+   (void)arg;
+
+   while (1) {
+      const char *in_filename;
+      const char *out_filename;
+      int job;
+      int ret_val;
+
+      pthread_mutex_lock(&batch_mutex);
+      job = batch_next++;
+      pthread_mutex_unlock(&batch_mutex);
+
+      if (job * 2 >= batch_config->batch_count) {
+         break;
+      }
+
+      in_filename = batch_config->batch_files[job * 2];
+      out_filename = batch_config->batch_files[job * 2 + 1];
+      ret_val = mio0_encode_file(in_filename, out_filename);
+      if (ret_val != 0) {
+         ERROR("Error %d compressing \"%s\" to \"%s\"\n", ret_val, in_filename, out_filename);
+         pthread_mutex_lock(&batch_mutex);
+         batch_failed = ret_val;
+         pthread_mutex_unlock(&batch_mutex);
+      }
+   }
+
+   return NULL;
+}
+
+// compress many files at once, since each one is independent
+static int mio0_encode_batch(arg_config *config)
+{
+   pthread_t *threads;
+   int num_threads = config->jobs;
+   int i;
+
+   batch_config = config;
+   batch_next = 0;
+   batch_failed = 0;
+
+   if (num_threads <= 0) {
+      num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+   }
+   if (num_threads > config->batch_count / 2) {
+      num_threads = config->batch_count / 2;
+   }
+   if (num_threads <= 1) {
+      batch_worker(NULL);
+      return batch_failed;
+   }
+
+   threads = malloc(num_threads * sizeof(*threads));
+   for (i = 0; i < num_threads; i++) {
+      pthread_create(&threads[i], NULL, batch_worker, NULL);
+   }
+   for (i = 0; i < num_threads; i++) {
+      pthread_join(threads[i], NULL);
+   }
+   free(threads);
+
+   return batch_failed;
+}
+
 int main(int argc, char *argv[])
 {
    char out_filename[FILENAME_MAX];
@@ -539,6 +642,9 @@ int main(int argc, char *argv[])
    // get configuration from arguments
    config = default_config;
    parse_arguments(argc, argv, &config);
+   if (config.batch) {
+      return mio0_encode_batch(&config);
+   }
    if (config.out_filename == NULL) {
       config.out_filename = out_filename;
       sprintf(config.out_filename, "%s.out", config.in_filename);
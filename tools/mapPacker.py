@@ -13,6 +13,10 @@ class MapEntry():
 
 structDef = ">LLLL"
 
+# Every INDEX_STRIDE'th address is written to the index file, so lookups can binary search a small table first.
+# Must match MAP_INDEX_STRIDE in src/game/map_parser.c.
+INDEX_STRIDE = 32
+
 symNames = []
 
 
@@ -46,5 +50,10 @@ for x in symNames:
 f1.close()
 f2.close()
 
+if len(sys.argv) > 4:
+	with open(sys.argv[4], "wb+") as f3:
+		for x in symNames[::INDEX_STRIDE]:
+			f3.write(struct.pack(">L", x.addr))
+
 # print('\n'.join([str(hex(x.addr)) + " " + x.name for x in symNames]))
 
@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ultra64.h>
+
+#include "macros.h"
+
+// Host tests for the symbol lookup in src/game/map_parser.c
+//
+// Builds symbol maps laid out the way tools/mapPacker.py writes them (entries sorted by address, a
+// string table, and an index holding the address of every MAP_INDEX_STRIDE'th entry), then checks
+// parse_map against a linear search for the last symbol at or before each address. The maps cover
+// the edge cases of the two-level search: empty and single entry maps, sizes around the index
+// stride, symbols sharing an address across a block boundary, and addresses below the first symbol,
+// on each symbol, just either side of it, and far past the last one.
+//
+//   mapparsertest [-r random maps] [-s seed]
+
+#define MAX_ENTRIES 5000
+#define NAME_LENGTH 12
+
+void *osRomBase;
+u8 _mapDataSegmentRomStart[1];
+u8 _mainSegmentStart[1], _mainSegmentTextEnd[1];
+u8 _engineSegmentStart[1], _engineSegmentTextEnd[1];
+u8 _goddardSegmentStart[1], _goddardSegmentTextEnd[1];
+
+#include "game/map_parser.c"
+
+// The symbol map the assembler would include from mapPacker.py's output.
+struct MapEntry gMapEntries[MAX_ENTRIES];
+u8 gMapStrings[MAX_ENTRIES * NAME_LENGTH];
+u32 gMapEntrySize;
+u32 gMapIndex[MAX_ENTRIES / MAP_INDEX_STRIDE + 1];
+u32 gMapIndexSize;
+
+static s32 sNumFailures;
+
+static s32 compare_addresses(const void *a, const void *b)
+{
+	u32 addrA = *(const u32 *) a;
+	u32 addrB = *(const u32 *) b;
+
+	return (addrA > addrB) - (addrA < addrB);
+}
+
+// Fills in the map the way mapPacker.py does, from a list of addresses.
+static void build_map(u32 *addrs, s32 numEntries)
+{
+	u32 offset = 0;
+
+	qsort(addrs, numEntries, sizeof(u32), compare_addresses);
+	for (s32 i = 0; i < numEntries; i++)
+	{
+		s32 length = sprintf((char *) &gMapStrings[offset], "sym_%d", i);
+
+		gMapEntries[i].addr = addrs[i];
+		gMapEntries[i].nm_offset = offset;
+		gMapEntries[i].nm_len = length;
+		gMapEntries[i].pad = 0;
+		offset += (length + 4) & ~3;
+	}
+	gMapEntrySize = numEntries;
+
+	gMapIndexSize = 0;
+	for (s32 i = 0; i < numEntries; i += MAP_INDEX_STRIDE)
+		gMapIndex[gMapIndexSize++] = addrs[i];
+}
+
+// The last symbol at or before pc, found the slow way.
+static char *find_symbol_linear(u32 pc)
+{
+	char *name = NULL;
+
+	for (u32 i = 0; i < gMapEntrySize && gMapEntries[i].addr <= pc; i++)
+		name = (char *) &gMapStrings[gMapEntries[i].nm_offset];
+	return name;
+}
+
+static void check_lookup(const char *mapName, u32 pc)
+{
+	char *expected = find_symbol_linear(pc);
+	char *found = parse_map(pc);
+
+	if (found != expected)
+	{
+		if (sNumFailures++ < 10)
+		{
+			printf("%s: parse_map(0x%08X) returned %s, expected %s\n", mapName, pc, found != NULL ? found : "NULL",
+			       expected != NULL ? expected : "NULL");
+		}
+	}
+}
+
+static void check_map(const char *mapName)
+{
+	check_lookup(mapName, 0);
+	check_lookup(mapName, 0xFFFFFFFF);
+	for (u32 i = 0; i < gMapEntrySize; i++)
+	{
+		u32 addr = gMapEntries[i].addr;
+
+		check_lookup(mapName, addr);
+		check_lookup(mapName, addr - 1);
+		check_lookup(mapName, addr + 1);
+		check_lookup(mapName, addr + 4);
+	}
+	for (s32 i = 0; i < 1000; i++)
+		check_lookup(mapName, 0x80000000 + (rand() & 0x7FFFFF));
+}
+
+// Functions are word aligned and anywhere from 8 bytes to a few KB long.
+static void fill_addresses(u32 *addrs, s32 numEntries, u32 start)
+{
+	u32 addr = start;
+
+	for (s32 i = 0; i < numEntries; i++)
+	{
+		addrs[i] = addr;
+		addr += 8 + (rand() % 0x400) * 4;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	static const s32 sizes[] = { 0, 1, 2, MAP_INDEX_STRIDE - 1, MAP_INDEX_STRIDE, MAP_INDEX_STRIDE + 1,
+	                             2 * MAP_INDEX_STRIDE, 1000, MAX_ENTRIES };
+	static u32 addrs[MAX_ENTRIES];
+	char mapName[64];
+	s32 numRandomMaps = 100;
+	s32 numMaps = 0;
+	unsigned int seed = 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+			numRandomMaps = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+			seed = strtoul(argv[++i], NULL, 0);
+		else
+		{
+			fprintf(stderr, "mapparsertest [-r random maps] [-s seed]\n");
+			return 1;
+		}
+	}
+	srand(seed);
+
+	for (u32 i = 0; i < ARRAY_COUNT(sizes); i++)
+	{
+		sprintf(mapName, "%d symbols", sizes[i]);
+		fill_addresses(addrs, sizes[i], 0x80246000);
+		build_map(addrs, sizes[i]);
+		check_map(mapName);
+		numMaps++;
+	}
+
+	// Aliases, like a static function and its global alias, share an address. Put a run of them across a block boundary.
+	sprintf(mapName, "aliases across a block boundary");
+	fill_addresses(addrs, 3 * MAP_INDEX_STRIDE, 0x80246000);
+	for (s32 i = MAP_INDEX_STRIDE - 3; i < MAP_INDEX_STRIDE + 3; i++)
+		addrs[i] = addrs[MAP_INDEX_STRIDE - 3];
+	build_map(addrs, 3 * MAP_INDEX_STRIDE);
+	check_map(mapName);
+	numMaps++;
+
+	for (s32 i = 0; i < numRandomMaps; i++)
+	{
+		s32 numEntries = rand() % (MAX_ENTRIES + 1);
+
+		sprintf(mapName, "random map %d (%d symbols)", i, numEntries);
+		fill_addresses(addrs, numEntries, 0x80000400 + (rand() % 0x10000) * 4);
+		// Some more aliases anywhere.
+		for (s32 j = 1; j < numEntries; j++)
+		{
+			if (rand() % 50 == 0)
+				addrs[j] = addrs[j - 1];
+		}
+		build_map(addrs, numEntries);
+		check_map(mapName);
+		numMaps++;
+	}
+
+	if (sNumFailures != 0)
+	{
+		printf("%d lookups failed\n", sNumFailures);
+		return 1;
+	}
+	printf("%d maps, every lookup matches the linear search\n", numMaps);
+	return 0;
+}
@@ -0,0 +1,295 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include <ultra64.h>
+
+#include "sm64.h"
+#include "game/interaction.h"
+#include "game/object_list_processor.h"
+#include "game/puppyprint.h"
+
+// Host benchmark for the object-object collision checks in src/game/object_collision.c
+//
+// Spawns a number of synthetic objects into the object lists, the way a busy level has them: Mario,
+// a crowd of coins, enemies walking around, and a few pushable, destructive, polelike and surface
+// objects. Then every frame the objects move a little and detect_object_collisions runs, once with
+// OBJECT_COLLISION_BROADPHASE's grid and once with the list scans it replaced. It reports the hitbox
+// overlap tests per frame, from the same counter the puppyprint collision page shows, and checks
+// that both found the same collisions in the same order.
+//
+//   objcollisionbench [-n objects] [-f frames] [-w area width] [-s seed]
+
+#define AREA_HEIGHT 400.0f
+#define STEP_SIZE 30.0f
+
+struct Object *gMarioObject;
+struct CallCounter gPuppyCallCounter;
+
+static struct ObjectNode sObjectLists[NUM_OBJ_LISTS];
+struct ObjectNode *gObjectLists = sObjectLists;
+
+void print_debug_top_down_objectinfo(UNUSED const char *str, UNUSED s32 number)
+{
+}
+
+#include "game/object_collision.c"
+
+f32 dist_between_objects(struct Object *obj1, struct Object *obj2)
+{
+	Vec3f diff;
+
+	vec3_diff(diff, &obj1->oPosVec, &obj2->oPosVec);
+	return vec3_mag(diff);
+}
+
+// The object lists the harness spawns into, and how many of every 20 objects go into each.
+static const struct
+{
+	u8 list;
+	u8 share;
+	f32 radius, height;
+	f32 hurtboxRadius;
+	u32 interactType;
+	u8 moves;
+} sObjectKinds[] = {
+	{ OBJ_LIST_LEVEL, 10, 100.0f, 64.0f, 0.0f, INTERACT_COIN, FALSE },
+	{ OBJ_LIST_GENACTOR, 5, 120.0f, 100.0f, 80.0f, INTERACT_BOUNCE_TOP, TRUE },
+	{ OBJ_LIST_PUSHABLE, 1, 150.0f, 120.0f, 100.0f, INTERACT_BOUNCE_TOP, TRUE },
+	{ OBJ_LIST_DESTRUCTIVE, 1, 60.0f, 60.0f, 0.0f, INTERACT_DAMAGE, TRUE },
+	{ OBJ_LIST_POLELIKE, 1, 80.0f, 800.0f, 0.0f, INTERACT_POLE, FALSE },
+	{ OBJ_LIST_SURFACE, 2, 200.0f, 100.0f, 0.0f, INTERACT_IGLOO_BARRIER, FALSE },
+};
+
+static struct Object sObjects[OBJECT_POOL_CAPACITY];
+static u8 sObjectMoves[OBJECT_POOL_CAPACITY];
+static s32 sNumObjects = 150;
+static f32 sAreaWidth = 3000.0f;
+
+// What detect_object_collisions leaves in each object, to compare the grid with the list scans.
+typedef struct
+{
+	s16 numCollidedObjs;
+	s16 intangibleTimer;
+	u32 collidedObjInteractTypes;
+	u32 interactionSubtype;
+	struct Object *collidedObjs[4];
+} CollisionState;
+
+static CollisionState sGridState[OBJECT_POOL_CAPACITY];
+static CollisionState sScanState[OBJECT_POOL_CAPACITY];
+
+static f32 random_fraction(void)
+{
+	return rand() / (f32) RAND_MAX;
+}
+
+static void add_to_object_list(struct Object *obj, s32 listIndex)
+{
+	struct ObjectNode *list = &gObjectLists[listIndex];
+
+	obj->header.next = list;
+	obj->header.prev = list->prev;
+	list->prev->next = &obj->header;
+	list->prev = &obj->header;
+}
+
+static void spawn_objects(void)
+{
+	s32 totalShare = 0;
+
+	for (s32 i = 0; i < NUM_OBJ_LISTS; i++)
+		gObjectLists[i].next = gObjectLists[i].prev = &gObjectLists[i];
+	for (u32 i = 0; i < ARRAY_COUNT(sObjectKinds); i++)
+		totalShare += sObjectKinds[i].share;
+
+	bzero(sObjects, sizeof(sObjects));
+	for (s32 i = 0; i < sNumObjects; i++)
+	{
+		struct Object *obj = &sObjects[i];
+
+		obj->oPosX = (random_fraction() - 0.5f) * sAreaWidth;
+		obj->oPosY = random_fraction() * AREA_HEIGHT;
+		obj->oPosZ = (random_fraction() - 0.5f) * sAreaWidth;
+		obj->activeFlags = ACTIVE_FLAG_ACTIVE;
+
+		if (i == 0)
+		{
+			// Mario, in the middle of it all.
+			gMarioObject = obj;
+			vec3f_set(&obj->oPosVec, 0.0f, 0.0f, 0.0f);
+			obj->hitboxRadius = 37.0f;
+			obj->hitboxHeight = 160.0f;
+			obj->hurtboxRadius = 37.0f;
+			obj->hurtboxHeight = 160.0f;
+			sObjectMoves[i] = TRUE;
+			add_to_object_list(obj, OBJ_LIST_PLAYER);
+			continue;
+		}
+
+		s32 pick = i % totalShare;
+		u32 kind = 0;
+
+		while (pick >= sObjectKinds[kind].share)
+			pick -= sObjectKinds[kind++].share;
+		obj->hitboxRadius = sObjectKinds[kind].radius;
+		obj->hitboxHeight = sObjectKinds[kind].height;
+		obj->hurtboxRadius = sObjectKinds[kind].hurtboxRadius;
+		obj->hurtboxHeight = sObjectKinds[kind].height;
+		obj->oInteractType = sObjectKinds[kind].interactType;
+		sObjectMoves[i] = sObjectKinds[kind].moves;
+		add_to_object_list(obj, sObjectKinds[kind].list);
+	}
+}
+
+// Moves Mario and every moving object a step, and makes a few objects intangible for a while, like after an interaction.
+static void move_objects(void)
+{
+	for (s32 i = 0; i < sNumObjects; i++)
+	{
+		struct Object *obj = &sObjects[i];
+
+		if (sObjectMoves[i])
+		{
+			obj->oPosX += (random_fraction() - 0.5f) * 2.0f * STEP_SIZE;
+			obj->oPosZ += (random_fraction() - 0.5f) * 2.0f * STEP_SIZE;
+		}
+		if (obj != gMarioObject && obj->oIntangibleTimer == 0 && rand() % 100 == 0)
+			obj->oIntangibleTimer = 10;
+		obj->oDistanceToMario = dist_between_objects(obj, gMarioObject);
+	}
+}
+
+// detect_object_collisions as it was before OBJECT_COLLISION_BROADPHASE: every object of a list against entire lists.
+static void scan_object_lists(void)
+{
+	static const u8 playerLists[] = { OBJ_LIST_POLELIKE, OBJ_LIST_LEVEL, OBJ_LIST_GENACTOR, OBJ_LIST_PUSHABLE, OBJ_LIST_SURFACE, OBJ_LIST_DESTRUCTIVE };
+	static const u8 destructiveLists[] = { OBJ_LIST_GENACTOR, OBJ_LIST_PUSHABLE, OBJ_LIST_SURFACE };
+	static const u8 clearLists[] = { OBJ_LIST_POLELIKE, OBJ_LIST_PLAYER, OBJ_LIST_PUSHABLE, OBJ_LIST_GENACTOR, OBJ_LIST_LEVEL, OBJ_LIST_SURFACE, OBJ_LIST_DESTRUCTIVE };
+	struct Object *head, *obj;
+
+	for (u32 i = 0; i < ARRAY_COUNT(clearLists); i++)
+		clear_object_collision((struct Object *) &gObjectLists[clearLists[i]]);
+
+	head = (struct Object *) &gObjectLists[OBJ_LIST_PLAYER];
+	for (obj = (struct Object *) head->header.next; obj != head; obj = (struct Object *) obj->header.next)
+	{
+		check_collision_in_list(obj, (struct Object *) obj->header.next, head);
+		for (u32 i = 0; i < ARRAY_COUNT(playerLists); i++)
+			check_collision_in_list(obj, (struct Object *) gObjectLists[playerLists[i]].next, (struct Object *) &gObjectLists[playerLists[i]]);
+	}
+
+	head = (struct Object *) &gObjectLists[OBJ_LIST_DESTRUCTIVE];
+	for (obj = (struct Object *) head->header.next; obj != head; obj = (struct Object *) obj->header.next)
+	{
+		if (obj->oDistanceToMario < 2000.0f && !(obj->activeFlags & ACTIVE_FLAG_DESTRUCTIVE_OBJ_DONT_DESTROY))
+		{
+			check_collision_in_list(obj, (struct Object *) obj->header.next, head);
+			for (u32 i = 0; i < ARRAY_COUNT(destructiveLists); i++)
+				check_collision_in_list(obj, (struct Object *) gObjectLists[destructiveLists[i]].next, (struct Object *) &gObjectLists[destructiveLists[i]]);
+		}
+	}
+
+	head = (struct Object *) &gObjectLists[OBJ_LIST_PUSHABLE];
+	for (obj = (struct Object *) head->header.next; obj != head; obj = (struct Object *) obj->header.next)
+		check_collision_in_list(obj, (struct Object *) obj->header.next, head);
+}
+
+static void save_collision_state(CollisionState *states)
+{
+	for (s32 i = 0; i < sNumObjects; i++)
+	{
+		struct Object *obj = &sObjects[i];
+		CollisionState *state = &states[i];
+
+		bzero(state, sizeof(*state));
+		state->numCollidedObjs = obj->numCollidedObjs;
+		state->intangibleTimer = obj->oIntangibleTimer;
+		state->collidedObjInteractTypes = obj->collidedObjInteractTypes;
+		state->interactionSubtype = obj->oInteractionSubtype;
+		memcpy(state->collidedObjs, obj->collidedObjs, obj->numCollidedObjs * sizeof(obj->collidedObjs[0]));
+	}
+}
+
+// Puts back what detect_object_collisions changes, so the list scans start from the same state as the grid did.
+static void restore_collision_state(const CollisionState *states)
+{
+	for (s32 i = 0; i < sNumObjects; i++)
+	{
+		sObjects[i].oIntangibleTimer = states[i].intangibleTimer;
+		sObjects[i].oInteractionSubtype = states[i].interactionSubtype;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	static CollisionState startState[OBJECT_POOL_CAPACITY];
+	s32 numFrames = 300;
+	unsigned int seed = 1;
+	u32 gridTests = 0, scanTests = 0;
+	u32 collisions = 0;
+	s32 mismatches = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			sNumObjects = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+			numFrames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+			sAreaWidth = atof(argv[++i]);
+		else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+			seed = strtoul(argv[++i], NULL, 0);
+		else
+		{
+			fprintf(stderr, "objcollisionbench [-n objects] [-f frames] [-w area width] [-s seed]\n");
+			return 1;
+		}
+	}
+	if (sNumObjects <= 0 || sNumObjects > OBJECT_POOL_CAPACITY || numFrames <= 0)
+	{
+		fprintf(stderr, "the number of objects must be from 1 to %d, and frames at least 1\n", OBJECT_POOL_CAPACITY);
+		return 1;
+	}
+
+	srand(seed);
+	spawn_objects();
+
+	for (s32 frame = 0; frame < numFrames; frame++)
+	{
+		move_objects();
+		save_collision_state(startState);
+
+		gPuppyCallCounter.object_pair_tests = 0;
+		detect_object_collisions();
+		gridTests += gPuppyCallCounter.object_pair_tests;
+		save_collision_state(sGridState);
+
+		restore_collision_state(startState);
+		gPuppyCallCounter.object_pair_tests = 0;
+		scan_object_lists();
+		scanTests += gPuppyCallCounter.object_pair_tests;
+		save_collision_state(sScanState);
+
+		for (s32 i = 0; i < sNumObjects; i++)
+			collisions += sScanState[i].numCollidedObjs;
+		mismatches += (memcmp(sGridState, sScanState, sNumObjects * sizeof(CollisionState)) != 0);
+	}
+
+	printf("%d objects over %.0f x %.0f units for %d frames\n", sNumObjects, sAreaWidth, sAreaWidth, numFrames);
+#ifdef OBJECT_COLLISION_BROADPHASE
+	printf("hitbox overlap tests per frame: %.1f with the grid, %.1f scanning the lists\n", (double) gridTests / numFrames,
+	       (double) scanTests / numFrames);
+#else
+	printf("hitbox overlap tests per frame: %.1f scanning the lists (OBJECT_COLLISION_BROADPHASE is off)\n", (double) scanTests / numFrames);
+#endif
+	printf("collisions per frame: %.1f\n", (double) collisions / 2 / numFrames);
+	if (mismatches != 0)
+	{
+		printf("%d frames found different collisions\n", mismatches);
+		return 1;
+	}
+	printf("every frame found the same collisions in the same order\n");
+	return 0;
+}
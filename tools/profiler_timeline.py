@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+# Converts the PROFILER_TIMELINE dumps in a USB log (printed whenever a frame goes over
+# PROFILER_TIMELINE_THRESHOLD_US) into a Chrome trace, which chrome://tracing and ui.perfetto.dev
+# can open. Each dump becomes its own process in the trace, with one thread per track.
+#
+# usage: profiler_timeline.py <log file> [output json]
+
+import sys
+import json
+
+TRACKS = ["Frame", "Game", "Audio", "RSP", "RDP"]
+
+def read_dumps(lines):
+	dump = None
+	for line in lines:
+		line = line.rstrip("\r\n")
+		if line.startswith("TIMELINE BEGIN"):
+			tokens = line.split()
+			dump = {"count": int(tokens[2]), "hz": int(tokens[3]), "frameUs": int(tokens[4]), "events": []}
+		elif dump is None:
+			continue
+		elif line.startswith("TIMELINE END"):
+			yield dump
+			dump = None
+		elif line.startswith("E "):
+			tokens = line.split(" ", 4)
+			# Times are counter ticks before the dump, so larger ages are earlier
+			dump["events"].append({"track": tokens[1], "start": -int(tokens[2]), "end": -int(tokens[3]), "name": tokens[4]})
+
+def make_trace(dumps):
+	events = []
+	for pid, dump in enumerate(dumps, 1):
+		events.append({"ph": "M", "name": "process_name", "pid": pid, "tid": 0,
+			"args": {"name": "Slow frame %d (%d us)" % (pid, dump["frameUs"])}})
+		for tid, track in enumerate(TRACKS):
+			events.append({"ph": "M", "name": "thread_name", "pid": pid, "tid": tid, "args": {"name": track}})
+			events.append({"ph": "M", "name": "thread_sort_index", "pid": pid, "tid": tid, "args": {"sort_index": tid}})
+
+		if len(dump["events"]) == 0:
+			continue
+		first = min(e["start"] for e in dump["events"])
+		toUs = 1000000.0 / dump["hz"]
+		for e in dump["events"]:
+			if e["track"] not in TRACKS:
+				TRACKS.append(e["track"])
+			events.append({
+				"ph": "X",
+				"name": e["name"],
+				"cat": e["track"],
+				"pid": pid,
+				"tid": TRACKS.index(e["track"]),
+				"ts": (e["start"] - first) * toUs,
+				"dur": max(e["end"] - e["start"], 0) * toUs,
+			})
+	return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+def main():
+	args = sys.argv[1:]
+	if len(args) not in (1, 2):
+		print("usage: %s <log file> [output json]" % sys.argv[0], file=sys.stderr)
+		sys.exit(1)
+
+	with open(args[0], "r", errors="replace") as f:
+		dumps = list(read_dumps(f))
+
+	if len(dumps) == 0:
+		print("No timeline dumps found in %s" % args[0], file=sys.stderr)
+		sys.exit(1)
+
+	trace = make_trace(dumps)
+	if len(args) == 2:
+		with open(args[1], "w") as f:
+			json.dump(trace, f)
+	else:
+		json.dump(trace, sys.stdout)
+		print()
+
+if __name__ == "__main__":
+	main()
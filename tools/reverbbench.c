@@ -0,0 +1,299 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <ultra64.h>
+
+#include "audio/heap.h"
+#include "audio/synthesis.h"
+#include "engine/math_util.h"
+
+// Host benchmark for BETTER_REVERB's filters in src/audio/better_reverb.inc.c
+//
+// Feeds the same noise through each way of running the filters, one audio frame at a time for both
+// channels, and reports the time taken per frame: the original version that runs every filter for
+// each sample, the block version the game uses now, the block version with
+// BETTER_REVERB_REDUCED_PRECISION, and the lightweight version. The block version's output has to
+// match the original exactly; for reduced precision the largest difference is shown instead. Each
+// version is run several times and the fastest run is reported.
+//
+// The delays, multipliers and indices are those of preset 2 in src/audio/data.c. Cycles are read
+// from the host's time stamp counter where there is one, so they only compare the versions with
+// each other and are not console cycles.
+//
+//   reverbbench [-f frames] [-r runs] [-n filter count] [-d downsample rate] [-s seed]
+
+#define SAMPLES_PER_FRAME 544 // gSamplesPerFrameTarget at 32 kHz
+#define DELAY_MAX 2048
+
+s8 gReverbDownsampleRate;
+s32 reverbLastFilterIndex;
+s32 betterReverbRevIndex;
+s32 betterReverbGainIndex;
+
+#include "audio/better_reverb.inc.c"
+
+static const u32 sDelays[SYNTH_CHANNEL_STEREO_COUNT][NUM_ALLPASS] = {
+    { 1080, 1352, 1200, 1200, 1232, 1432, 1384, 1048, 1352,  928, 1504, 1512 },
+    { 1384, 1352, 1048,  928, 1512, 1504, 1080, 1200, 1352, 1200, 1432, 1232 },
+};
+static const u8 sMults[SYNTH_CHANNEL_STEREO_COUNT][NUM_ALLPASS / 3] = {
+    { 0xD7, 0x6F, 0x36, 0x22 },
+    { 0xCF, 0x73, 0x38, 0x1F },
+};
+
+static s16 sDelayMemory[SYNTH_CHANNEL_STEREO_COUNT][NUM_ALLPASS][DELAY_MAX];
+static s16 *sDelayPtrs[SYNTH_CHANNEL_STEREO_COUNT][NUM_ALLPASS];
+
+typedef void (*ReverbFunc)(s16 *start, s16 *end, s16 *downsampleBuffer, s32 channel);
+
+typedef struct
+{
+	const char *name;
+	ReverbFunc func;
+} Kernel;
+
+// reverb_samples as it was before the filters were run in blocks.
+static void reverb_samples_per_sample(s16 *start, s16 *end, s16 *downsampleBuffer, s32 channel)
+{
+	s16 *curDelaySample;
+	s32 historySample;
+	s32 tmpCarryover;
+	s32 outSampleTotal;
+	s32 i;
+	s32 j;
+	s32 k;
+
+	s32 downsampleIncrement = gReverbDownsampleRate;
+	s32 *delaysLocal = betterReverbDelays[channel];
+	s32 *reverbMultsLocal = reverbMults[channel];
+	s32 *allpassIdxLocal = allpassIdx[channel];
+	s16 **delayBufsLocal = delayBufs[channel];
+
+	s32 lastFilterIndex = reverbLastFilterIndex;
+	s32 revIndex = betterReverbRevIndex;
+	s32 gainIndex = betterReverbGainIndex;
+
+	j = 0;
+
+	for (; start < end; start++, downsampleBuffer += downsampleIncrement)
+	{
+		tmpCarryover = ((delayBufsLocal[lastFilterIndex][allpassIdxLocal[lastFilterIndex]] * revIndex) >> 8) + *downsampleBuffer;
+		outSampleTotal = 0;
+		i = 0;
+		k = 0;
+
+		for (; i <= lastFilterIndex; ++i, ++j)
+		{
+			curDelaySample = &delayBufsLocal[i][allpassIdxLocal[i]];
+			historySample = *curDelaySample;
+
+			if (j == 2)
+			{
+				j = -1;
+				outSampleTotal += ((historySample * reverbMultsLocal[k++]) >> 8);
+				*curDelaySample = CLAMP_S16(tmpCarryover);
+				if (i != lastFilterIndex)
+					tmpCarryover = ((historySample * revIndex) >> 8);
+			}
+			else
+			{
+				tmpCarryover += (historySample * (-gainIndex)) >> 8;
+				*curDelaySample = CLAMP_S16(tmpCarryover);
+				tmpCarryover = ((tmpCarryover * gainIndex) >> 8) + historySample;
+			}
+
+			if (++allpassIdxLocal[i] == delaysLocal[i])
+				allpassIdxLocal[i] = 0;
+		}
+
+		*start = CLAMP_S16(outSampleTotal);
+	}
+}
+
+static void reverb_samples_reduced(s16 *start, s16 *end, s16 *downsampleBuffer, s32 channel)
+{
+	reverb_samples_blocks(start, end, downsampleBuffer, channel, TRUE);
+}
+
+static const Kernel sKernels[] = {
+	{ "per sample", reverb_samples_per_sample },
+	{ "blocks", reverb_samples },
+	{ "blocks, reduced", reverb_samples_reduced },
+	{ "light", reverb_samples_light },
+};
+
+static u64 now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static u64 read_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+// Sets up the filters the way set_better_reverb_buffers and synthesis_execute do, with empty delay lines.
+static void reset_reverb(s32 filterCount, s32 downsampleRate)
+{
+	gReverbDownsampleRate = downsampleRate;
+	reverbLastFilterIndex = filterCount - 1;
+	betterReverbGainIndex = 0xA0;
+	betterReverbRevIndex = 0x40;
+	set_reverb_index_shifts();
+
+	for (s32 channel = 0; channel < SYNTH_CHANNEL_STEREO_COUNT; channel++)
+	{
+		delayBufs[channel] = sDelayPtrs[channel];
+		historySamplesLight[channel] = 0;
+		for (s32 filter = 0; filter < NUM_ALLPASS; filter++)
+		{
+			betterReverbDelays[channel][filter] = sDelays[channel][filter] / downsampleRate;
+			delayBufs[channel][filter] = sDelayMemory[channel][filter];
+			allpassIdx[channel][filter] = 0;
+		}
+		for (s32 i = 0; i < NUM_ALLPASS / 3; i++)
+			reverbMults[channel][i] = sMults[channel][i];
+	}
+	memset(sDelayMemory, 0, sizeof(sDelayMemory));
+}
+
+// Runs a kernel over every frame of input and returns the time per frame. The output of each
+// frame and channel is left in output.
+static void run_kernel(const Kernel *kernel, const s16 *input, s16 *output, s32 frames, s32 filterCount,
+                       s32 downsampleRate, double *cyclesPerFrame, double *nsPerFrame)
+{
+	s32 frameLen = SAMPLES_PER_FRAME / downsampleRate;
+	s16 downsampleBuffer[SAMPLES_PER_FRAME];
+	u64 cycles = 0, ns = 0;
+
+	reset_reverb(filterCount, downsampleRate);
+	for (s32 frame = 0; frame < frames; frame++)
+	{
+		for (s32 channel = 0; channel < SYNTH_CHANNEL_STEREO_COUNT; channel++)
+		{
+			s16 *out = &output[(frame * SYNTH_CHANNEL_STEREO_COUNT + channel) * frameLen];
+			u64 startCycles, startNs;
+
+			memcpy(downsampleBuffer, &input[(frame * SYNTH_CHANNEL_STEREO_COUNT + channel) * SAMPLES_PER_FRAME],
+			       sizeof(downsampleBuffer));
+			startNs = now_ns();
+			startCycles = read_cycles();
+			kernel->func(out, out + frameLen, downsampleBuffer, channel);
+			cycles += read_cycles() - startCycles;
+			ns += now_ns() - startNs;
+		}
+	}
+	*cyclesPerFrame = (double) cycles / frames;
+	*nsPerFrame = (double) ns / frames;
+}
+
+int main(int argc, char **argv)
+{
+	s32 frames = 600;
+	s32 runs = 10;
+	s32 filterCount = NUM_ALLPASS;
+	s32 downsampleRate = 1;
+	unsigned int seed = 1;
+	s32 outputLen;
+	s16 *input, *reference, *output;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+			frames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+			runs = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			filterCount = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+			downsampleRate = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+			seed = strtoul(argv[++i], NULL, 0);
+		else
+		{
+			fprintf(stderr, "reverbbench [-f frames] [-r runs] [-n filter count] [-d downsample rate] [-s seed]\n");
+			return 1;
+		}
+	}
+	if (frames <= 0 || runs <= 0 || filterCount < 3 || filterCount > NUM_ALLPASS || filterCount % 3 != 0
+	    || (downsampleRate != 1 && downsampleRate != 2 && downsampleRate != 4))
+	{
+		fprintf(stderr, "need frames and runs > 0, a filter count of 3, 6, 9 or 12 and a downsample rate of 1, 2 or 4\n");
+		return 1;
+	}
+
+	// Noise with a level that changes every frame, so the filters see both loud and quiet input.
+	srand(seed);
+	input = malloc(sizeof(s16) * frames * SYNTH_CHANNEL_STEREO_COUNT * SAMPLES_PER_FRAME);
+	for (s32 frame = 0; frame < frames; frame++)
+	{
+		s32 level = rand() % 0x4000;
+
+		for (s32 i = 0; i < SYNTH_CHANNEL_STEREO_COUNT * SAMPLES_PER_FRAME; i++)
+			input[frame * SYNTH_CHANNEL_STEREO_COUNT * SAMPLES_PER_FRAME + i] = rand() % (2 * level + 1) - level;
+	}
+	outputLen = frames * SYNTH_CHANNEL_STEREO_COUNT * (SAMPLES_PER_FRAME / downsampleRate);
+	reference = malloc(sizeof(s16) * outputLen);
+	output = malloc(sizeof(s16) * outputLen);
+
+	printf("%d frames of %d samples, %d filters, downsample rate %d\n", frames, SAMPLES_PER_FRAME,
+	       filterCount, downsampleRate);
+	printf("%-16s %14s %10s  %s\n", "kernel", "cycles/frame", "us/frame", "output");
+	for (u32 k = 0; k < ARRAY_COUNT(sKernels); k++)
+	{
+		double cycles = 0, ns = 0;
+		s32 maxDiff = 0;
+
+		for (s32 run = 0; run < runs; run++)
+		{
+			double runCycles, runNs;
+
+			run_kernel(&sKernels[k], input, k == 0 ? reference : output, frames, filterCount, downsampleRate,
+			           &runCycles, &runNs);
+			if (run == 0 || runNs < ns)
+			{
+				cycles = runCycles;
+				ns = runNs;
+			}
+		}
+		printf("%-16s %14.0f %10.1f  ", sKernels[k].name, cycles, ns / 1000);
+		if (k == 0)
+		{
+			printf("reference\n");
+			continue;
+		}
+		if (sKernels[k].func == reverb_samples_light)
+		{
+			printf("%d filters, not comparable\n", BETTER_REVERB_FILTER_COUNT_LIGHT);
+			continue;
+		}
+		for (s32 i = 0; i < outputLen; i++)
+		{
+			s32 diff = abs(output[i] - reference[i]);
+
+			if (diff > maxDiff)
+				maxDiff = diff;
+		}
+		if (maxDiff == 0)
+			printf("identical\n");
+		else
+			printf("differs by up to %d\n", maxDiff);
+	}
+
+	free(input);
+	free(reference);
+	free(output);
+	return 0;
+}
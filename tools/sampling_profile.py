@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+# Converts a SAMPLING_PROFILER dump (the USB log printed by pressing L + D-Pad Down) into
+# collapsed stacks that flamegraph.pl, speedscope or inferno can read, or into a flat profile.
+#
+# usage: sampling_profile.py [--flat] <log file>
+
+import sys
+from collections import Counter
+
+def read_dumps(lines):
+	dump = None
+	for line in lines:
+		line = line.rstrip("\r\n")
+		if line.startswith("SAMPLEPROF BEGIN"):
+			tokens = line.split()
+			dump = {"samples": int(tokens[2]), "idle": int(tokens[3]), "hz": int(tokens[4]), "stacks": Counter()}
+			# Samples taken while another thread (e.g. audio) had preempted the game thread. Older dumps don't have them.
+			dump["other"] = int(tokens[5]) if len(tokens) > 5 else 0
+		elif dump is None:
+			continue
+		elif line.startswith("SAMPLEPROF END"):
+			yield dump
+			dump = None
+		elif line.startswith("S "):
+			dump["stacks"][line[2:]] += 1
+
+def print_collapsed(stacks):
+	for stack, count in sorted(stacks.items()):
+		print("%s %d" % (stack, count))
+
+def print_flat(stacks, total, hz):
+	selfCounts = Counter()
+	totalCounts = Counter()
+	for stack, count in stacks.items():
+		frames = stack.split(";")
+		selfCounts[frames[-1]] += count
+		for frame in set(frames):
+			totalCounts[frame] += count
+
+	print("%8s %8s %8s  %s" % ("self%", "total%", "self ms", "function"))
+	for name, count in selfCounts.most_common():
+		print("%7.2f%% %7.2f%% %8.2f  %s" % (100.0 * count / total, 100.0 * totalCounts[name] / total, 1000.0 * count / hz, name))
+
+def main():
+	args = sys.argv[1:]
+	flat = "--flat" in args
+	args = [a for a in args if a != "--flat"]
+	if len(args) != 1:
+		print("usage: %s [--flat] <log file>" % sys.argv[0], file=sys.stderr)
+		sys.exit(1)
+
+	with open(args[0], "r", errors="replace") as f:
+		dumps = list(read_dumps(f))
+
+	if len(dumps) == 0:
+		print("No profiler dumps found in %s" % args[0], file=sys.stderr)
+		sys.exit(1)
+
+	# Multiple dumps in one log are merged.
+	stacks = Counter()
+	for dump in dumps:
+		stacks.update(dump["stacks"])
+
+	if flat:
+		total = sum(stacks.values())
+		print("%d samples, %d idle, %d in other threads, %d Hz" % (total, sum(d["idle"] for d in dumps), sum(d["other"] for d in dumps), dumps[0]["hz"]))
+		print_flat(stacks, max(total, 1), dumps[0]["hz"])
+	else:
+		print_collapsed(stacks)
+
+if __name__ == "__main__":
+	main()
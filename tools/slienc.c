@@ -1,319 +1,352 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <unistd.h>
 
 // Yay0 "slienc" compression tool
 // originally decompiled by SimonTime
+//
+// Matches are found with hash chains over the 4 KiB window instead of scanning the whole window
+// for every byte, and several files can be compressed at once on all cores:
+//   slienc [infile] [outfile]
+//   slienc [-j jobs] [infile] [outfile] [infile] [outfile] ...
 
-int main(int argc, const char **argv, const char **envp);
-void encode();
-void search(unsigned int a1, int a2, int *a3, unsigned int *a4);
-int mischarsearch(unsigned char *a1, int a2, unsigned char *a3, int a4);
-void initskip(unsigned char *a1, int a2);
-void writeshort(short a1);
-void writeint4(int a1);
-
-unsigned short skip[256]; // idb
-int cp; // weak
-int ndp; // weak
-FILE *fp; // idb
-unsigned char *def;
-unsigned short *pol;
-int pp; // weak
-int insize; // idb
-int ncp; // weak
-int npp; // weak
-unsigned char *bz;
-int dp; // idb
-unsigned int *cmd;
-
-int main(int argc, const char **argv, const char **envp)
+#define WINDOW_SIZE 4096
+#define MIN_MATCH   3
+#define MAX_MATCH   273
+#define HASH_BITS   13
+#define HASH_SIZE   (1 << HASH_BITS)
+
+typedef struct
 {
-    char src[999];
-	char dest[999];
+	const unsigned char *bz;
+	int insize;
 
+	unsigned int *cmd;
+	int cp;
+	unsigned short *pol;
+	int pp;
+	unsigned char *def;
+	int dp;
 
-	if (argc < 3)
-	{
-		fprintf(stderr, "slienc [infile] [outfile]\n");
-		return 1;
-	}
-	
-	strcpy(src, argv[1]);
-    strcpy(dest, argv[2]);
-	
-	if ((fp = fopen(src, "rb")) == NULL)
+	int *head; // most recent position of each hash of 3 bytes, or -1
+	int *prev; // previous position with the same hash, indexed by position % WINDOW_SIZE
+	int inserted; // every position before this has been inserted
+} Encoder;
+
+typedef struct
+{
+	const char *src;
+	const char *dest;
+} Job;
+
+static Job *jobs;
+static int numJobs;
+static int nextJob = 0;
+static int failed = 0;
+static pthread_mutex_t jobMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline unsigned int hash3(const unsigned char *p)
+{
+	unsigned int val = (p[0] << 16) | (p[1] << 8) | p[2];
+	return (val * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static void insert(Encoder *enc, int end)
+{
+	int last = end;
+
+	// only positions with a full 3 bytes after them can start a match
+	if (last > enc->insize - (MIN_MATCH - 1))
+		last = enc->insize - (MIN_MATCH - 1);
+
+	for (int pos = enc->inserted; pos < last; pos++)
 	{
-		fprintf(stderr, "FILE OPEN ERROR![%s]\n", src);
-		return 1;
+		unsigned int h = hash3(&enc->bz[pos]);
+		enc->prev[pos % WINDOW_SIZE] = enc->head[h];
+		enc->head[h] = pos;
 	}
-	
-	fseek(fp, 0, SEEK_END);
-	insize = ftell(fp);
-	fseek(fp, 0, SEEK_SET);
-	
-	bz = malloc(insize);
-	size_t fread_result = fread(bz, 1, insize, fp);
-	fclose(fp);
-	
-	for (int i = 0; src[i]; i++)
+
+	if (end > enc->inserted)
+		enc->inserted = end;
+}
+
+// Finds the longest match for the data at pos within the previous 4 KiB.
+// Matches may run past pos, which the decoder handles by copying one byte at a time.
+static void search(Encoder *enc, int pos, int *matchPos, int *matchLen)
+{
+	const unsigned char *bz = enc->bz;
+	int maxLen = enc->insize - pos;
+	int farthest = pos - WINDOW_SIZE;
+	int bestLen = 0;
+	int bestPos = 0;
+
+	*matchPos = 0;
+	*matchLen = 0;
+
+	insert(enc, pos);
+
+	if (maxLen > MAX_MATCH)
+		maxLen = MAX_MATCH;
+	if (maxLen < MIN_MATCH)
+		return;
+	if (farthest < 0)
+		farthest = 0;
+
+	for (int off = enc->head[hash3(&bz[pos])]; off >= farthest && off < pos; off = enc->prev[off % WINDOW_SIZE])
 	{
-		if (src[i] == '.')
+		int len;
+
+		// can't beat the best match unless the byte after it matches too
+		if (bz[off + bestLen] != bz[pos + bestLen])
+			continue;
+
+		for (len = 0; len < maxLen; len++)
 		{
-			src[i] = 0;
-			break;
+			if (bz[off + len] != bz[pos + len])
+				break;
+		}
+
+		if (len > bestLen)
+		{
+			bestLen = len;
+			bestPos = off;
+			if (bestLen == maxLen)
+				break;
 		}
 	}
-    
-	if ((fp = fopen(dest, "wb")) == NULL)
+
+	if (bestLen >= MIN_MATCH)
 	{
-		fprintf(stderr, "FILE CREATE ERROR![%s]\n", dest);
-		exit(1);
+		*matchPos = bestPos;
+		*matchLen = bestLen;
 	}
-	
-	encode();
-	
-	fprintf(fp, "Yay0");
-	
-	writeint4(insize);
-	
-	writeint4(4 * cp + 16);
-	writeint4(2 * pp + 4 * cp + 16);
-	
-	for (int i = 0; i < cp; i++)
-		writeint4(cmd[i]);
-	
-	for (int i = 0; i < pp; i++)
-		writeshort(pol[i]);
-	
-	fwrite(def, 1u, dp, fp);
-	fclose(fp);
-	
-	return 0;
 }
 
-void encode()
+static void encode(Encoder *enc)
 {
-	unsigned int v0; // esi
-	unsigned int v1; // edi
-	int v2; // edx
-	int v3; // ebx
-	int v4; // edx
-	char v5; // [esp+Ch] [ebp-18h]
-	unsigned int v6; // [esp+10h] [ebp-14h]
-	unsigned int v7; // [esp+14h] [ebp-10h]
-	int v8; // [esp+18h] [ebp-Ch]
-	unsigned int a4; // [esp+1Ch] [ebp-8h]
-	int a3; // [esp+20h] [ebp-4h]
-
-	dp = 0;
-	pp = 0;
-	cp = 0;
-	npp = 4096;
-	ndp = 4096;
-	ncp = 4096;
-	cmd = calloc(0x4000u, 1u);
-	pol = malloc(2 * npp);
-	def = malloc(4 * ndp);
-	v0 = 0;
-	v6 = 1024;
-	v1 = 2147483648;
-	while ( insize > v0 )
+	unsigned int bit = 0x80000000;
+	int pos = 0;
+
+	// allocate for the worst case, so nothing needs to grow
+	enc->cmd = calloc(enc->insize / 32 + 2, sizeof(*enc->cmd));
+	enc->pol = malloc((enc->insize / MIN_MATCH + 1) * sizeof(*enc->pol));
+	enc->def = malloc(enc->insize + 1);
+	enc->head = malloc(HASH_SIZE * sizeof(*enc->head));
+	enc->prev = malloc(WINDOW_SIZE * sizeof(*enc->prev));
+	enc->cp = 0;
+	enc->pp = 0;
+	enc->dp = 0;
+	enc->inserted = 0;
+
+	for (int i = 0; i < HASH_SIZE; i++)
+		enc->head[i] = -1;
+
+	while (pos < enc->insize)
 	{
-		if ( v6 < v0 )
-			v6 += 1024;
-		search(v0, insize, &a3, &a4);
-		if ( a4 <= 2 )
+		int matchPos, matchLen;
+
+		search(enc, pos, &matchPos, &matchLen);
+
+		if (matchLen <= 2)
 		{
-			cmd[cp] |= v1;
-			def[dp++] = bz[v0++];
-			if ( ndp == dp )
-			{
-				ndp = dp + 4096;
-				def = realloc(def, dp + 4096);
-			}
+			enc->cmd[enc->cp] |= bit;
+			enc->def[enc->dp++] = enc->bz[pos++];
 		}
 		else
 		{
-			search(v0 + 1, insize, &v8, &v7);
-			if ( v7 > a4 + 1 )
+			int nextPos, nextLen;
+			int offset;
+
+			// lazy matching: prefer a literal if the next byte starts a longer match
+			search(enc, pos + 1, &nextPos, &nextLen);
+			if (nextLen > matchLen + 1)
 			{
-				cmd[cp] |= v1;
-				def[dp++] = bz[v0++];
-				if ( ndp == dp )
-				{
-					ndp = dp + 4096;
-					def = realloc(def, dp + 4096);
-				}
-				v1 >>= 1;
-				if ( !v1 )
+				enc->cmd[enc->cp] |= bit;
+				enc->def[enc->dp++] = enc->bz[pos++];
+
+				bit >>= 1;
+				if (!bit)
 				{
-					v1 = 2147483648;
-					v2 = cp++;
-					if ( cp == ncp )
-					{
-						ncp = v2 + 1025;
-						cmd = realloc(cmd, 4 * (v2 + 1025));
-					}
-					cmd[cp] = 0;
+					bit = 0x80000000;
+					enc->cmd[++enc->cp] = 0;
 				}
-				a4 = v7;
-				a3 = v8;
+				matchLen = nextLen;
+				matchPos = nextPos;
 			}
-			v3 = v0 - a3 - 1;
-			a3 = v0 - a3 - 1;
-			v5 = a4;
-			if ( a4 > 0x11 )
+
+			offset = pos - matchPos - 1;
+			if (matchLen > 0x11)
 			{
-				pol[pp++] = v3;
-				def[dp++] = v5 - 18;
-				if ( ndp == dp )
-				{
-					ndp = dp + 4096;
-					def = realloc(def, dp + 4096);
-				}
+				enc->pol[enc->pp++] = offset;
+				enc->def[enc->dp++] = matchLen - 18;
 			}
 			else
 			{
-				pol[pp++] = v3 | (((short)a4 - 2) << 12);
+				enc->pol[enc->pp++] = offset | ((matchLen - 2) << 12);
 			}
-			if ( npp == pp )
-			{
-				npp = pp + 4096;
-				pol = realloc(pol, 2 * (pp + 4096));
-			}
-			v0 += a4;
+			pos += matchLen;
 		}
-		v1 >>= 1;
-		if ( !v1 )
+
+		bit >>= 1;
+		if (!bit)
 		{
-			v1 = 2147483648;
-			v4 = cp++;
-			if ( cp == ncp )
-			{
-				ncp = v4 + 1025;
-				cmd = realloc(cmd, 4 * (v4 + 1025));
-			}
-			cmd[cp] = 0;
+			bit = 0x80000000;
+			enc->cmd[++enc->cp] = 0;
 		}
 	}
-	if ( v1 != 0x80000000 )
-		++cp;
-	//fprintf(stderr, "IN=%d OUT=%d\n", insize, dp + 2 * pp + 4 * cp + 16);
+
+	if (bit != 0x80000000)
+		++enc->cp;
 }
 
-void search(unsigned int a1, int a2, int *a3, unsigned int *a4)
+static void writeshort(FILE *fp, unsigned short val)
 {
-	unsigned int v4; // ebx
-	unsigned int v5; // esi
-	unsigned int *v6; // edi
-	unsigned int v7; // [esp+Ch] [ebp-10h]
-	int v8; // [esp+14h] [ebp-8h]
-	unsigned int v9; // [esp+18h] [ebp-4h]
-
-	v4 = 3;
-	v5 = 0;
-	if ( a1 > 0x1000 )
-		v5 = a1 - 4096;
-	v9 = 273;
-	if ( a2 - a1 <= 0x111 )
-		v9 = a2 - a1;
-	if ( v9 > 2 )
-	{
-		while ( a1 > v5 )
-		{
-			v7 = mischarsearch(&bz[a1], v4, &bz[v5], v4 + a1 - v5);
-			if ( v7 >= a1 - v5 )
-				break;
-			for ( ; v9 > v4; ++v4 )
-			{
-				if ( bz[v4 + v5 + v7] != bz[v4 + a1] )
-					break;
-			}
-			if ( v9 == v4 )
-			{
-				*a3 = v7 + v5;
-				goto LABEL_17;
-			}
-			v8 = v5 + v7;
-			++v4;
-			v5 += v7 + 1;
-		}
-		*a3 = v8;
-		if ( v4 > 3 )
-		{
-			--v4;
-LABEL_17:
-			*a4 = v4;
-			return;
-		}
-		v6 = a4;
-	}
-	else
-	{
-		*a4 = 0;
-		v6 = a3;
-	}
-	*v6 = 0;
+	fputc((val & 0xff00) >> 8, fp);
+	fputc((val & 0x00ff) >> 0, fp);
 }
 
-int mischarsearch(unsigned char *pattern, int patternlen, unsigned char *data, int datalen)
+static void writeint4(FILE *fp, unsigned int val)
 {
-  int result; // eax
-  int i; // ebx
-  int v6; // eax
-  int j; // ecx
-
-  result = datalen;
-  if ( patternlen <= datalen )
-  {
-    initskip(pattern, patternlen);
-    for ( i = patternlen - 1; ; i += v6 )
-    {
-      if ( pattern[patternlen - 1] == data[i] )
-      {
-        --i;
-        j = patternlen - 2;
-        if ( patternlen - 2 < 0 )
-          return i + 1;
-        while ( pattern[j] == data[i] )
-        {
-          --i;
-          if ( --j < 0 )
-            return i + 1;
-        }
-        v6 = patternlen - j;
-        if ( skip[data[i]] > patternlen - j )
-          v6 = skip[data[i]];
-      }
-      else
-      {
-        v6 = skip[data[i]];
-      }
-    }
-  }
-  return result;
+	fputc((val & 0xff000000) >> 24, fp);
+	fputc((val & 0x00ff0000) >> 16, fp);
+	fputc((val & 0x0000ff00) >>  8, fp);
+	fputc((val & 0x000000ff) >>  0, fp);
 }
 
-void initskip(unsigned char *pattern, int len)
+static int compress_file(const char *src, const char *dest)
 {
-	for (int i = 0; i < 256; i++)
-		skip[i] = len;
-	
-	for (int i = 0; i < len; i++)
-		skip[pattern[i]] = len - i - 1;
+	Encoder enc;
+	unsigned char *bz;
+	FILE *fp;
+
+	if ((fp = fopen(src, "rb")) == NULL)
+	{
+		fprintf(stderr, "FILE OPEN ERROR![%s]\n", src);
+		return 1;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	enc.insize = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	bz = malloc(enc.insize + 1);
+	if (fread(bz, 1, enc.insize, fp) != (size_t) enc.insize)
+	{
+		fprintf(stderr, "FILE READ ERROR![%s]\n", src);
+		fclose(fp);
+		free(bz);
+		return 1;
+	}
+	fclose(fp);
+	enc.bz = bz;
+
+	if ((fp = fopen(dest, "wb")) == NULL)
+	{
+		fprintf(stderr, "FILE CREATE ERROR![%s]\n", dest);
+		free(bz);
+		return 1;
+	}
+
+	encode(&enc);
+
+	fprintf(fp, "Yay0");
+
+	writeint4(fp, enc.insize);
+
+	writeint4(fp, 4 * enc.cp + 16);
+	writeint4(fp, 2 * enc.pp + 4 * enc.cp + 16);
+
+	for (int i = 0; i < enc.cp; i++)
+		writeint4(fp, enc.cmd[i]);
+
+	for (int i = 0; i < enc.pp; i++)
+		writeshort(fp, enc.pol[i]);
+
+	fwrite(enc.def, 1u, enc.dp, fp);
+	fclose(fp);
+
+	free(enc.cmd);
+	free(enc.pol);
+	free(enc.def);
+	free(enc.head);
+	free(enc.prev);
+	free(bz);
+
+	return 0;
 }
 
-void writeshort(short val)
+static void *worker(void *arg)
 {
-	fputc((val & 0xff00) >> 8, fp);
-	fputc((val & 0x00ff) >> 0, fp);
+	(void) arg;
+
+	while (1)
+	{
+		int job;
+
+		pthread_mutex_lock(&jobMutex);
+		job = nextJob++;
+		pthread_mutex_unlock(&jobMutex);
+
+		if (job >= numJobs)
+			break;
+
+		if (compress_file(jobs[job].src, jobs[job].dest))
+		{
+			pthread_mutex_lock(&jobMutex);
+			failed = 1;
+			pthread_mutex_unlock(&jobMutex);
+		}
+	}
+
+	return NULL;
 }
 
-void writeint4(int val)
+int main(int argc, const char **argv)
 {
-	fputc((val & 0x00ff000000) >> 24, fp);
-	fputc((val & 0x0000ff0000) >> 16, fp);
-	fputc((val & 0x000000ff00) >>  8, fp);
-	fputc((val & 0x00000000ff) >>  0, fp);
+	pthread_t *threads;
+	int numThreads = 0;
+	int arg = 1;
+
+	if (argc > 2 && strcmp(argv[1], "-j") == 0)
+	{
+		numThreads = atoi(argv[2]);
+		arg = 3;
+	}
+
+	if (argc - arg < 2 || (argc - arg) % 2 != 0)
+	{
+		fprintf(stderr, "slienc [-j jobs] [infile] [outfile] ([infile] [outfile] ...)\n");
+		return 1;
+	}
+
+	numJobs = (argc - arg) / 2;
+	jobs = malloc(numJobs * sizeof(*jobs));
+	for (int i = 0; i < numJobs; i++)
+	{
+		jobs[i].src = argv[arg + i * 2];
+		jobs[i].dest = argv[arg + i * 2 + 1];
+	}
+
+	if (numThreads <= 0)
+		numThreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (numThreads > numJobs)
+		numThreads = numJobs;
+	if (numThreads <= 1)
+	{
+		worker(NULL);
+		return failed;
+	}
+
+	threads = malloc(numThreads * sizeof(*threads));
+	for (int i = 0; i < numThreads; i++)
+		pthread_create(&threads[i], NULL, worker, NULL);
+	for (int i = 0; i < numThreads; i++)
+		pthread_join(threads[i], NULL);
+
+	free(threads);
+	free(jobs);
+
+	return failed;
 }